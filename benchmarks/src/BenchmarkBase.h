@@ -8,11 +8,16 @@
 
 #include <algorithm>
 #include <cfloat>
+#include <chrono>
+#include <cmath>
 #include <ctime>
 #include <stdio.h>
 #include <iostream>
 #include <fstream>
 #include <random>
+#include <sstream>
+#include <string>
+#include <vector>
 
 #include "react/common/utility.h"
 
@@ -38,7 +43,7 @@ const std::vector<T> GetUniqueRandomNumbers(TGen gen, T from, T to, int count)
     data.resize(count);
     std::sort(data.begin(), data.end());
 
-    return std::move(data);
+    return data;
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
@@ -55,45 +60,162 @@ inline const std::string CurrentDateTime()
     return buf;
 }
 
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// Spin for the given number of milliseconds to simulate an expensive node update.
+///////////////////////////////////////////////////////////////////////////////////////////////////
+inline void BusyWait(int milliseconds)
+{
+    auto t0 = std::chrono::high_resolution_clock::now();
+    while (std::chrono::high_resolution_clock::now() - t0 < std::chrono::milliseconds(milliseconds));
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/// BenchmarkResult
+/// The duration of each run of a benchmark configuration in seconds, or another value that the
+/// benchmark recorded for each run.
+///////////////////////////////////////////////////////////////////////////////////////////////////
+struct BenchmarkResult
+{
+    std::string         name;
+    std::string         params;
+    std::vector<double> samples;
+
+    // Empty for the duration. Otherwise the name given to RecordBenchmarkMetric.
+    std::string         metric;
+    bool                isLowerBetter = true;
+
+    std::string GetMetricName() const
+        { return metric.empty() ? "seconds" : metric; }
+
+    double GetMean() const
+    {
+        double sum = 0;
+        for (double x : samples)
+            sum += x;
+        return samples.empty() ? 0.0 : sum / samples.size();
+    }
+
+    // Sample standard deviation
+    double GetStdDev() const
+    {
+        if (samples.size() < 2)
+            return 0.0;
+
+        double mean = GetMean();
+        double sum = 0;
+        for (double x : samples)
+            sum += (x - mean) * (x - mean);
+        return std::sqrt(sum / (samples.size() - 1));
+    }
+
+    double GetMin() const
+        { return samples.empty() ? 0.0 : *std::min_element(samples.begin(), samples.end()); }
+
+    double GetMax() const
+        { return samples.empty() ? 0.0 : *std::max_element(samples.begin(), samples.end()); }
+
+    // Percentile p in [0, 100], linearly interpolated between the closest ranks.
+    double GetPercentile(double p) const
+    {
+        if (samples.empty())
+            return 0.0;
+
+        std::vector<double> sorted = samples;
+        std::sort(sorted.begin(), sorted.end());
+
+        double rank = (p / 100.0) * (sorted.size() - 1);
+        size_t lo = static_cast<size_t>(rank);
+        size_t hi = (std::min)(lo + 1, sorted.size() - 1);
+
+        return sorted[lo] + (rank - lo) * (sorted[hi] - sorted[lo]);
+    }
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// Results of all benchmarks run so far by this process.
+///////////////////////////////////////////////////////////////////////////////////////////////////
+inline std::vector<BenchmarkResult>& GetBenchmarkResults()
+{
+    static std::vector<BenchmarkResult> results;
+    return results;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// Additional values recorded by the current run of a benchmark.
+///////////////////////////////////////////////////////////////////////////////////////////////////
+struct BenchmarkMetricValue
+{
+    std::string name;
+    double      value;
+    bool        isLowerBetter;
+};
+
+inline std::vector<BenchmarkMetricValue>& GetRecordedMetrics()
+{
+    static std::vector<BenchmarkMetricValue> metrics;
+    return metrics;
+}
+
+// Records a value for the current run in addition to the duration, e.g. a latency percentile.
+// It is written and compared with a baseline like the duration, under its own name.
+inline void RecordBenchmarkMetric(const std::string& name, double value, bool isLowerBetter = true)
+    { GetRecordedMetrics().push_back(BenchmarkMetricValue{ name, value, isLowerBetter }); }
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 /// RunBenchmark
+/// Returns the durations, followed by the recorded metrics.
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 template
 <
-    int RUN_COUNT,
     typename TBenchmark,
     typename TParams
 >
-void RunBenchmark(std::ostream& logfile, TBenchmark b, const TParams& params)
+std::vector<BenchmarkResult> RunBenchmark(std::ostream& logfile, TBenchmark b, const TParams& params, int runCount)
 {
-    double sum = 0;
-    double min = DBL_MAX;
-    double max = DBL_MIN;
+    std::vector<BenchmarkResult> results(1);
 
-    for (int i=1; i<=RUN_COUNT; i++)
+    GetRecordedMetrics().clear();
+
+    for (int i=1; i<=runCount; i++)
     {
         double r = b.Run(params);
         std::cout    << "\tRun " << i << ": " <<  r << std::endl;
         logfile       << "\tRun " << i << ": " <<  r << std::endl;
-        
-        sum += r;
 
-        if (r > max)
-            max = r;
-        if (r < min)
-            min = r;
+        results.front().samples.push_back(r);
+
+        for (const BenchmarkMetricValue& m : GetRecordedMetrics())
+        {
+            auto it = std::find_if(results.begin() + 1, results.end(),
+                [&] (const BenchmarkResult& x) { return x.metric == m.name; });
+
+            if (it == results.end())
+            {
+                BenchmarkResult metricResult;
+                metricResult.metric = m.name;
+                metricResult.isLowerBetter = m.isLowerBetter;
+                it = results.insert(results.end(), std::move(metricResult));
+            }
+
+            it->samples.push_back(m.value);
+        }
+
+        GetRecordedMetrics().clear();
     }
-    double avg = sum / RUN_COUNT;
 
-    std::cout << std::endl;
-    std::cout << "\tAverage: " << avg << std::endl;
-    std::cout << "\tMin: " << min << std::endl;
-    std::cout << "\tMax: " << max << std::endl << std::endl;
+    const BenchmarkResult& result = results.front();
 
-    logfile    << std::endl;
-    logfile    << "\tAverage: " << avg << std::endl;
-    logfile << "\tMin: " << min << std::endl;
-    logfile << "\tMax: " << max << std::endl << std::endl;
+    for (std::ostream* out : { static_cast<std::ostream*>(&std::cout), static_cast<std::ostream*>(&logfile) })
+    {
+        *out << std::endl;
+        *out << "\tAverage: " << result.GetMean() << std::endl;
+        *out << "\tMedian: " << result.GetPercentile(50) << std::endl;
+        *out << "\tStdDev: " << result.GetStdDev() << std::endl;
+        *out << "\tMin: " << result.GetMin() << std::endl;
+        *out << "\tMax: " << result.GetMax() << std::endl << std::endl;
+    }
+
+    return results;
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
@@ -101,22 +223,25 @@ void RunBenchmark(std::ostream& logfile, TBenchmark b, const TParams& params)
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 template
 <
-    int RUN_COUNT,
     typename TBenchmark,
     typename TParams
 >
-void RunBenchmarkClass(const char* name, std::ostream& out, const TParams& params)
+void RunBenchmarkClass(const char* name, std::ostream& out, const TParams& params, int runCount)
 {
-    std::cout    << "===== " << name << " (";
-    params.Print(std::cout);
-    std::cout    << ") =====" << std::endl << std::endl;
+    std::ostringstream paramStream;
+    params.Print(paramStream);
 
-    out    << "===== " << name << " (";
-    params.Print(out);
-    out    << ") =====" << std::endl << std::endl;
+    std::cout    << "===== " << name << " (" << paramStream.str() << ") =====" << std::endl << std::endl;
+    out          << "===== " << name << " (" << paramStream.str() << ") =====" << std::endl << std::endl;
 
-    RunBenchmark<RUN_COUNT>(out, TBenchmark(), params);
+    for (BenchmarkResult& result : RunBenchmark(out, TBenchmark(), params, runCount))
+    {
+        result.name = name;
+        result.params = paramStream.str();
+
+        GetBenchmarkResults().push_back(std::move(result));
+    }
 }
 
 #define RUN_BENCHMARK(out, runCount, benchmarkClass, params) \
-    RunBenchmarkClass<runCount, benchmarkClass, decltype(params)>(#benchmarkClass, out, params)
+    RunBenchmarkClass<benchmarkClass>(#benchmarkClass, out, params, runCount)
@@ -0,0 +1,85 @@
+//          Copyright Sebastian Jeckel 2017.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#ifndef CPP_REACT_BENCHMARK_EVENTVALUELIST_H
+#define CPP_REACT_BENCHMARK_EVENTVALUELIST_H
+
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+#include "BenchmarkBase.h"
+
+#include "react/api.h"
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/// Benchmark_EventValueList
+/// Each of the K turns appends N events to a list. With Reuse, the list is cleared after each
+/// turn and keeps its capacity, as event nodes do. Otherwise a new list is grown every turn.
+///////////////////////////////////////////////////////////////////////////////////////////////////
+struct BenchmarkParams_EventValueList
+{
+    BenchmarkParams_EventValueList(int n, int k, bool reuse) :
+        N(n),
+        K(k),
+        Reuse(reuse)
+    {}
+
+    void Print(std::ostream& out) const
+    {
+        out << "N = " << N
+            << ", K = " << K
+            << ", Reuse = " << Reuse;
+    }
+
+    const int   N;
+    const int   K;
+    const bool  Reuse;
+};
+
+struct Benchmark_EventValueList
+{
+    double Run(const BenchmarkParams_EventValueList& params)
+    {
+        using namespace react;
+
+        EventValueList<int> reused;
+        size_t sum = 0;
+
+        auto t0 = std::chrono::high_resolution_clock::now();
+
+        for (int k=0; k<params.K; k++)
+        {
+            if (params.Reuse)
+            {
+                for (int i=0; i<params.N; i++)
+                    reused.push_back(i);
+
+                sum += reused.size();
+                reused.clear();
+            }
+            else
+            {
+                EventValueList<int> events;
+
+                for (int i=0; i<params.N; i++)
+                    events.push_back(i);
+
+                sum += events.size();
+            }
+        }
+
+        auto t1 = std::chrono::high_resolution_clock::now();
+
+        if (sum != static_cast<size_t>(params.N) * params.K)
+            std::cout << "\tUnexpected event count: " << sum << std::endl;
+
+        return std::chrono::duration<double>(t1 - t0).count();
+    }
+};
+
+#endif // CPP_REACT_BENCHMARK_EVENTVALUELIST_H
@@ -1,4 +1,3 @@
-
 //          Copyright Sebastian Jeckel 2017.
 // Distributed under the Boost Software License, Version 1.0.
 //    (See accompanying file LICENSE_1_0.txt or copy at
@@ -6,60 +5,57 @@
 
 #pragma once
 
-#if 0
-
-#ifndef REACT_BENCHMARK_GRID_H
-#define REACT_BENCHMARK_GRID_H
+#ifndef CPP_REACT_BENCHMARK_GRID_H
+#define CPP_REACT_BENCHMARK_GRID_H
 
+#include <cassert>
+#include <chrono>
 #include <functional>
 #include <iostream>
 #include <vector>
 
-#include "tbb/tick_count.h"
-
 #include "BenchmarkBase.h"
 
+#include "react/group.h"
 #include "react/state.h"
 
-using namespace react;
-
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 /// GridGraphGenerator
+/// Starting from the input states, adds layers of nodes that grow or shrink by one node each
+/// until every width in widths has been reached. Each node depends on its one or two neighbours
+/// in the previous layer.
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 template <typename T>
 class GridGraphGenerator
 {
 public:
-    using SignalType = Signal<T, shared>;
+    using StateType = react::State<T>;
 
     using Func1T = std::function<T(T)>;
     using Func2T = std::function<T(T, T)>;
 
-    using SignalVectType = std::vector<SignalType>;
+    using StateVectType = std::vector<StateType>;
 
-    SignalVectType inputSignals;
-    SignalVectType outputSignals;
+    StateVectType inputStates;
+    StateVectType outputStates;
 
     Func1T  function1;
     Func2T  function2;
 
     std::vector<size_t>  widths;
 
-    void Generate(const GroupBase& group)
+    void Generate(const react::Group& group)
     {
-        assert(inputSignals.size() >= 1);
+        assert(inputStates.size() >= 1);
         assert(widths.size() >= 1);
 
-        SignalVectType buf1 = std::move(inputSignals);
-        SignalVectType buf2;
+        StateVectType buf1 = std::move(inputStates);
+        StateVectType buf2;
 
-        SignalVectType* curBuf = &buf1;
-        SignalVectType* nextBuf = &buf2;
+        StateVectType* curBuf = &buf1;
+        StateVectType* nextBuf = &buf2;
 
-        size_t curWidth = inputSignals.size();
-
-        size_t nodeCount = 1;
-        nodeCount += curWidth;
+        size_t curWidth = buf1.size();
 
         for (auto targetWidth : widths)
         {
@@ -74,30 +70,21 @@ public:
                     ++r;
 
                 if (shouldGrow)
-                {
-										auto s = SignalType{ group, function1, *l };
-                    nextBuf->push_back(std::move(s));
-                }
+                    nextBuf->push_back(StateType::Create(group, function1, *l));
 
                 while (r != curBuf->end())
                 {
-										auto s = SignalType{ group, function2, *l, *r };
-                    nextBuf->push_back(std::move(s));
-                    ++nodeCount;
+                    nextBuf->push_back(StateType::Create(group, function2, *l, *r));
                     ++l; ++r;
                 }
 
                 if (shouldGrow)
-                {
-                    auto s = SignalType{ group, function1, *l };
-                    nextBuf->push_back(std::move(s));
-                    ++nodeCount;
-                }
+                    nextBuf->push_back(StateType::Create(group, function1, *l));
 
                 curBuf->clear();
 
                 // Swap buffer pointers
-                SignalVectType* t = curBuf;
+                StateVectType* t = curBuf;
                 curBuf = nextBuf;
                 nextBuf = t;
 
@@ -108,15 +95,15 @@ public:
             }
         }
 
-        //printf ("NODE COUNT %d\n", nodeCount);
-
-        outputSignals.clear();
-        outputSignals.insert(outputSignals.begin(), curBuf->begin(), curBuf->end());
+        outputStates.clear();
+        outputStates.insert(outputStates.begin(), curBuf->begin(), curBuf->end());
     }
 };
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 /// Benchmark_Grid
+/// A single input fans out to a layer of width N and back to a single node. Each of the K
+/// iterations sets the input, which updates every node of the grid.
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 struct BenchmarkParams_Grid
 {
@@ -137,14 +124,17 @@ struct BenchmarkParams_Grid
 
 struct Benchmark_Grid
 {
-    double Run(const BenchmarkParams_Grid& params, const GroupBase& group)
+    double Run(const BenchmarkParams_Grid& params)
     {
-        VarSignal<int, shared> in{ group, 1 };
-				Signal<int, shared> in2 = in;
+        using namespace react;
+
+        Group group;
+
+        auto in = StateVar<int>::Create(group, 1);
 
         GridGraphGenerator<int> generator;
 
-        generator.inputSignals.push_back(in2);
+        generator.inputStates.push_back(in);
 
         generator.widths.push_back(params.N);
         generator.widths.push_back(1);
@@ -154,18 +144,15 @@ struct Benchmark_Grid
 
         generator.Generate(group);
 
-        auto t0 = tbb::tick_count::now();
+        auto t0 = std::chrono::high_resolution_clock::now();
+
         for (int i=0; i<params.K; i++)
-            in <<= 10+i;
-        auto t1 = tbb::tick_count::now();
+            in.Set(10+i);
 
-        double d = (t1 - t0).seconds();
-        //printf("Time %g\n", d);
+        auto t1 = std::chrono::high_resolution_clock::now();
 
-        return d;
+        return std::chrono::duration<double>(t1 - t0).count();
     }
 };
 
-#endif // REACT_BENCHMARK_GRID_H
-
-#endif
\ No newline at end of file
+#endif // CPP_REACT_BENCHMARK_GRID_H
@@ -0,0 +1,272 @@
+//          Copyright Sebastian Jeckel 2017.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#ifndef CPP_REACT_BENCHMARK_LATENCY_H
+#define CPP_REACT_BENCHMARK_LATENCY_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "BenchmarkBase.h"
+
+#include "react/event.h"
+#include "react/group.h"
+#include "react/observer.h"
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/// LatencyHistogram
+/// Log-linear histogram in the style of HdrHistogram. Each power of two is split into 64
+/// linear sub-buckets, so recorded values keep a relative precision of about 1.5% over the
+/// full range of uint64_t, at a fixed size of a few thousand counters.
+///////////////////////////////////////////////////////////////////////////////////////////////////
+class LatencyHistogram
+{
+public:
+    LatencyHistogram() :
+        counts_( sub_bucket_count + (64 - sub_bucket_bits + 1) * half_count, 0 )
+    { }
+
+    void Record(uint64_t value)
+    {
+        ++counts_[GetIndex(value)];
+        ++totalCount_;
+        sum_ += value;
+        maxValue_ = (std::max)(maxValue_, value);
+    }
+
+    void Merge(const LatencyHistogram& other)
+    {
+        for (size_t i = 0; i < counts_.size(); ++i)
+            counts_[i] += other.counts_[i];
+
+        totalCount_ += other.totalCount_;
+        sum_ += other.sum_;
+        maxValue_ = (std::max)(maxValue_, other.maxValue_);
+    }
+
+    uint64_t GetCount() const
+        { return totalCount_; }
+
+    uint64_t GetMax() const
+        { return maxValue_; }
+
+    double GetMean() const
+        { return totalCount_ > 0 ? static_cast<double>(sum_) / static_cast<double>(totalCount_) : 0.0; }
+
+    // The highest value that is equivalent to the value at percentile p in [0, 100].
+    uint64_t GetPercentile(double p) const
+    {
+        if (totalCount_ == 0)
+            return 0;
+
+        uint64_t target = static_cast<uint64_t>(p / 100.0 * static_cast<double>(totalCount_) + 0.5);
+        target = (std::max)(target, uint64_t{ 1 });
+
+        uint64_t cumulative = 0;
+
+        for (size_t i = 0; i < counts_.size(); ++i)
+        {
+            cumulative += counts_[i];
+            if (cumulative >= target)
+                return (std::min)(GetHighestEquivalentValue(i), maxValue_);
+        }
+
+        return maxValue_;
+    }
+
+private:
+    static const int        sub_bucket_bits     = 7;
+    static const uint64_t   sub_bucket_count    = uint64_t{ 1 } << sub_bucket_bits;
+    static const uint64_t   half_count          = sub_bucket_count / 2;
+
+    static int GetHighestBit(uint64_t value)
+    {
+        int bit = 0;
+        while (value >>= 1)
+            ++bit;
+        return bit;
+    }
+
+    // Values below sub_bucket_count are stored exactly. Above, each power of two has
+    // half_count buckets, because the highest bit of the sub-bucket is always set.
+    static size_t GetIndex(uint64_t value)
+    {
+        if (value < sub_bucket_count)
+            return static_cast<size_t>(value);
+
+        int shift = GetHighestBit(value) - (sub_bucket_bits - 1);
+        uint64_t sub = value >> shift;
+
+        return static_cast<size_t>(sub_bucket_count + (shift - 1) * half_count + (sub - half_count));
+    }
+
+    static uint64_t GetHighestEquivalentValue(size_t index)
+    {
+        if (index < sub_bucket_count)
+            return index;
+
+        uint64_t k = index - sub_bucket_count;
+        int shift = static_cast<int>(k / half_count) + 1;
+        uint64_t sub = half_count + k % half_count;
+
+        return ((sub + 1) << shift) - 1;
+    }
+
+    std::vector<uint64_t>   counts_;
+
+    uint64_t    totalCount_ = 0;
+    uint64_t    sum_        = 0;
+    uint64_t    maxValue_   = 0;
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/// Benchmark_Latency
+/// Measures the end-to-end latency of Group::EnqueueTransaction, from the call through the
+/// transaction queue, propagation and optionally link forwarding to a second group, until the
+/// observer of the result is invoked.
+///
+/// P producer threads enqueue K transactions each. With a rate R > 0, each producer sends at R
+/// transactions per second on a fixed schedule, so a slow consumer doesn't slow down the load.
+/// With R = 0, producers send as fast as they can.
+///
+/// The result of each run is the 99th percentile in seconds. The full distribution is printed
+/// per run.
+///////////////////////////////////////////////////////////////////////////////////////////////////
+struct BenchmarkParams_Latency
+{
+    BenchmarkParams_Latency(int p, int r, int k, bool merging, bool linked) :
+        P(p),
+        R(r),
+        K(k),
+        Merging(merging),
+        Linked(linked)
+    {}
+
+    void Print(std::ostream& out) const
+    {
+        out << "P = " << P
+            << ", R = " << R
+            << ", K = " << K
+            << ", Merging = " << Merging
+            << ", Linked = " << Linked;
+    }
+
+    const int   P;
+    const int   R;
+    const int   K;
+    const bool  Merging;
+    const bool  Linked;
+};
+
+struct Benchmark_Latency
+{
+    double Run(const BenchmarkParams_Latency& params)
+    {
+        using namespace react;
+        using ClockT = std::chrono::steady_clock;
+
+        auto getTime = []
+            {
+                return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    ClockT::now().time_since_epoch()).count());
+            };
+
+        Group group1;
+        Group group2;
+
+        auto src = EventSource<uint64_t>::Create(group1);
+
+        Event<uint64_t> target = src;
+        if (params.Linked)
+            target = EventLink<uint64_t>::Create(group2, src);
+
+        // Only the propagating thread of the target group writes the histogram.
+        LatencyHistogram histogram;
+        std::atomic<uint64_t> receivedCount{ 0 };
+
+        auto obs = Observer::Create([&] (const auto& events)
+            {
+                uint64_t now = getTime();
+
+                for (uint64_t sendTime : events)
+                    histogram.Record(now - sendTime);
+
+                receivedCount.fetch_add(events.size(), std::memory_order_release);
+            }, target);
+
+        TransactionFlags flags = params.Merging ? TransactionFlags::allow_merging : TransactionFlags::none;
+
+        std::atomic<uint64_t> rejectedCount{ 0 };
+
+        std::vector<std::thread> producers;
+        producers.reserve(params.P);
+
+        auto t0 = ClockT::now();
+
+        for (int p = 0; p < params.P; ++p)
+        {
+            producers.emplace_back([&, t0]
+                {
+                    auto period = params.R > 0 ? std::chrono::nanoseconds(1000000000LL / params.R) : std::chrono::nanoseconds(0);
+
+                    for (int i = 0; i < params.K; ++i)
+                    {
+                        if (params.R > 0)
+                            std::this_thread::sleep_until(t0 + i * period);
+
+                        uint64_t sendTime = getTime();
+
+                        bool isEnqueued = group1.EnqueueTransaction([src, sendTime] () mutable
+                            {
+                                src.Emit(sendTime);
+                            }, flags);
+
+                        if (!isEnqueued)
+                            rejectedCount.fetch_add(1, std::memory_order_relaxed);
+                    }
+                });
+        }
+
+        for (auto& t : producers)
+            t.join();
+
+        uint64_t expectedCount = static_cast<uint64_t>(params.P) * params.K - rejectedCount.load();
+
+        while (receivedCount.load(std::memory_order_acquire) < expectedCount)
+            std::this_thread::yield();
+
+        auto t1 = ClockT::now();
+
+        double duration = std::chrono::duration<double>(t1 - t0).count();
+
+        auto toMicroseconds = [] (uint64_t ns)
+            { return static_cast<double>(ns) / 1000.0; };
+
+        std::cout << "\t\tp50 = "   << toMicroseconds(histogram.GetPercentile(50.0)) << " us"
+                  << ", p99 = "     << toMicroseconds(histogram.GetPercentile(99.0)) << " us"
+                  << ", p99.9 = "   << toMicroseconds(histogram.GetPercentile(99.9)) << " us"
+                  << ", max = "     << toMicroseconds(histogram.GetMax()) << " us"
+                  << ", mean = "    << histogram.GetMean() / 1000.0 << " us"
+                  << ", throughput = " << static_cast<double>(expectedCount) / duration << " tx/s"
+                  << std::endl;
+
+        RecordBenchmarkMetric("p50_us", toMicroseconds(histogram.GetPercentile(50.0)));
+        RecordBenchmarkMetric("p99.9_us", toMicroseconds(histogram.GetPercentile(99.9)));
+        RecordBenchmarkMetric("max_us", toMicroseconds(histogram.GetMax()));
+        RecordBenchmarkMetric("mean_us", histogram.GetMean() / 1000.0);
+        RecordBenchmarkMetric("throughput_tx_per_s", static_cast<double>(expectedCount) / duration, false);
+
+        return static_cast<double>(histogram.GetPercentile(99.0)) / 1e9;
+    }
+};
+
+#endif // CPP_REACT_BENCHMARK_LATENCY_H
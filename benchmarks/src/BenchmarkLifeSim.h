@@ -1,102 +1,97 @@
-
 //          Copyright Sebastian Jeckel 2017.
 // Distributed under the Boost Software License, Version 1.0.
 //    (See accompanying file LICENSE_1_0.txt or copy at
 //          http://www.boost.org/LICENSE_1_0.txt)
 
 #pragma once
-/*
+
+#ifndef CPP_REACT_BENCHMARK_LIFESIM_H
+#define CPP_REACT_BENCHMARK_LIFESIM_H
+
+#include <cassert>
+#include <chrono>
+#include <cstdlib>
 #include <iostream>
-#include <fstream>
 #include <memory>
 #include <random>
-#include <utility>
-#include <string>
-#include <type_traits>
 #include <tuple>
+#include <utility>
 #include <vector>
 
 #include "BenchmarkBase.h"
 
-#include "react/Domain.h"
-#include "react/Signal.h"
-#include "react/Event.h"
-#include "react/logging/EventLog.h"
+#include "react/algorithm.h"
+#include "react/event.h"
+#include "react/group.h"
+#include "react/observer.h"
+#include "react/state.h"
 
-using namespace react;
+namespace lifesim {
 
-using std::cout;
-using std::string;
-using std::unique_ptr;
-using std::vector;
+using namespace react;
 
-// FIXME: GCC doesn't like enum class in MakeEventSource
-enum    { summer,  winter };
-enum    { enter,  leave };
+enum { summer, winter };
+enum { enter, leave };
 
-template <typename T>
-struct Incrementer { T operator()(Token,T v) const { return v+1; } };
+using PositionT = std::pair<int, int>;
+using BoundsT = std::tuple<int, int, int, int>;
 
-using PositionT = std::pair<int,int>;
-using BoundsT = std::tuple<int,int,int,int>;
+struct Incrementer
+{
+    template <typename TEvents>
+    int operator()(const TEvents& events, int v) const
+        { return v + static_cast<int>(events.size()); }
+};
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 /// Time
 ///////////////////////////////////////////////////////////////////////////////////////////////////
-template <typename D>
 class Time
 {
 public:
-    USING_REACTIVE_DOMAIN(D)
-
-    EventSourceT<>      NewDay      = MakeEventSource<D>();
-
-    SignalT<int>        TotalDays   = Iterate(NewDay, 0, Incrementer<int>());
-    SignalT<int>        DayOfYear   = TotalDays % 365;
-
-    SignalT<int> Season = MakeSignal(
-        DayOfYear,
-        [] (int day) -> int {
-            return day < 180 ? winter : summer;
-        });
+    explicit Time(const Group& group) :
+        NewDay( EventSource<>::Create(group) ),
+        TotalDays( Iterate<int>(0, Incrementer{ }, NewDay) ),
+        DayOfYear( State<int>::Create([] (int day) { return day % 365; }, TotalDays) ),
+        Season( State<int>::Create([] (int day) { return day < 180 ? winter : summer; }, DayOfYear) )
+    { }
+
+    EventSource<>   NewDay;
+
+    State<int>      TotalDays;
+    State<int>      DayOfYear;
+    State<int>      Season;
 };
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 /// Region
 ///////////////////////////////////////////////////////////////////////////////////////////////////
-template <typename D>
 class Region
 {
-    Time<D>& theTime;
-
 public:
-    USING_REACTIVE_DOMAIN(D)
-
-    BoundsT Bounds;
-
-    EventSourceT<int>    EnterOrLeave = MakeEventSource<D,int>();
-
-    SignalT<int> AnimalCount = Iterate(
-        EnterOrLeave,
-        0,
-        [] (int m, int count) {
-            return m == enter ? count + 1 : count - 1;
-        });
-
-    SignalT<int> FoodPerDay = MakeSignal(
-        theTime.Season,
-        calculateFoodPerDay);
-
-    SignalT<int> FoodOutputPerDay = MakeSignal(
-        With(FoodPerDay,AnimalCount),
-        calculateFoodOutputPerDay);
-
-    EventsT<int> FoodOutput = Pulse(theTime.NewDay, FoodOutputPerDay);
-
-    Region(Time<D>& time, int x, int y) :
-        theTime( time ),
-        Bounds( x*10, x*10+9, y*10, y*10+9 )
-    {}
+    Region(const Group& group, Time& time, int x, int y) :
+        Bounds( x*10, x*10+9, y*10, y*10+9 ),
+        EnterOrLeave( EventSource<int>::Create(group) ),
+        AnimalCount( Iterate<int>(0, [] (const auto& events, int count)
+            {
+                for (int e : events)
+                    count += e == enter ? 1 : -1;
+                return count;
+            }, EnterOrLeave) ),
+        FoodPerDay( State<int>::Create(CalculateFoodPerDay, time.Season) ),
+        FoodOutputPerDay( State<int>::Create(CalculateFoodOutputPerDay, FoodPerDay, AnimalCount) ),
+        FoodOutput( Pulse(FoodOutputPerDay, time.NewDay) )
+    { }
+
+    BoundsT             Bounds;
+
+    EventSource<int>    EnterOrLeave;
+
+    State<int>          AnimalCount;
+    State<int>          FoodPerDay;
+    State<int>          FoodOutputPerDay;
+
+    Event<int>          FoodOutput;
 
     PositionT Center() const
     {
@@ -109,10 +104,10 @@ public:
     {
         using std::get;
 
-        pos.first  = get<0>(Bounds) + (abs(pos.first) % 10);
-        pos.second = get<2>(Bounds) + (abs(pos.second) % 10);
+        pos.first  = get<0>(Bounds) + (std::abs(pos.first) % 10);
+        pos.second = get<2>(Bounds) + (std::abs(pos.second) % 10);
 
-        return  pos;
+        return pos;
     }
 
     bool IsInRegion(PositionT pos) const
@@ -124,38 +119,30 @@ public:
     }
 
 private:
-    static int calculateFoodPerDay(int season)
-    {
-        return season == summer ? 20 : 10;
-    }
-
-    static int calculateFoodOutputPerDay(int food, int count)
-    {
-        return count > 0 ? food/count : 0;
-    }
+    static int CalculateFoodPerDay(int season)
+        { return season == summer ? 20 : 10; }
 
+    static int CalculateFoodOutputPerDay(int food, int count)
+        { return count > 0 ? food/count : 0; }
 };
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 /// World
 ///////////////////////////////////////////////////////////////////////////////////////////////////
-template <typename D>
 class World
 {
 public:
-    USING_REACTIVE_DOMAIN(D)
-
-    vector<unique_ptr<Region<D>>>   Regions;
-
-    World(Time<D>& time, int w) :
+    World(const Group& group, Time& time, int w) :
         w_( w )
     {
         for (int x=0; x<w; x++)
             for (int y=0; y<w; y++)
-                Regions.push_back(unique_ptr<Region<D>>(new Region<D>(time, x, y)));
+                Regions.push_back(std::make_unique<Region>(group, time, x, y));
     }
 
-    Region<D>* GetRegion(PositionT pos)
+    std::vector<std::unique_ptr<Region>> Regions;
+
+    Region* GetRegion(PositionT pos)
     {
         for (auto& r : Regions)
         {
@@ -163,17 +150,16 @@ public:
                 return r.get();
         }
 
-        //printf("Out of bounds %d %d\n", pos.first, pos.second);
         assert(false);
         return nullptr;
     }
 
     PositionT Clamp(PositionT pos) const
     {
-        pos.first = abs(pos.first) % 10*w_;
-        pos.second = abs(pos.second) % 10*w_;
+        pos.first = std::abs(pos.first) % (10*w_);
+        pos.second = std::abs(pos.second) % (10*w_);
 
-        return  pos;
+        return pos;
     }
 
 private:
@@ -182,91 +168,124 @@ private:
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 /// Animal
+/// Wanders around its region and migrates once it receives too little food.
+/// The food source is a slot that follows the current region. Observers can't modify the graph
+/// from inside a turn, so a region change is only recorded by the observer and applied in a
+/// separate transaction by ApplyMigration.
 ///////////////////////////////////////////////////////////////////////////////////////////////////
-template <typename D>
 class Animal
 {
-    Time<D>&    theTime;
-    World<D>&   theWorld;
-
-    std::mt19937 generator;
-
 public:
-    USING_REACTIVE_DOMAIN(D)
-
-    VarSignalT<Region<D>*>  CurrentRegion;
-
-    EventsT<int>        FoodReceived    = REACTIVE_PTR(CurrentRegion, FoodOutput);
-    SignalT<bool>       ShouldMigrate   = Hold(FoodReceived, 0) < 10;
-    EventsT<bool>       Moving          = Pulse(theTime.NewDay, ShouldMigrate);
-
-    SignalT<PositionT>  Position;
-    SignalT<Region<D>*> NewRegion;
-
-    EventsT<Region<D>*> RegionChanged   = Monitor(NewRegion);
-
-    SignalT<int>        Age             = Iterate(theTime.NewDay, 0, Incrementer<int>());
-    SignalT<int>        Health          = Iterate(FoodReceived, 100, calculateHealth);
-
-    Animal(Time<D>& time, World<D>& world, Region<D>* initRegion, unsigned seed) :
-        theTime( time ),
-        theWorld( world ),
-        generator( seed ),
-        CurrentRegion( MakeVar<D>(initRegion) ),
-        Position
-        (
-            Iterate(Moving, initRegion->Center(), With(CurrentRegion),
-                [this] (bool moving, PositionT position, Region<D>* region) {
-                    std::uniform_int_distribution<int> dist(-1,1);
-
+    Animal(const Group& group, Time& time, World& world, Region* initRegion, unsigned seed) :
+        theWorld_( world ),
+        generator_( seed ),
+        currentRegion_( initRegion ),
+        CurrentRegion( StateVar<Region*>::Create(group, initRegion) ),
+        FoodReceived( EventSlot<int>::Create(group) ),
+        ShouldMigrate( State<bool>::Create([] (int food) { return food < 10; }, Hold(0, FoodReceived)) ),
+        Moving( Pulse(ShouldMigrate, time.NewDay) ),
+        Position( Iterate<PositionT>(initRegion->Center(), [this] (const auto& events, PositionT position, Region* region)
+            {
+                std::uniform_int_distribution<int> dist(-1,1);
+
+                for (bool moving : events)
+                {
                     // Wander randomly
                     for (int i=0; i<100; i++)
                     {
-                        position.first  += dist(generator);
-                        position.second += dist(generator);
+                        position.first  += dist(generator_);
+                        position.second += dist(generator_);
                     }
 
                     // Should migrate?
                     if (moving)
-                        return theWorld.Clamp(position);
+                        position = theWorld_.Clamp(position);
                     else
-                        return region->Clamp(position);
-                })
-        ),
-        NewRegion
-        (
-            MakeSignal(Position, 
-                [this] (PositionT pos) {
-                    return theWorld.GetRegion(pos);
-                })
-        ),
-        regionChangeContinuation_
-        (
-            MakeContinuation(RegionChanged, With(CurrentRegion),
-                [this] (Region<D>* newRegion, Region<D>* oldRegion) {
-                    oldRegion->EnterOrLeave(leave);
-                    newRegion->EnterOrLeave(enter);
-
-                    // Change region in continuation
-                    CurrentRegion <<= newRegion;
-                })
-        )
+                        position = region->Clamp(position);
+                }
+
+                return position;
+            }, Moving, CurrentRegion) ),
+        NewRegion( State<Region*>::Create([this] (PositionT pos) { return theWorld_.GetRegion(pos); }, Position) ),
+        RegionChanged( Monitor(NewRegion) ),
+        Age( Iterate<int>(0, Incrementer{ }, time.NewDay) ),
+        Health( Iterate<int>(100, [] (const auto& events, int health)
+            {
+                for (int food : events)
+                {
+                    health += food - 10;
+                    health = health < 0 ? 0 : health > 10000 ? 10000 : health;
+                }
+                return health;
+            }, FoodReceived) ),
+        regionChangeObserver_( Observer::Create([this] (const auto& events)
+            {
+                pendingRegion_ = events.back();
+            }, RegionChanged) )
     {
-        initRegion->EnterOrLeave(enter);
+        FoodReceived.Add(initRegion->FoodOutput);
+        initRegion->EnterOrLeave.Emit(enter);
     }
 
-private:
-    Continuation<D> regionChangeContinuation_;
-
-    static int calculateHealth(int food, int health)
+    /// Moves the animal to the region it wandered into. Returns false if it didn't change regions.
+    bool ApplyMigration()
     {
-        auto newHealth = health + food - 10;
-        return newHealth < 0 ? 0 : newHealth > 10000 ? 10000 : newHealth;
+        if (pendingRegion_ == nullptr)
+            return false;
+
+        Region* newRegion = pendingRegion_;
+        Region* oldRegion = currentRegion_;
+
+        pendingRegion_ = nullptr;
+
+        if (newRegion == oldRegion)
+            return false;
+
+        oldRegion->EnterOrLeave.Emit(leave);
+        newRegion->EnterOrLeave.Emit(enter);
+
+        FoodReceived.Remove(oldRegion->FoodOutput);
+        FoodReceived.Add(newRegion->FoodOutput);
+
+        CurrentRegion.Set(newRegion);
+        currentRegion_ = newRegion;
+
+        return true;
     }
+
+private:
+    World&          theWorld_;
+
+    std::mt19937    generator_;
+
+    Region*         currentRegion_;
+    Region*         pendingRegion_ = nullptr;
+
+public:
+    StateVar<Region*>   CurrentRegion;
+
+    EventSlot<int>      FoodReceived;
+    State<bool>         ShouldMigrate;
+    Event<bool>         Moving;
+
+    State<PositionT>    Position;
+    State<Region*>      NewRegion;
+
+    Event<Region*>      RegionChanged;
+
+    State<int>          Age;
+    State<int>          Health;
+
+private:
+    Observer            regionChangeObserver_;
 };
 
+} // ~namespace lifesim
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////
-/// Run simulation
+/// Benchmark_LifeSim
+/// N animals in a world of W x W regions, simulated for K days. Migrations of a day are applied
+/// in a single transaction before the next day starts.
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 struct BenchmarkParams_LifeSim
 {
@@ -277,8 +296,8 @@ struct BenchmarkParams_LifeSim
     void Print(std::ostream& out) const
     {
         out << "N = " << N
-            << ", K = " << K
-            << ", W = " << W;
+            << ", W = " << W
+            << ", K = " << K;
     }
 
     const int N;
@@ -286,15 +305,18 @@ struct BenchmarkParams_LifeSim
     const int K;
 };
 
-template <typename D>
-struct Benchmark_LifeSim : public BenchmarkBase<D>
+struct Benchmark_LifeSim
 {
     double Run(const BenchmarkParams_LifeSim& params)
     {
-        Time<D>  theTime;
-        World<D> theWorld( theTime, params.W );
+        using namespace lifesim;
+
+        Group group;
 
-        vector<unique_ptr<Animal<D>>> animals;
+        Time theTime{ group };
+        World theWorld{ group, theTime, params.W };
+
+        std::vector<std::unique_ptr<Animal>> animals;
 
         std::mt19937 gen( 2015 );
         std::uniform_int_distribution<size_t> dist( 0u, theWorld.Regions.size()-1 );
@@ -302,26 +324,27 @@ struct Benchmark_LifeSim : public BenchmarkBase<D>
         for (int i=0; i<params.N; i++)
         {
             auto r = theWorld.Regions[dist(gen)].get();
-            animals.push_back(unique_ptr<Animal<D>>(new Animal<D>(theTime, theWorld, r, i+1)));
+            animals.push_back(std::make_unique<Animal>(group, theTime, theWorld, r, i+1));
         }
 
         // WHEEL IN THE SKY KEEPS ON TURNING
-        auto t0 = tbb::tick_count::now();
+        auto t0 = std::chrono::high_resolution_clock::now();
 
         for (int i=0; i<params.K; i++)
-            theTime.NewDay();
-
-        auto t1 = tbb::tick_count::now();
-        double d = (t1 - t0).seconds();
+        {
+            theTime.NewDay.Emit();
 
-/*        std::ofstream logfile;
-        logfile.open("log.txt");
+            group.DoTransaction([&]
+                {
+                    for (auto& animal : animals)
+                        animal->ApplyMigration();
+                });
+        }
 
-        D::Log().Write(logfile);
-        logfile.close()*//*;
+        auto t1 = std::chrono::high_resolution_clock::now();
 
-        //return d;
+        return std::chrono::duration<double>(t1 - t0).count();
     }
 };
 
-*/
\ No newline at end of file
+#endif // CPP_REACT_BENCHMARK_LIFESIM_H
@@ -0,0 +1,245 @@
+//          Copyright Sebastian Jeckel 2017.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#ifndef CPP_REACT_BENCHMARK_MAIN_H
+#define CPP_REACT_BENCHMARK_MAIN_H
+
+#include <algorithm>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "BenchmarkBase.h"
+#include "BenchmarkReport.h"
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/// BenchmarkArgs
+/// Parameters given on the command line. If a benchmark is given any parameters, it runs once
+/// with them and uses defaults for the rest. Otherwise it runs its default series.
+///////////////////////////////////////////////////////////////////////////////////////////////////
+struct BenchmarkArgs
+{
+    int runCount = 5;
+
+    std::map<std::string, int> params;
+
+    bool HasParams() const
+        { return !params.empty(); }
+
+    int Get(const char* name, int defaultValue) const
+    {
+        auto it = params.find(name);
+        return it != params.end() ? it->second : defaultValue;
+    }
+};
+
+using BenchmarkFuncT = std::function<void(const BenchmarkArgs&, std::ostream&)>;
+
+struct BenchmarkEntry
+{
+    const char*     name;
+    BenchmarkFuncT  func;
+    const char*     description;    // Continuation lines are indented automatically
+};
+
+inline void PrintBenchmarkUsage(std::ostream& out, const char* programName, const std::vector<BenchmarkEntry>& benchmarks)
+{
+    out << "Usage: " << programName << " [options] <benchmark>...\n"
+        << "\n"
+        << "Benchmarks:\n";
+
+    for (const BenchmarkEntry& b : benchmarks)
+    {
+        std::string name = b.name;
+        name.resize((std::max)(name.size() + 1, size_t{ 12 }), ' ');
+
+        out << "  " << name;
+
+        for (const char* c = b.description; *c != '\0'; ++c)
+        {
+            out << *c;
+            if (*c == '\n')
+                out << std::string(14, ' ');
+        }
+
+        out << "\n";
+    }
+
+    out << "  all         All of the above\n"
+        << "\n"
+        << "Options:\n"
+        << "  --runs <count>      Number of runs per configuration (default: 5)\n"
+        << "  --log <file>        Also write results to file\n"
+        << "  --json <file>       Write samples, statistics and environment as JSON\n"
+        << "  --csv <file>        Write samples as CSV\n"
+        << "  --compare <file>    Compare with a baseline CSV file. Exits with code 2 if a\n"
+        << "                      configuration got significantly slower\n"
+        << "  --threshold <pct>   Slowdown that counts as a regression (default: 5)\n"
+        << "  --<param> <value>   Run a single configuration with the given parameter,\n"
+        << "                      e.g. --N 30 --K 1000. Delays are in milliseconds.\n"
+        << "  --help              Show this message\n"
+        << "\n"
+        << "Without parameters, each benchmark runs its default series.\n";
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/// RunBenchmarkMain
+/// Command line driver shared by the benchmark executables.
+///////////////////////////////////////////////////////////////////////////////////////////////////
+inline int RunBenchmarkMain(int argc, char* argv[], const char* programName, const std::vector<BenchmarkEntry>& benchmarks)
+{
+    BenchmarkArgs args;
+    std::vector<std::string> names;
+    std::string logPath;
+    std::string jsonPath;
+    std::string csvPath;
+    std::string baselinePath;
+    int threshold = 5;
+
+    try
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            std::string arg = argv[i];
+
+            if (arg == "--help" || arg == "-h")
+            {
+                PrintBenchmarkUsage(std::cout, programName, benchmarks);
+                return 0;
+            }
+            else if (arg.compare(0, 2, "--") == 0)
+            {
+                if (i + 1 >= argc)
+                    throw std::invalid_argument("Missing value for " + arg);
+
+                std::string value = argv[++i];
+
+                if (arg == "--runs")
+                    args.runCount = std::stoi(value);
+                else if (arg == "--log")
+                    logPath = value;
+                else if (arg == "--json")
+                    jsonPath = value;
+                else if (arg == "--csv")
+                    csvPath = value;
+                else if (arg == "--compare")
+                    baselinePath = value;
+                else if (arg == "--threshold")
+                    threshold = std::stoi(value);
+                else
+                    args.params[arg.substr(2)] = std::stoi(value);
+            }
+            else if (arg == "all")
+            {
+                for (const auto& b : benchmarks)
+                    names.push_back(b.name);
+            }
+            else
+            {
+                names.push_back(arg);
+            }
+        }
+
+        if (args.runCount < 1)
+            throw std::invalid_argument("Run count must be positive");
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Invalid arguments: " << e.what() << "\n\n";
+        PrintBenchmarkUsage(std::cerr, programName, benchmarks);
+        return 1;
+    }
+
+    if (names.empty())
+    {
+        PrintBenchmarkUsage(std::cout, programName, benchmarks);
+        return 1;
+    }
+
+    std::vector<BenchmarkFuncT> selected;
+
+    for (const auto& name : names)
+    {
+        auto it = std::find_if(benchmarks.begin(), benchmarks.end(),
+            [&] (const BenchmarkEntry& b) { return name == b.name; });
+
+        if (it == benchmarks.end())
+        {
+            std::cerr << "Unknown benchmark: " << name << "\n\n";
+            PrintBenchmarkUsage(std::cerr, programName, benchmarks);
+            return 1;
+        }
+
+        selected.push_back(it->func);
+    }
+
+    // Load the baseline first, so a typo doesn't waste a complete run.
+    std::vector<BenchmarkResult> baseline;
+
+    if (!baselinePath.empty())
+    {
+        std::ifstream baselineFile(baselinePath.c_str());
+
+        if (!baselineFile)
+        {
+            std::cerr << "Cannot open baseline file: " << baselinePath << "\n";
+            return 1;
+        }
+
+        baseline = ReadBenchmarkCsv(baselineFile);
+    }
+
+    std::ofstream logfile;
+
+    if (!logPath.empty())
+    {
+        logfile.open(logPath.c_str());
+
+        if (!logfile)
+        {
+            std::cerr << "Cannot open log file: " << logPath << "\n";
+            return 1;
+        }
+    }
+
+    for (const auto& f : selected)
+        f(args, logfile);
+
+    const auto& results = GetBenchmarkResults();
+
+    if (!jsonPath.empty())
+    {
+        std::ofstream jsonFile(jsonPath.c_str());
+        WriteBenchmarkJson(jsonFile, BenchmarkEnvironment::Get(), results);
+    }
+
+    if (!csvPath.empty())
+    {
+        std::ofstream csvFile(csvPath.c_str());
+        WriteBenchmarkCsv(csvFile, results);
+    }
+
+    if (!baselinePath.empty())
+    {
+        auto comparisons = CompareBenchmarkResults(baseline, results, threshold / 100.0);
+
+        WriteBenchmarkComparison(std::cout, comparisons);
+        WriteBenchmarkComparison(logfile, comparisons);
+
+        for (const auto& c : comparisons)
+            if (c.isRegression)
+                return 2;
+    }
+
+    return 0;
+}
+
+#endif // CPP_REACT_BENCHMARK_MAIN_H
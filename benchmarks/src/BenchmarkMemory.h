@@ -0,0 +1,168 @@
+//          Copyright Sebastian Jeckel 2017.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#ifndef CPP_REACT_BENCHMARK_MEMORY_H
+#define CPP_REACT_BENCHMARK_MEMORY_H
+
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include "react/algorithm.h"
+#include "react/event.h"
+#include "react/group.h"
+#include "react/observer.h"
+#include "react/state.h"
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/// Node footprint
+/// Creates N nodes of each kind in a separate group and prints the bytes per node reported by
+/// Group::GetMemoryUsage. Inputs shared by the nodes are created first and not counted, except for
+/// the successor entries the nodes add to them.
+///////////////////////////////////////////////////////////////////////////////////////////////////
+struct NodeFootprintHandles
+{
+    std::vector<react::State<int>>  states;
+    std::vector<react::Event<int>>  events;
+    std::vector<react::Observer>    observers;
+};
+
+struct NodeFootprintKind
+{
+    const char* name;
+
+    // Creates the shared inputs.
+    std::function<void(react::Group&, NodeFootprintHandles&)> setup;
+
+    // Creates one more node.
+    std::function<void(react::Group&, NodeFootprintHandles&)> create;
+};
+
+inline const std::vector<NodeFootprintKind>& GetNodeFootprintKinds()
+{
+    using namespace react;
+
+    using GroupT = Group;
+    using HandlesT = NodeFootprintHandles;
+
+    auto noSetup = [] (GroupT&, HandlesT&) { };
+
+    auto stateSetup = [] (GroupT& g, HandlesT& h)
+        {
+            h.states.push_back(StateVar<int>::Create(g, 0));
+            h.states.push_back(StateVar<int>::Create(g, 0));
+        };
+
+    auto eventSetup = [] (GroupT& g, HandlesT& h)
+        {
+            h.events.push_back(EventSource<int>::Create(g));
+            h.events.push_back(EventSource<int>::Create(g));
+        };
+
+    static const std::vector<NodeFootprintKind> kinds =
+        {
+            { "StateVar<int>", noSetup, [] (GroupT& g, HandlesT& h)
+                {
+                    h.states.push_back(StateVar<int>::Create(g, 0));
+                } },
+            { "State<int>(1 dep)", stateSetup, [] (GroupT& g, HandlesT& h)
+                {
+                    h.states.push_back(State<int>::Create(g, [] (int a) { return a + 1; }, h.states[0]));
+                } },
+            { "State<int>(2 deps)", stateSetup, [] (GroupT& g, HandlesT& h)
+                {
+                    h.states.push_back(State<int>::Create(g, [] (int a, int b) { return a + b; }, h.states[0], h.states[1]));
+                } },
+            { "Observer(State)", stateSetup, [] (GroupT& g, HandlesT& h)
+                {
+                    h.observers.push_back(Observer::Create(g, [] (int) { }, h.states[0]));
+                } },
+            { "EventSource<int>", noSetup, [] (GroupT& g, HandlesT& h)
+                {
+                    h.events.push_back(EventSource<int>::Create(g));
+                } },
+            { "Transform<int>", eventSetup, [] (GroupT& g, HandlesT& h)
+                {
+                    h.events.push_back(Transform<int>(g, [] (int e) { return e + 1; }, h.events[0]));
+                } },
+            { "Filter<int>", eventSetup, [] (GroupT& g, HandlesT& h)
+                {
+                    h.events.push_back(Filter(g, [] (int e) { return e > 0; }, h.events[0]));
+                } },
+            { "Merge<int>(2)", eventSetup, [] (GroupT& g, HandlesT& h)
+                {
+                    h.events.push_back(Merge(g, h.events[0], h.events[1]));
+                } },
+            { "Observer(Event)", eventSetup, [] (GroupT& g, HandlesT& h)
+                {
+                    h.observers.push_back(Observer::Create(g, [] (const auto&) { }, h.events[0]));
+                } },
+            { "Hold<int>", eventSetup, [] (GroupT& g, HandlesT& h)
+                {
+                    h.states.push_back(Hold(g, 0, h.events[0]));
+                } },
+            { "Iterate<int>", eventSetup, [] (GroupT& g, HandlesT& h)
+                {
+                    h.states.push_back(Iterate<int>(g, 0, [] (const auto& events, int v) { return v + static_cast<int>(events.size()); }, h.events[0]));
+                } }
+        };
+
+    return kinds;
+}
+
+inline void WriteNodeFootprints(std::ostream& out, int n)
+{
+    using namespace react;
+
+    out << "Bytes per node for N = " << n << "\n\n";
+
+    out << std::left << std::setw(22) << "Kind" << std::right
+        << std::setw(10) << "Object"
+        << std::setw(12) << "Successors"
+        << std::setw(10) << "Buffers"
+        << std::setw(10) << "NodeData"
+        << std::setw(10) << "Total" << "\n";
+
+    for (const NodeFootprintKind& kind : GetNodeFootprintKinds())
+    {
+        Group group;
+        NodeFootprintHandles handles;
+
+        kind.setup(group, handles);
+
+        auto sum = [] (const GraphMemoryUsage& usage, size_t NodeMemoryUsage::* field)
+            {
+                size_t result = 0;
+                for (const NodeMemoryUsage& category : usage.categories)
+                    result += category.*field;
+                return result;
+            };
+
+        GraphMemoryUsage before = group.GetMemoryUsage();
+
+        for (int i = 0; i < n; ++i)
+            kind.create(group, handles);
+
+        GraphMemoryUsage after = group.GetMemoryUsage();
+
+        auto perNode = [n] (size_t a, size_t b)
+            { return static_cast<double>(a - b) / static_cast<double>(n); };
+
+        out << std::left << std::setw(22) << kind.name << std::right << std::fixed << std::setprecision(1)
+            << std::setw(10) << perNode(sum(after, &NodeMemoryUsage::objectBytes), sum(before, &NodeMemoryUsage::objectBytes))
+            << std::setw(12) << perNode(sum(after, &NodeMemoryUsage::successorBytes), sum(before, &NodeMemoryUsage::successorBytes))
+            << std::setw(10) << perNode(sum(after, &NodeMemoryUsage::bufferBytes), sum(before, &NodeMemoryUsage::bufferBytes))
+            << std::setw(10) << perNode(after.nodeDataBytes, before.nodeDataBytes)
+            << std::setw(10) << perNode(after.GetTotalBytes(), before.GetTotalBytes()) << "\n";
+    }
+
+    out << "\nObject sizes include shared_ptr control blocks, but not memory allocated by values.\n"
+        << "NodeData includes unused slots of the graph, so it depends on N.\n\n";
+}
+
+#endif // CPP_REACT_BENCHMARK_MEMORY_H
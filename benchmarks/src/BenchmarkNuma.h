@@ -0,0 +1,288 @@
+//          Copyright Sebastian Jeckel 2017.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#ifndef CPP_REACT_BENCHMARK_NUMA_H
+#define CPP_REACT_BENCHMARK_NUMA_H
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+    #include <linux/perf_event.h>
+    #include <sys/ioctl.h>
+    #include <sys/syscall.h>
+    #include <unistd.h>
+#endif
+
+#include "BenchmarkBase.h"
+
+#include "react/common/numa.h"
+#include "react/group.h"
+#include "react/observer.h"
+#include "react/state.h"
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/// NodeAccessCounters
+/// Counts memory reads served by the local and by a remote NUMA node on all processors, with the
+/// generic NODE cache events of perf. Counting is system wide, so it needs CAP_PERFMON or a
+/// perf_event_paranoid setting of 0 or less. Not every processor supports the events either.
+/// IsValid returns false if counting is not possible.
+///////////////////////////////////////////////////////////////////////////////////////////////////
+class NodeAccessCounters
+{
+public:
+    NodeAccessCounters()
+    {
+#if defined(__linux__)
+        long cpuCount = sysconf(_SC_NPROCESSORS_CONF);
+
+        for (int cpu=0; cpu<cpuCount; cpu++)
+        {
+            int local = Open(cpu, PERF_COUNT_HW_CACHE_RESULT_ACCESS);
+            int remote = Open(cpu, PERF_COUNT_HW_CACHE_RESULT_MISS);
+
+            if (local >= 0)
+                localFds_.push_back(local);
+            if (remote >= 0)
+                remoteFds_.push_back(remote);
+        }
+#endif
+    }
+
+    NodeAccessCounters(const NodeAccessCounters&) = delete;
+    NodeAccessCounters& operator=(const NodeAccessCounters&) = delete;
+
+    ~NodeAccessCounters()
+    {
+#if defined(__linux__)
+        for (int fd : localFds_)
+            close(fd);
+        for (int fd : remoteFds_)
+            close(fd);
+#endif
+    }
+
+    bool IsValid() const
+        { return !localFds_.empty() && !remoteFds_.empty(); }
+
+    void Start()
+    {
+#if defined(__linux__)
+        for (int fd : localFds_)
+            ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        for (int fd : remoteFds_)
+            ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+
+        for (int fd : localFds_)
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        for (int fd : remoteFds_)
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+#endif
+    }
+
+    void Stop()
+    {
+#if defined(__linux__)
+        for (int fd : localFds_)
+            ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        for (int fd : remoteFds_)
+            ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+#endif
+    }
+
+    uint64_t GetLocalCount() const
+        { return Sum(localFds_); }
+
+    uint64_t GetRemoteCount() const
+        { return Sum(remoteFds_); }
+
+private:
+#if defined(__linux__)
+    static int Open(int cpu, uint64_t result)
+    {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HW_CACHE;
+        attr.config = PERF_COUNT_HW_CACHE_NODE | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (result << 16);
+        attr.disabled = 1;
+
+        return static_cast<int>(syscall(SYS_perf_event_open, &attr, -1, cpu, -1, 0));
+    }
+#endif
+
+    static uint64_t Sum(const std::vector<int>& fds)
+    {
+        uint64_t sum = 0;
+
+#if defined(__linux__)
+        for (int fd : fds)
+        {
+            uint64_t count = 0;
+            if (read(fd, &count, sizeof(count)) == sizeof(count))
+                sum += count;
+        }
+#endif
+
+        return sum;
+    }
+
+    std::vector<int> localFds_;
+    std::vector<int> remoteFds_;
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/// Benchmark_Numa
+/// G independent groups, each with N nodes that depend on a single input, process K enqueued
+/// transactions concurrently. With Placement, group i is placed on NUMA node i % node count and
+/// its graph is built by a thread of that node, so propagation only touches local memory.
+/// Without it, all graphs are built by the calling thread and the workers run anywhere.
+/// On a machine with a single NUMA node, both variants should perform the same.
+/// Besides the time, each run prints the memory reads from the local and from remote nodes during
+/// propagation, if they can be counted. These include reads of other processes.
+///////////////////////////////////////////////////////////////////////////////////////////////////
+struct BenchmarkParams_Numa
+{
+    BenchmarkParams_Numa(int g, int n, int k, bool placement) :
+        G(g),
+        N(n),
+        K(k),
+        Placement(placement)
+    {}
+
+    void Print(std::ostream& out) const
+    {
+        out << "G = " << G
+            << ", N = " << N
+            << ", K = " << K
+            << ", Placement = " << Placement
+            << ", NumaNodes = " << react::GetNumaNodeCount();
+    }
+
+    const int G;
+    const int N;
+    const int K;
+    const bool Placement;
+};
+
+struct Benchmark_Numa
+{
+    struct GroupData
+    {
+        react::Group                    group;
+        react::StateVar<int>            in;
+        std::vector<react::State<int>>  nodes;
+        std::vector<react::Observer>    observers;
+    };
+
+    static void BuildGroup(GroupData& data, int n)
+    {
+        using namespace react;
+
+        data.in = StateVar<int>::Create(data.group, 0);
+        data.nodes.reserve(n);
+
+        for (int i=0; i<n; i++)
+            data.nodes.push_back(State<int>::Create([i] (int a) { return a + i; }, data.in));
+
+        data.observers.push_back(Observer::Create([] (int) { }, data.nodes.back()));
+    }
+
+    double Run(const BenchmarkParams_Numa& params)
+    {
+        using namespace react;
+
+        int nodeCount = GetNumaNodeCount();
+
+        std::vector<std::unique_ptr<GroupData>> groups;
+
+        for (int g=0; g<params.G; g++)
+            groups.push_back(std::make_unique<GroupData>());
+
+        if (params.Placement)
+        {
+            std::vector<std::thread> builders;
+
+            for (int g=0; g<params.G; g++)
+            {
+                builders.emplace_back([&, g]
+                    {
+                        int numaNode = g % nodeCount;
+
+                        // Nodes are allocated and first touched by a thread of the target node.
+                        REACT_IMPL::NumaThreadScope scope( numaNode );
+
+                        groups[g]->group.SetNumaNode(numaNode);
+                        BuildGroup(*groups[g], params.N);
+                    });
+            }
+
+            for (auto& t : builders)
+                t.join();
+        }
+        else
+        {
+            for (int g=0; g<params.G; g++)
+                BuildGroup(*groups[g], params.N);
+        }
+
+        std::vector<TransactionStatus> statuses;
+        statuses.reserve(params.G);
+
+        NodeAccessCounters accessCounters;
+
+        accessCounters.Start();
+
+        auto t0 = std::chrono::high_resolution_clock::now();
+
+        for (int i=0; i<params.K; i++)
+        {
+            for (auto& data : groups)
+            {
+                StateVar<int>& in = data->in;
+
+                if (i == params.K - 1)
+                    statuses.push_back(data->group.EnqueueTransaction(with_status, [&in, i] { in.Set(i + 1); }));
+                else
+                    data->group.EnqueueTransaction([&in, i] { in.Set(i + 1); });
+            }
+        }
+
+        // Each queue is processed in order, so the last transaction of a group completes last.
+        for (auto& status : statuses)
+            status.Wait();
+
+        auto t1 = std::chrono::high_resolution_clock::now();
+
+        accessCounters.Stop();
+
+        if (accessCounters.IsValid())
+        {
+            uint64_t local = accessCounters.GetLocalCount();
+            uint64_t remote = accessCounters.GetRemoteCount();
+
+            std::cout << "\t\tlocal node reads = " << local
+                      << ", remote node reads = " << remote
+                      << ", remote ratio = " << (local + remote > 0 ? static_cast<double>(remote) / static_cast<double>(local + remote) : 0.0)
+                      << std::endl;
+        }
+        else
+        {
+            std::cout << "\t\tNode accesses can't be counted on this machine." << std::endl;
+        }
+
+        return std::chrono::duration<double>(t1 - t0).count();
+    }
+};
+
+#endif // CPP_REACT_BENCHMARK_NUMA_H
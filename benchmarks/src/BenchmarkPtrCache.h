@@ -0,0 +1,102 @@
+//          Copyright Sebastian Jeckel 2017.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#ifndef CPP_REACT_BENCHMARK_PTRCACHE_H
+#define CPP_REACT_BENCHMARK_PTRCACHE_H
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "BenchmarkBase.h"
+
+#include "react/common/ptrcache.h"
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/// Benchmark_PtrCache
+/// T threads each do K lookups over N cached keys, like concurrent creation of links to the same
+/// nodes. All lookups hit, so this measures contention on the shard locks.
+///////////////////////////////////////////////////////////////////////////////////////////////////
+struct BenchmarkParams_PtrCache
+{
+    BenchmarkParams_PtrCache(int n, int k, int t) :
+        N(n),
+        K(k),
+        T(t)
+    {}
+
+    void Print(std::ostream& out) const
+    {
+        out << "N = " << N
+            << ", K = " << K
+            << ", T = " << T;
+    }
+
+    const int N;
+    const int K;
+    const int T;
+};
+
+struct Benchmark_PtrCache
+{
+    double Run(const BenchmarkParams_PtrCache& params)
+    {
+        using namespace react;
+
+        WeakPtrCache<int, int> cache;
+
+        // Keep the values alive, so lookups hit.
+        std::vector<std::shared_ptr<int>> values;
+        values.reserve(params.N);
+
+        for (int i=0; i<params.N; i++)
+            values.push_back(cache.LookupOrCreate(i, [i] { return std::make_shared<int>(i); }));
+
+        std::vector<std::thread> threads;
+        threads.reserve(params.T);
+
+        std::atomic<int> readyCount{ 0 };
+        std::atomic<bool> isStarted{ false };
+
+        // Threads are created before the clock starts and wait for the others to be ready.
+        for (int t=0; t<params.T; t++)
+        {
+            threads.emplace_back([&cache, &params, &readyCount, &isStarted, t]
+                {
+                    ++readyCount;
+
+                    while (! isStarted.load(std::memory_order_acquire))
+                        std::this_thread::yield();
+
+                    for (int i=0; i<params.K; i++)
+                    {
+                        int key = static_cast<int>((static_cast<unsigned>(i) * 7919u + t) % params.N);
+                        cache.LookupOrCreate(key, [key] { return std::make_shared<int>(key); });
+                    }
+                });
+        }
+
+        while (readyCount.load() < params.T)
+            std::this_thread::yield();
+
+        auto t0 = std::chrono::high_resolution_clock::now();
+
+        isStarted.store(true, std::memory_order_release);
+
+        for (auto& t : threads)
+            t.join();
+
+        auto t1 = std::chrono::high_resolution_clock::now();
+
+        return std::chrono::duration<double>(t1 - t0).count();
+    }
+};
+
+#endif // CPP_REACT_BENCHMARK_PTRCACHE_H
@@ -1,4 +1,3 @@
-
 //          Copyright Sebastian Jeckel 2017.
 // Distributed under the Boost Software License, Version 1.0.
 //    (See accompanying file LICENSE_1_0.txt or copy at
@@ -6,8 +5,11 @@
 
 #pragma once
 
-#if 0
+#ifndef CPP_REACT_BENCHMARK_RANDOM_H
+#define CPP_REACT_BENCHMARK_RANDOM_H
 
+#include <cassert>
+#include <chrono>
 #include <functional>
 #include <iostream>
 #include <random>
@@ -18,54 +20,50 @@
 #include "react/group.h"
 #include "react/state.h"
 
-using namespace react;
-/*
 ///////////////////////////////////////////////////////////////////////////////////////////////////
-/// DiamondGraphGenerator
+/// RandomGraphGenerator
+/// Generates Height layers of Width nodes. Each node depends on the node above it; randomly
+/// selected nodes get up to three additional random dependencies from previous layers and
+/// randomly selected nodes use the slow delay function.
 ///////////////////////////////////////////////////////////////////////////////////////////////////
-template
-<
-    typename D,
-    typename TValue
->
+template <typename TValue>
 class RandomGraphGenerator
 {
 public:
-    typedef typename D::template SignalT<TValue>        MyHandle;
-    typedef typename D::template VarSignalT<TValue>     MyInputHandle;
-
-    typedef std::vector<MyHandle>       HandleVect;
-    typedef std::vector<MyInputHandle>  InputHandleVect;
+    using StateType = react::State<TValue>;
+    using StateVarType = react::StateVar<TValue>;
 
-    InputHandleVect InputSignals;
-    HandleVect      OutputSignals;
+    using StateVectType = std::vector<StateType>;
+    using StateVarVectType = std::vector<StateVarType>;
 
-    std::function<void()>    SlowDelayFunc;
-    std::function<void()>    FastDelayFunc;
+    StateVarVectType    InputStates;
+    StateVectType       OutputStates;
 
+    std::function<void()>   SlowDelayFunc;
+    std::function<void()>   FastDelayFunc;
 
-    typedef std::function<TValue(TValue)>                       Func1T;
-    typedef std::function<TValue(TValue,TValue)>                Func2T;
-    typedef std::function<TValue(TValue,TValue,TValue)>         Func3T;
-    typedef std::function<TValue(TValue,TValue,TValue,TValue)>  Func4T;
+    using Func1T = std::function<TValue(TValue)>;
+    using Func2T = std::function<TValue(TValue,TValue)>;
+    using Func3T = std::function<TValue(TValue,TValue,TValue)>;
+    using Func4T = std::function<TValue(TValue,TValue,TValue,TValue)>;
 
-    Func1T    Function1;
-    Func2T    Function2;
-    Func3T    Function3;
-    Func4T    Function4;
+    Func1T  Function1;
+    Func2T  Function2;
+    Func3T  Function3;
+    Func4T  Function4;
 
-    int     Width    = 1;
-    int     Height    = 1;
+    int     Width   = 1;
+    int     Height  = 1;
 
     int     SelectSlowCount = 0;
     int     SelectEdgeCount = 0;
 
-    int     EdgeSeed;
-    int     SlowSeed;
+    int     EdgeSeed = 0;
+    int     SlowSeed = 0;
 
-    void Generate()
+    void Generate(const react::Group& group)
     {
-        assert(InputSignals.size() == Width);
+        assert(InputStates.size() == static_cast<size_t>(Width));
 
         Func1T f1Slow = [this] (TValue a1)                                  { SlowDelayFunc(); return Function1(a1); };
         Func2T f2Slow = [this] (TValue a1, TValue a2)                       { SlowDelayFunc(); return Function2(a1,a2); };
@@ -78,7 +76,7 @@ public:
         Func4T f4Fast = [this] (TValue a1, TValue a2, TValue a3, TValue a4) { FastDelayFunc(); return Function4(a1,a2,a3,a4); };
 
         int nodeCount = Width * Height;
-        
+
         std::mt19937 edgeGen(EdgeSeed);
         const auto edgeNodes = GetUniqueRandomNumbers(edgeGen, Width, nodeCount - 1, SelectEdgeCount);
 
@@ -91,11 +89,11 @@ public:
         auto edgeNodeIt = edgeNodes.begin();
         auto slowNodeIt = slowNodes.begin();
 
-        auto cur = 0;
-        HandleVect nodes(nodeCount);
+        int cur = 0;
+        StateVectType nodes(nodeCount);
 
         for (int w=0; w<Width; w++)
-            nodes[cur++] = InputSignals[w];
+            nodes[cur++] = InputStates[w];
 
         for (int h=1; h<Height; h++)
         {
@@ -103,20 +101,20 @@ public:
 
             for (int w=0; w<Width; w++)
             {
-                Func1T f1 = f1Fast;
-                Func2T f2 = f2Fast;
-                Func3T f3 = f3Fast;
-                Func4T f4 = f4Fast;
+                Func1T* f1 = &f1Fast;
+                Func2T* f2 = &f2Fast;
+                Func3T* f3 = &f3Fast;
+                Func4T* f4 = &f4Fast;
 
                 // Delay
                 if (slowNodeIt != slowNodes.end() && cur == *slowNodeIt)
                 {
                     ++slowNodeIt;
 
-                    f1 = f1Slow;
-                    f2 = f2Slow;
-                    f3 = f3Slow;
-                    f4 = f4Slow;
+                    f1 = &f1Slow;
+                    f2 = &f2Slow;
+                    f3 = &f3Slow;
+                    f4 = &f4Slow;
                 }
 
                 // Edges
@@ -144,35 +142,32 @@ public:
                         rNode3 = nodeDist(edgeGen);
 
                     if (edgeCount == 2)
-                    {
-                        nodes[cur] = (nodes[kNode0], nodes[rNode1]) ->* f2;
-                    }
+                        nodes[cur] = StateType::Create(group, *f2, nodes[kNode0], nodes[rNode1]);
                     else if (edgeCount == 3)
-                    {
-                        nodes[cur] = (nodes[kNode0], nodes[rNode1], nodes[rNode2]) ->* f3;
-                    }
+                        nodes[cur] = StateType::Create(group, *f3, nodes[kNode0], nodes[rNode1], nodes[rNode2]);
                     else
-                    {
-                        nodes[cur] = (nodes[kNode0], nodes[rNode1], nodes[rNode2], nodes[rNode3]) ->* f4;
-                    }
+                        nodes[cur] = StateType::Create(group, *f4, nodes[kNode0], nodes[rNode1], nodes[rNode2], nodes[rNode3]);
                 }
                 else
                 {
-                    nodes[cur] = nodes[cur-Width] ->* f1;
+                    nodes[cur] = StateType::Create(group, *f1, nodes[cur-Width]);
                 }
 
                 cur++;
             }
         }
 
-        OutputSignals.clear();
+        OutputStates.clear();
         for (int i=Width*(Height-1); i<nodeCount; i++)
-            OutputSignals.push_back(nodes[i]);
+            OutputStates.push_back(nodes[i]);
     }
 };
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 /// Benchmark_Random
+/// Each of the K iterations sets a number of inputs of a random graph in a single transaction.
+/// With random input, the number is drawn from a geometric distribution, otherwise all W inputs
+/// are set.
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 struct BenchmarkParams_Random
 {
@@ -220,10 +215,14 @@ struct Benchmark_Random
 {
     double Run(const BenchmarkParams_Random& params)
     {
-        RandomGraphGenerator<D,int> generator;
+        using namespace react;
+
+        Group group;
+
+        RandomGraphGenerator<int> generator;
 
         for (int i=0; i<params.W; i++)
-            generator.InputSignals.push_back(MakeVar<D>(1));
+            generator.InputStates.push_back(StateVar<int>::Create(group, 1));
 
         generator.Width = params.W;
         generator.Height = params.H;
@@ -238,42 +237,22 @@ struct Benchmark_Random
 
         bool initializing = true;
 
-        if (params.FastDelay > 0)
-        {
-            generator.FastDelayFunc = [&initializing, &params]
+        generator.FastDelayFunc = [&initializing, &params]
             {
-                if (!initializing)
-                {
-                    auto t0 = std::chrono::high_resolution_clock::now();
-                    while (std::chrono::high_resolution_clock::now() - t0 < std::chrono::milliseconds(params.FastDelay));
-                }
+                if (params.FastDelay > 0 && !initializing)
+                    BusyWait(params.FastDelay);
             };
-        }
-        else
-        {
-            generator.FastDelayFunc = [] {};
-        }
 
-        if (params.SlowDelay > 0)
-        {
-            generator.SlowDelayFunc = [&initializing, &params]
+        generator.SlowDelayFunc = [&initializing, &params]
             {
-                if (!initializing)
-                {
-                    auto t0 = std::chrono::high_resolution_clock::now();
-                    while (std::chrono::high_resolution_clock::now() - t0 < std::chrono::milliseconds(params.SlowDelay));
-                }
+                if (params.SlowDelay > 0 && !initializing)
+                    BusyWait(params.SlowDelay);
             };
-        }
-        else
-        {
-            generator.SlowDelayFunc = [] {};
-        }
 
         generator.SelectEdgeCount = params.EdgeCount;
         generator.SelectSlowCount = params.SlowCount;
 
-        generator.Generate();
+        generator.Generate(group);
 
         initializing = false;
 
@@ -302,25 +281,26 @@ struct Benchmark_Random
 
         int cursor = 0;
 
-        auto t0 = tbb::tick_count::now();
+        auto t0 = std::chrono::high_resolution_clock::now();
+
         for (int i=0; i<params.K; i++)
         {
-            DoTransaction<D>([&] {
-                for (int j=0; j<counts[i]; j++)
+            group.DoTransaction([&]
                 {
-                    generator.InputSignals[cursor++] <<= 10+i;
+                    for (int j=0; j<counts[i]; j++)
+                    {
+                        generator.InputStates[cursor++].Set(10+i);
 
-                    if (cursor >= params.W)
-                        cursor = 0;
-                }
-            });
+                        if (cursor >= params.W)
+                            cursor = 0;
+                    }
+                });
         }
-        auto t1 = tbb::tick_count::now();
 
-        double d = (t1 - t0).seconds();
+        auto t1 = std::chrono::high_resolution_clock::now();
 
-        return d;
+        return std::chrono::duration<double>(t1 - t0).count();
     }
-};*/
+};
 
-#endif
\ No newline at end of file
+#endif // CPP_REACT_BENCHMARK_RANDOM_H
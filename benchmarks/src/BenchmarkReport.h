@@ -0,0 +1,395 @@
+//          Copyright Sebastian Jeckel 2017.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#ifndef CPP_REACT_BENCHMARK_REPORT_H
+#define CPP_REACT_BENCHMARK_REPORT_H
+
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "BenchmarkBase.h"
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/// BenchmarkEnvironment
+/// Describes the machine and build that produced a set of results.
+///////////////////////////////////////////////////////////////////////////////////////////////////
+struct BenchmarkEnvironment
+{
+    std::string cpu;
+    unsigned    threadCount = 0;
+    std::string compiler;
+    std::string buildFlags;
+    std::string dateTime;
+
+    static BenchmarkEnvironment Get()
+    {
+        BenchmarkEnvironment env;
+
+        env.cpu = GetCpuName();
+        env.threadCount = std::thread::hardware_concurrency();
+        env.dateTime = CurrentDateTime();
+
+#if defined(_MSC_VER)
+        env.compiler = "MSVC " + std::to_string(_MSC_VER);
+#elif defined(__clang__)
+        env.compiler = "Clang " __clang_version__;
+#elif defined(__GNUC__)
+        env.compiler = "GCC " __VERSION__;
+#else
+        env.compiler = "unknown";
+#endif
+
+#if defined(NDEBUG)
+        env.buildFlags = "NDEBUG";
+#else
+        env.buildFlags = "DEBUG";
+#endif
+#if defined(REACT_ENABLE_TRACING)
+        env.buildFlags += " REACT_ENABLE_TRACING";
+#endif
+#if defined(REACT_ENABLE_NODE_STATS)
+        env.buildFlags += " REACT_ENABLE_NODE_STATS";
+#endif
+
+        return env;
+    }
+
+private:
+    static std::string GetCpuName()
+    {
+#if defined(_WIN32)
+        if (const char* id = std::getenv("PROCESSOR_IDENTIFIER"))
+            return id;
+#else
+        std::ifstream cpuinfo("/proc/cpuinfo");
+        std::string line;
+
+        while (std::getline(cpuinfo, line))
+        {
+            if (line.compare(0, 10, "model name") == 0)
+            {
+                auto pos = line.find(':');
+                if (pos != std::string::npos && pos + 2 <= line.size())
+                    return line.substr(pos + 2);
+            }
+        }
+#endif
+        return "unknown";
+    }
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// Writes results with their samples and summary statistics as JSON.
+///////////////////////////////////////////////////////////////////////////////////////////////////
+inline void WriteJsonString(std::ostream& out, const std::string& s)
+{
+    out << '"';
+
+    for (char c : s)
+    {
+        if (c == '"' || c == '\\')
+            out << '\\' << c;
+        else if (static_cast<unsigned char>(c) >= 0x20)
+            out << c;
+    }
+
+    out << '"';
+}
+
+inline void WriteBenchmarkJson(std::ostream& out, const BenchmarkEnvironment& env, const std::vector<BenchmarkResult>& results)
+{
+    out << std::setprecision(9);
+
+    out << "{\n  \"environment\": {\n";
+    out << "    \"cpu\": ";         WriteJsonString(out, env.cpu);          out << ",\n";
+    out << "    \"threads\": " << env.threadCount << ",\n";
+    out << "    \"compiler\": ";    WriteJsonString(out, env.compiler);     out << ",\n";
+    out << "    \"buildFlags\": ";  WriteJsonString(out, env.buildFlags);   out << ",\n";
+    out << "    \"date\": ";        WriteJsonString(out, env.dateTime);     out << "\n";
+    out << "  },\n  \"results\": [";
+
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        const BenchmarkResult& r = results[i];
+
+        out << (i > 0 ? ",\n" : "\n") << "    {\n";
+        out << "      \"name\": ";      WriteJsonString(out, r.name);   out << ",\n";
+        out << "      \"params\": ";    WriteJsonString(out, r.params); out << ",\n";
+        out << "      \"metric\": ";    WriteJsonString(out, r.GetMetricName()); out << ",\n";
+        out << "      \"lowerIsBetter\": " << (r.isLowerBetter ? "true" : "false") << ",\n";
+        out << "      \"mean\": " << r.GetMean() << ",\n";
+        out << "      \"stddev\": " << r.GetStdDev() << ",\n";
+        out << "      \"min\": " << r.GetMin() << ",\n";
+        out << "      \"max\": " << r.GetMax() << ",\n";
+        out << "      \"p50\": " << r.GetPercentile(50) << ",\n";
+        out << "      \"p90\": " << r.GetPercentile(90) << ",\n";
+        out << "      \"p99\": " << r.GetPercentile(99) << ",\n";
+        out << "      \"samples\": [";
+
+        for (size_t j = 0; j < r.samples.size(); ++j)
+            out << (j > 0 ? ", " : "") << r.samples[j];
+
+        out << "]\n    }";
+    }
+
+    out << "\n  ]\n}\n";
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// Writes one row per run and metric. This is also the format of baselines for comparison.
+// Baselines without the metric column only contain durations.
+///////////////////////////////////////////////////////////////////////////////////////////////////
+inline void WriteBenchmarkCsv(std::ostream& out, const std::vector<BenchmarkResult>& results)
+{
+    out << std::setprecision(9);
+    out << "benchmark,params,metric,run,value\n";
+
+    for (const BenchmarkResult& r : results)
+        for (size_t i = 0; i < r.samples.size(); ++i)
+            out << r.name << ",\"" << r.params << "\"," << r.GetMetricName() << ',' << (i + 1) << ',' << r.samples[i] << '\n';
+}
+
+inline std::vector<BenchmarkResult> ReadBenchmarkCsv(std::istream& in)
+{
+    std::vector<BenchmarkResult> results;
+    std::map<std::tuple<std::string, std::string, std::string>, size_t> indices;
+
+    std::string line;
+    std::getline(in, line); // Header
+
+    bool hasMetric = line.find(",metric,") != std::string::npos;
+
+    while (std::getline(in, line))
+    {
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
+
+        // benchmark,"params",metric,run,value or benchmark,"params",run,seconds
+        auto nameEnd = line.find(',');
+        auto paramsBegin = line.find('"', nameEnd);
+        auto paramsEnd = line.find('"', paramsBegin + 1);
+        auto valueBegin = line.rfind(',');
+
+        if (nameEnd == std::string::npos || paramsBegin == std::string::npos || paramsEnd == std::string::npos || valueBegin <= paramsEnd)
+            continue;
+
+        std::string metric;
+
+        if (hasMetric)
+        {
+            auto metricBegin = paramsEnd + 2;
+            auto metricEnd = line.find(',', metricBegin);
+
+            if (metricBegin > line.size() || metricEnd >= valueBegin)
+                continue;
+
+            metric = line.substr(metricBegin, metricEnd - metricBegin);
+
+            if (metric == "seconds")
+                metric.clear();
+        }
+
+        auto key = std::make_tuple(line.substr(0, nameEnd), line.substr(paramsBegin + 1, paramsEnd - paramsBegin - 1), metric);
+
+        auto it = indices.find(key);
+        if (it == indices.end())
+        {
+            it = indices.emplace(key, results.size()).first;
+            results.push_back(BenchmarkResult{ std::get<0>(key), std::get<1>(key), { }, metric });
+        }
+
+        results[it->second].samples.push_back(std::atof(line.c_str() + valueBegin + 1));
+    }
+
+    return results;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/// Statistics
+/// Welch's t-test, with the CDF of Student's t-distribution computed from the regularized
+/// incomplete beta function.
+///////////////////////////////////////////////////////////////////////////////////////////////////
+namespace benchmark_stats {
+
+// Continued fraction for the incomplete beta function (modified Lentz's method).
+inline double BetaContinuedFraction(double a, double b, double x)
+{
+    const double tiny = 1e-30;
+
+    double qab = a + b;
+    double qap = a + 1.0;
+    double qam = a - 1.0;
+    double c = 1.0;
+    double d = 1.0 - qab * x / qap;
+
+    if (std::fabs(d) < tiny)
+        d = tiny;
+    d = 1.0 / d;
+
+    double h = d;
+
+    for (int m = 1; m <= 200; ++m)
+    {
+        int m2 = 2 * m;
+        double aa = m * (b - m) * x / ((qam + m2) * (a + m2));
+
+        d = 1.0 + aa * d;
+        if (std::fabs(d) < tiny)
+            d = tiny;
+        c = 1.0 + aa / c;
+        if (std::fabs(c) < tiny)
+            c = tiny;
+        d = 1.0 / d;
+        h *= d * c;
+
+        aa = -(a + m) * (qab + m) * x / ((a + m2) * (qap + m2));
+
+        d = 1.0 + aa * d;
+        if (std::fabs(d) < tiny)
+            d = tiny;
+        c = 1.0 + aa / c;
+        if (std::fabs(c) < tiny)
+            c = tiny;
+        d = 1.0 / d;
+
+        double del = d * c;
+        h *= del;
+
+        if (std::fabs(del - 1.0) < 1e-12)
+            break;
+    }
+
+    return h;
+}
+
+inline double IncompleteBeta(double a, double b, double x)
+{
+    if (x <= 0.0)
+        return 0.0;
+    if (x >= 1.0)
+        return 1.0;
+
+    double front = std::exp(std::lgamma(a + b) - std::lgamma(a) - std::lgamma(b) + a * std::log(x) + b * std::log(1.0 - x));
+
+    if (x < (a + 1.0) / (a + b + 2.0))
+        return front * BetaContinuedFraction(a, b, x) / a;
+    else
+        return 1.0 - front * BetaContinuedFraction(b, a, 1.0 - x) / b;
+}
+
+// Two-sided p-value of Welch's t-test for different means.
+inline double WelchTTest(const BenchmarkResult& a, const BenchmarkResult& b)
+{
+    size_t na = a.samples.size();
+    size_t nb = b.samples.size();
+
+    if (na < 2 || nb < 2)
+        return 1.0;
+
+    double va = a.GetStdDev() * a.GetStdDev() / na;
+    double vb = b.GetStdDev() * b.GetStdDev() / nb;
+
+    if (va + vb <= 0.0)
+        return a.GetMean() == b.GetMean() ? 1.0 : 0.0;
+
+    double t = (a.GetMean() - b.GetMean()) / std::sqrt(va + vb);
+    double df = (va + vb) * (va + vb) / (va * va / (na - 1) + vb * vb / (nb - 1));
+
+    return IncompleteBeta(df / 2.0, 0.5, df / (df + t * t));
+}
+
+} // ~namespace benchmark_stats
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/// BenchmarkComparison
+/// A configuration is a regression if its mean time or one of its metrics got worse by more than
+/// the threshold and the difference is statistically significant.
+///////////////////////////////////////////////////////////////////////////////////////////////////
+struct BenchmarkComparison
+{
+    std::string name;
+    std::string params;
+    std::string metric;         // Empty for the duration
+    double      baselineMean;
+    double      currentMean;
+    double      change;         // Relative change of the mean, e.g. 0.1 for 10% worse
+    double      pValue;
+    bool        isRegression;
+};
+
+inline std::vector<BenchmarkComparison> CompareBenchmarkResults(const std::vector<BenchmarkResult>& baseline, const std::vector<BenchmarkResult>& current,
+    double threshold = 0.05, double alpha = 0.05)
+{
+    std::vector<BenchmarkComparison> comparisons;
+
+    for (const BenchmarkResult& cur : current)
+    {
+        auto it = std::find_if(baseline.begin(), baseline.end(),
+            [&] (const BenchmarkResult& b) { return b.name == cur.name && b.params == cur.params && b.metric == cur.metric; });
+
+        if (it == baseline.end())
+            continue;
+
+        BenchmarkComparison c;
+        c.name = cur.name;
+        c.params = cur.params;
+        c.metric = cur.metric;
+        c.baselineMean = it->GetMean();
+        c.currentMean = cur.GetMean();
+
+        // The baseline file doesn't say which direction is better, so it's taken from the current result.
+        double worsening = cur.isLowerBetter ? c.currentMean - c.baselineMean : c.baselineMean - c.currentMean;
+        c.change = c.baselineMean > 0.0 ? worsening / c.baselineMean : 0.0;
+        c.pValue = benchmark_stats::WelchTTest(*it, cur);
+        c.isRegression = c.change > threshold && c.pValue < alpha;
+
+        comparisons.push_back(std::move(c));
+    }
+
+    return comparisons;
+}
+
+inline void WriteBenchmarkComparison(std::ostream& out, const std::vector<BenchmarkComparison>& comparisons)
+{
+    out << "===== Comparison with baseline =====" << std::endl << std::endl;
+
+    if (comparisons.empty())
+    {
+        out << "\tNo matching configurations in baseline" << std::endl << std::endl;
+        return;
+    }
+
+    for (const BenchmarkComparison& c : comparisons)
+    {
+        out << (c.isRegression ? "REGRESSION " : "           ") << c.name << " (" << c.params << ")";
+
+        if (!c.metric.empty())
+            out << " " << c.metric;
+
+        out << std::endl;
+        out << "\tBaseline: " << c.baselineMean
+            << "\tCurrent: " << c.currentMean
+            << "\tChange: " << std::showpos << std::fixed << std::setprecision(1) << (c.change * 100.0) << "%"
+            << std::noshowpos << std::defaultfloat << std::setprecision(3)
+            << "\tp = " << c.pValue << std::endl;
+    }
+
+    out << std::setprecision(6) << std::endl;
+}
+
+#endif // CPP_REACT_BENCHMARK_REPORT_H
@@ -1,4 +1,3 @@
-
 //          Copyright Sebastian Jeckel 2017.
 // Distributed under the Boost Software License, Version 1.0.
 //    (See accompanying file LICENSE_1_0.txt or copy at
@@ -6,22 +5,22 @@
 
 #pragma once
 
-#if 0
+#ifndef CPP_REACT_BENCHMARK_SEQUENCE_H
+#define CPP_REACT_BENCHMARK_SEQUENCE_H
 
+#include <chrono>
 #include <iostream>
-#include <random>
 #include <vector>
 
 #include "BenchmarkBase.h"
 
+#include "react/group.h"
 #include "react/state.h"
 
-/*
-
-using namespace react;
-
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 /// Benchmark_Sequence
+/// A chain of N nodes after a single input, which is set K times. Each node update spins for
+/// Delay ms.
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 struct BenchmarkParams_Sequence
 {
@@ -47,38 +46,36 @@ struct Benchmark_Sequence
 {
     double Run(const BenchmarkParams_Sequence& params)
     {
-        using MySignal = Signal<D,int>;
+        using namespace react;
+
+        Group group;
 
         bool initializing = true;
 
-        auto in = MakeVar<D>(1);
+        auto in = StateVar<int>::Create(group, 1);
 
-        std::vector<MySignal> nodes;
-        auto f = [&initializing,&params] (int a)
-        {
-            if (params.Delay > 0 && !initializing)
+        auto f = [&initializing, &params] (int a)
             {
-                auto t0 = std::chrono::high_resolution_clock::now();
-                while (std::chrono::high_resolution_clock::now() - t0 < std::chrono::milliseconds(params.Delay));
-            }
-            return a + 1;
-        };
+                if (params.Delay > 0 && !initializing)
+                    BusyWait(params.Delay);
+                return a + 1;
+            };
 
-        MySignal cur = in;
+        State<int> cur = in;
         for (int i=0; i<params.N; i++)
-            cur = cur ->* f;
+            cur = State<int>::Create(f, cur);
 
         initializing = false;
 
-        auto t0 = tbb::tick_count::now();
+        auto t0 = std::chrono::high_resolution_clock::now();
+
         for (int i=0; i<params.K; i++)
-            in <<= 10+i;
-        auto t1 = tbb::tick_count::now();
+            in.Set(10+i);
 
-        double d = (t1 - t0).seconds();
+        auto t1 = std::chrono::high_resolution_clock::now();
 
-        return d;
+        return std::chrono::duration<double>(t1 - t0).count();
     }
-};*/
+};
 
-#endif
\ No newline at end of file
+#endif // CPP_REACT_BENCHMARK_SEQUENCE_H
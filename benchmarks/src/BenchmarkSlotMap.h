@@ -0,0 +1,118 @@
+//          Copyright Sebastian Jeckel 2017.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#ifndef CPP_REACT_BENCHMARK_SLOTMAP_H
+#define CPP_REACT_BENCHMARK_SLOTMAP_H
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include "BenchmarkBase.h"
+
+#include "react/common/slotmap.h"
+
+// About the size of the per-node data of a graph.
+struct SlotMapValue
+{
+    size_t payload[8];
+};
+
+struct BenchmarkParams_SlotMap
+{
+    BenchmarkParams_SlotMap(int n, int k) :
+        N(n),
+        K(k)
+    {}
+
+    void Print(std::ostream& out) const
+    {
+        out << "N = " << N
+            << ", K = " << K;
+    }
+
+    const int N;
+    const int K;
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/// Benchmark_SlotMapInsertErase
+/// Each of the K rounds inserts N elements and erases them in random order, so later rounds
+/// reuse free slots.
+///////////////////////////////////////////////////////////////////////////////////////////////////
+struct Benchmark_SlotMapInsertErase
+{
+    double Run(const BenchmarkParams_SlotMap& params)
+    {
+        using namespace react;
+
+        SlotMap<SlotMapValue> slotMap;
+
+        std::vector<size_t> indices(params.N);
+        std::vector<size_t> order(params.N);
+        std::iota(order.begin(), order.end(), 0);
+        std::shuffle(order.begin(), order.end(), std::mt19937(2017));
+
+        auto t0 = std::chrono::high_resolution_clock::now();
+
+        for (int k=0; k<params.K; k++)
+        {
+            for (int i=0; i<params.N; i++)
+                indices[i] = slotMap.Insert(SlotMapValue{ { static_cast<size_t>(i) } });
+
+            for (size_t i : order)
+                slotMap.Erase(indices[i]);
+        }
+
+        auto t1 = std::chrono::high_resolution_clock::now();
+
+        return std::chrono::duration<double>(t1 - t0).count();
+    }
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/// Benchmark_SlotMapLookup
+/// K passes of random lookups over N elements, like the scheduling of successors during a turn.
+///////////////////////////////////////////////////////////////////////////////////////////////////
+struct Benchmark_SlotMapLookup
+{
+    double Run(const BenchmarkParams_SlotMap& params)
+    {
+        using namespace react;
+
+        SlotMap<SlotMapValue> slotMap;
+
+        std::vector<size_t> indices;
+        indices.reserve(params.N);
+
+        for (int i=0; i<params.N; i++)
+            indices.push_back(slotMap.Insert(SlotMapValue{ { static_cast<size_t>(i) } }));
+
+        std::shuffle(indices.begin(), indices.end(), std::mt19937(2017));
+
+        size_t sum = 0;
+
+        auto t0 = std::chrono::high_resolution_clock::now();
+
+        for (int k=0; k<params.K; k++)
+            for (size_t index : indices)
+                sum += slotMap[index].payload[0];
+
+        auto t1 = std::chrono::high_resolution_clock::now();
+
+        // Keep the loop from being optimized away.
+        if (sum == 0 && params.N > 1)
+            std::cout << sum;
+
+        return std::chrono::duration<double>(t1 - t0).count();
+    }
+};
+
+#endif // CPP_REACT_BENCHMARK_SLOTMAP_H
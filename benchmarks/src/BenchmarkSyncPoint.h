@@ -0,0 +1,144 @@
+//          Copyright Sebastian Jeckel 2017.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#ifndef CPP_REACT_BENCHMARK_SYNCPOINT_H
+#define CPP_REACT_BENCHMARK_SYNCPOINT_H
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "BenchmarkBase.h"
+
+#include "react/common/syncpoint.h"
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/// Benchmark_SyncPointDependency
+/// Measures the cost of copying and releasing SyncPoint::Dependency objects, as done for every
+/// linked transaction. Each of the T threads copies a shared dependency K times.
+///////////////////////////////////////////////////////////////////////////////////////////////////
+struct BenchmarkParams_SyncPointDependency
+{
+    BenchmarkParams_SyncPointDependency(int k, int t) :
+        K(k),
+        T(t)
+    {}
+
+    void Print(std::ostream& out) const
+    {
+        out << "K = " << K
+            << ", T = " << T;
+    }
+
+    const int K;
+    const int T;
+};
+
+struct Benchmark_SyncPointDependency
+{
+    double Run(const BenchmarkParams_SyncPointDependency& params)
+    {
+        using namespace react;
+
+        SyncPoint sp;
+        SyncPoint::Dependency dep{ sp };
+
+        std::vector<std::thread> threads;
+        threads.reserve(params.T);
+
+        std::atomic<int> readyCount{ 0 };
+        std::atomic<bool> isStarted{ false };
+
+        // Threads are created before the clock starts and wait for the others to be ready.
+        for (int t = 0; t < params.T; ++t)
+        {
+            threads.emplace_back([&dep, &params, &readyCount, &isStarted]
+                {
+                    ++readyCount;
+
+                    while (! isStarted.load(std::memory_order_acquire))
+                        std::this_thread::yield();
+
+                    for (int i = 0; i < params.K; ++i)
+                    {
+                        SyncPoint::Dependency copy{ dep };
+                        copy.Release();
+                    }
+                });
+        }
+
+        while (readyCount.load() < params.T)
+            std::this_thread::yield();
+
+        auto t0 = std::chrono::high_resolution_clock::now();
+
+        isStarted.store(true, std::memory_order_release);
+
+        for (auto& t : threads)
+            t.join();
+
+        auto t1 = std::chrono::high_resolution_clock::now();
+
+        dep.Release();
+        sp.Wait();
+
+        return std::chrono::duration<double>(t1 - t0).count();
+    }
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/// Benchmark_SyncPointMerge
+/// Measures the cost of merging N dependencies into one and releasing it, as done for linked
+/// transactions that carry the dependencies of several merged transactions.
+///////////////////////////////////////////////////////////////////////////////////////////////////
+struct BenchmarkParams_SyncPointMerge
+{
+    BenchmarkParams_SyncPointMerge(int n, int k) :
+        N(n),
+        K(k)
+    {}
+
+    void Print(std::ostream& out) const
+    {
+        out << "N = " << N
+            << ", K = " << K;
+    }
+
+    const int N;
+    const int K;
+};
+
+struct Benchmark_SyncPointMerge
+{
+    double Run(const BenchmarkParams_SyncPointMerge& params)
+    {
+        using namespace react;
+
+        std::vector<SyncPoint> syncPoints(params.N);
+        std::vector<SyncPoint::Dependency> deps;
+        deps.reserve(params.N);
+
+        for (const auto& sp : syncPoints)
+            deps.emplace_back(sp);
+
+        auto t0 = std::chrono::high_resolution_clock::now();
+
+        for (int i = 0; i < params.K; ++i)
+        {
+            SyncPoint::Dependency merged{ deps.begin(), deps.end() };
+            SyncPoint::Dependency copy{ merged };
+        }
+
+        auto t1 = std::chrono::high_resolution_clock::now();
+
+        return std::chrono::duration<double>(t1 - t0).count();
+    }
+};
+
+#endif // CPP_REACT_BENCHMARK_SYNCPOINT_H
@@ -0,0 +1,94 @@
+//          Copyright Sebastian Jeckel 2017.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#ifndef CPP_REACT_BENCHMARK_TEARDOWN_H
+#define CPP_REACT_BENCHMARK_TEARDOWN_H
+
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+#include "BenchmarkBase.h"
+
+#include "react/group.h"
+#include "react/observer.h"
+#include "react/state.h"
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/// Benchmark_Teardown
+/// Destruction of a graph with W inputs, each with N / W dependent nodes and an observer per node.
+/// With Bulk, the nodes are destroyed inside of a TeardownScope.
+///////////////////////////////////////////////////////////////////////////////////////////////////
+struct BenchmarkParams_Teardown
+{
+    BenchmarkParams_Teardown(int n, int w, bool bulk) :
+        N(n),
+        W(w),
+        Bulk(bulk)
+    {}
+
+    void Print(std::ostream& out) const
+    {
+        out << "N = " << N
+            << ", W = " << W
+            << ", Bulk = " << Bulk;
+    }
+
+    const int N;
+    const int W;
+    const bool Bulk;
+};
+
+struct Benchmark_Teardown
+{
+    double Run(const BenchmarkParams_Teardown& params)
+    {
+        using namespace react;
+
+        Group group;
+
+        std::vector<StateVar<int>> inputs;
+        std::vector<State<int>> nodes;
+        std::vector<Observer> observers;
+
+        inputs.reserve(params.W);
+        nodes.reserve(params.N);
+        observers.reserve(params.N);
+
+        for (int i=0; i<params.W; i++)
+            inputs.push_back(StateVar<int>::Create(group, i));
+
+        for (int i=0; i<params.N; i++)
+        {
+            nodes.push_back(State<int>::Create([] (int a) { return a + 1; }, inputs[i % params.W]));
+            observers.push_back(Observer::Create([] (int) { }, nodes.back()));
+        }
+
+        auto t0 = std::chrono::high_resolution_clock::now();
+
+        if (params.Bulk)
+        {
+            TeardownScope teardown{ group };
+
+            observers.clear();
+            nodes.clear();
+            inputs.clear();
+        }
+        else
+        {
+            observers.clear();
+            nodes.clear();
+            inputs.clear();
+        }
+
+        auto t1 = std::chrono::high_resolution_clock::now();
+
+        return std::chrono::duration<double>(t1 - t0).count();
+    }
+};
+
+#endif // CPP_REACT_BENCHMARK_TEARDOWN_H
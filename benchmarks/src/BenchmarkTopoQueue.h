@@ -0,0 +1,81 @@
+//          Copyright Sebastian Jeckel 2017.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#ifndef CPP_REACT_BENCHMARK_TOPOQUEUE_H
+#define CPP_REACT_BENCHMARK_TOPOQUEUE_H
+
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "BenchmarkBase.h"
+
+#include "react/detail/graph_impl.h"
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/// Benchmark_TopoQueue
+/// Each of the K turns pushes N nodes with levels drawn uniformly from [0, L) and fetches
+/// them level by level. L = 1 is a flat fan-out, L = N a chain.
+///////////////////////////////////////////////////////////////////////////////////////////////////
+struct BenchmarkParams_TopoQueue
+{
+    BenchmarkParams_TopoQueue(int n, int l, int k) :
+        N(n),
+        L(l),
+        K(k)
+    {}
+
+    void Print(std::ostream& out) const
+    {
+        out << "N = " << N
+            << ", L = " << L
+            << ", K = " << K;
+    }
+
+    const int N;
+    const int L;
+    const int K;
+};
+
+struct Benchmark_TopoQueue
+{
+    double Run(const BenchmarkParams_TopoQueue& params)
+    {
+        using REACT_IMPL::TopoQueue;
+
+        std::mt19937 gen(2017);
+        std::uniform_int_distribution<int> levelDist(0, params.L - 1);
+
+        std::vector<int> levels(params.N);
+        for (auto& level : levels)
+            level = levelDist(gen);
+
+        TopoQueue queue;
+        size_t fetchedCount = 0;
+
+        auto t0 = std::chrono::high_resolution_clock::now();
+
+        for (int k=0; k<params.K; k++)
+        {
+            for (int i=0; i<params.N; i++)
+                queue.Push(static_cast<size_t>(i), levels[i]);
+
+            while (queue.FetchNext())
+                fetchedCount += queue.Next().size();
+        }
+
+        auto t1 = std::chrono::high_resolution_clock::now();
+
+        if (fetchedCount != static_cast<size_t>(params.N) * params.K)
+            std::cout << "\tUnexpected node count: " << fetchedCount << std::endl;
+
+        return std::chrono::duration<double>(t1 - t0).count();
+    }
+};
+
+#endif // CPP_REACT_BENCHMARK_TOPOQUEUE_H
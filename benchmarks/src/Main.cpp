@@ -1,227 +1,159 @@
-
 //          Copyright Sebastian Jeckel 2017.
 // Distributed under the Boost Software License, Version 1.0.
 //    (See accompanying file LICENSE_1_0.txt or copy at
 //          http://www.boost.org/LICENSE_1_0.txt)
 
-#if 0
-//#include "tbb/tick_count.h"
-//#include "tbb/tbbmalloc_proxy.h"
-
-//#include "ittnotify.h"
+#include <iostream>
+#include <sstream>
+#include <vector>
 
-/*#include "BenchmarkGrid.h"
-#include "BenchmarkRandom.h"
 #include "BenchmarkFanout.h"
-#include "BenchmarkSequence.h"
+#include "BenchmarkGrid.h"
+#include "BenchmarkLatency.h"
 #include "BenchmarkLifeSim.h"
-
-#include "react/Group.h"
-#include "react/Signal.h"
-#include "react/Algorithm.h"
-#include "react/common/Util.h"*/
+#include "BenchmarkMain.h"
+#include "BenchmarkMemory.h"
+#include "BenchmarkNuma.h"
+#include "BenchmarkRandom.h"
+#include "BenchmarkSequence.h"
+#include "BenchmarkTeardown.h"
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 namespace {
 
-//using namespace react;
-
-/*void runBenchmarkGrid(std::ostream& out)
+void RunGrid(const BenchmarkArgs& args, std::ostream& out)
 {
-    RUN_BENCHMARK(out, 5, Benchmark_Grid, BenchmarkParams_Grid(20, 10000),
-        ToposortSTDomain, ToposortDomain, PulsecountDomain);
-
-    RUN_BENCHMARK(out, 5, Benchmark_Grid, BenchmarkParams_Grid(30, 10000),
-        ToposortSTDomain, ToposortDomain, PulsecountDomain);
-
-    RUN_BENCHMARK(out, 5, Benchmark_Grid, BenchmarkParams_Grid(40, 10000),
-        ToposortSTDomain, ToposortDomain, PulsecountDomain);
+    if (args.HasParams())
+    {
+        RUN_BENCHMARK(out, args.runCount, Benchmark_Grid, BenchmarkParams_Grid(args.Get("N", 20), args.Get("K", 10000)));
+        return;
+    }
 
-    RUN_BENCHMARK(out, 5, Benchmark_Grid, BenchmarkParams_Grid(50, 10000),
-        ToposortSTDomain, ToposortDomain, PulsecountDomain);
-}*/
+    for (int n : { 20, 30, 40, 50 })
+        RUN_BENCHMARK(out, args.runCount, Benchmark_Grid, BenchmarkParams_Grid(n, 10000));
+}
 
-/*void runBenchmarkRandom(std::ostream& out)
+void RunRandom(const BenchmarkArgs& args, std::ostream& out)
 {
-    const auto w = 20;
-    const auto h = 11;
-
-    int seed1 = 41556;
-    int seed2 = 21624;
-
-    for (int j=1; j<=10; j++)
+    if (args.HasParams())
     {
-        printf("STARTING SERIES %d\n", j);
-
-        for (int slowPercent=0; slowPercent<=50; slowPercent+=5)
-        {
-            int x = (slowPercent * (w*(h-1))) / 100;
-            //RUN_BENCHMARK(out, 5, Benchmark_Random, BenchmarkParams_Random(w, h, 20, 0, 10, 40, x, true, seed1, seed2),
-            //    ToposortDomain, ELMDomain, PulsecountDomain, SourceSetDomain);
+        RUN_BENCHMARK(out, args.runCount, Benchmark_Random, BenchmarkParams_Random(
+            args.Get("W", 20), args.Get("H", 11), args.Get("K", 20),
+            args.Get("FastDelay", 0), args.Get("SlowDelay", 1),
+            args.Get("EdgeCount", 40), args.Get("SlowCount", 0),
+            args.Get("RandomInput", 1) != 0,
+            args.Get("EdgeSeed", 41556), args.Get("SlowSeed", 21624)));
+        return;
+    }
 
-            RUN_BENCHMARK(out, 5, Benchmark_Random, BenchmarkParams_Random(w, h, 20, 0, 10, 40, x, true, seed1, seed2),
-                ToposortSTDomain);
-        }
+    const int w = 20;
+    const int h = 11;
 
-        seed1 *= 2;
-        seed2 *= 2;
+    for (int slowPercent=0; slowPercent<=50; slowPercent+=25)
+    {
+        int x = (slowPercent * (w*(h-1))) / 100;
+        RUN_BENCHMARK(out, args.runCount, Benchmark_Random, BenchmarkParams_Random(w, h, 20, 0, 1, 40, x, true, 41556, 21624));
     }
-}*/
+}
 
-void runBenchmarkFanout(std::ostream& out)
+void RunFanout(const BenchmarkArgs& args, std::ostream& out)
 {
-    //RUN_BENCHMARK(out, 5, Benchmark_Fanout, BenchmarkParams_Fanout(10, 10000, 0),
-    //    ToposortSTDomain, ToposortDomain, ELMDomain, PulsecountDomain, SourceSetDomain);
-
-    //RUN_BENCHMARK(out, 5, Benchmark_Fanout, BenchmarkParams_Fanout(100, 10000, 0),
-    //    ToposortSTDomain, ToposortDomain, ELMDomain, PulsecountDomain, SourceSetDomain);
-
-    //RUN_BENCHMARK(out, 5, Benchmark_Fanout, BenchmarkParams_Fanout(1000, 10000, 0),
-    //    ToposortSTDomain, ToposortDomain, ELMDomain, PulsecountDomain, SourceSetDomain);
-
- /*   RUN_BENCHMARK(out, 3, Benchmark_Fanout, BenchmarkParams_Fanout(10, 10, 10),
-        ToposortSTDomain, ToposortDomain, PulsecountDomain);
-
-    RUN_BENCHMARK(out, 3, Benchmark_Fanout, BenchmarkParams_Fanout(100, 10, 10),
-        ToposortSTDomain, ToposortDomain, PulsecountDomain);
+    if (args.HasParams())
+    {
+        RUN_BENCHMARK(out, args.runCount, Benchmark_Fanout, BenchmarkParams_Fanout(args.Get("N", 100), args.Get("K", 10000), args.Get("Delay", 0)));
+        return;
+    }
 
-    RUN_BENCHMARK(out, 3, Benchmark_Fanout, BenchmarkParams_Fanout(1000, 10, 10),
-        ToposortSTDomain, ToposortDomain, PulsecountDomain);*/
+    for (int n : { 10, 100, 1000 })
+        RUN_BENCHMARK(out, args.runCount, Benchmark_Fanout, BenchmarkParams_Fanout(n, 10000, 0));
 }
 
-void runBenchmarkSequence(std::ostream& out)
+void RunSequence(const BenchmarkArgs& args, std::ostream& out)
 {
-    //RUN_BENCHMARK(out, 3, Benchmark_Sequence, BenchmarkParams_Sequence(10, 10000, 0),
-    //    ToposortSTDomain, ToposortDomain, ELMDomain, PulsecountDomain, SourceSetDomain);
-
-    //RUN_BENCHMARK(out, 3, Benchmark_Sequence, BenchmarkParams_Sequence(100, 10000, 0),
-    //    ToposortSTDomain, ToposortDomain, ELMDomain, PulsecountDomain, SourceSetDomain);
-
-    //RUN_BENCHMARK(out, 3, Benchmark_Sequence, BenchmarkParams_Sequence(1000, 10000, 0),
-    //    ToposortSTDomain, ToposortDomain, ELMDomain, PulsecountDomain, SourceSetDomain);
-
-    //RUN_BENCHMARK(out, 3, Benchmark_Sequence, BenchmarkParams_Sequence(10, 10, 10),
-    //    ToposortSTDomain, ToposortDomain, PulsecountDomain);
-
-    //RUN_BENCHMARK(out, 3, Benchmark_Sequence, BenchmarkParams_Sequence(100, 10, 10),
-    //    ToposortSTDomain, ToposortDomain, PulsecountDomain);
+    if (args.HasParams())
+    {
+        RUN_BENCHMARK(out, args.runCount, Benchmark_Sequence, BenchmarkParams_Sequence(args.Get("N", 100), args.Get("K", 10000), args.Get("Delay", 0)));
+        return;
+    }
 
-    //RUN_BENCHMARK(out, 3, Benchmark_Sequence, BenchmarkParams_Sequence(1000, 10, 10),
-    //    ToposortSTDomain, ToposortDomain, PulsecountDomain);
+    for (int n : { 10, 100, 1000 })
+        RUN_BENCHMARK(out, args.runCount, Benchmark_Sequence, BenchmarkParams_Sequence(n, 10000, 0));
 }
 
-void runBenchmarkLifeSim(std::ostream& out)
+void RunLifeSim(const BenchmarkArgs& args, std::ostream& out)
 {
-    //RUN_BENCHMARK(std::cout, 1, Benchmark_LifeSim, BenchmarkParams_LifeSim(150, 1000),
-    //    ELMDomain);
-
-    //RUN_BENCHMARK(std::cout, 1, Benchmark_LifeSim, BenchmarkParams_LifeSim(250, 30, 10000),
-    //    SourceSetDomain, PulsecountDomain);
-
-    //RUN_BENCHMARK(out, 1, Benchmark_LifeSim, BenchmarkParams_LifeSim(100, 15, 10000),
-    //    ToposortSTDomainConc, ToposortDomainConc, PulsecountDomainConc);
-
-    //RUN_BENCHMARK(out, 3, Benchmark_LifeSim, BenchmarkParams_LifeSim(100, 50, 100),
-    //    PulsecountDomain, PulsecountDomain);
+    RUN_BENCHMARK(out, args.runCount, Benchmark_LifeSim, BenchmarkParams_LifeSim(args.Get("N", 100), args.Get("W", 15), args.Get("K", 1000)));
 }
 
-void runBenchmarks()
+void RunLatency(const BenchmarkArgs& args, std::ostream& out)
 {
-    std::ofstream logfile;
-
-    //std::string path = "Benchmark Results/" + CurrentDateTime() + ".txt";
-    //logfile.open(path.c_str());
-
-    // === GRID
-    //runBenchmarkGrid(logfile);
-
-    //runBenchmarkFlooding(logfile);
-
-    // === RANDOM
-    //runBenchmarkRandom(logfile);
-
-    // === FANOUT
-    //runBenchmarkFanout(logfile);
-
-    // === SEQUENCE
-    //runBenchmarkSequence(logfile);
+    if (args.HasParams())
+    {
+        RUN_BENCHMARK(out, args.runCount, Benchmark_Latency, BenchmarkParams_Latency(
+            args.Get("P", 1), args.Get("R", 10000), args.Get("K", 10000),
+            args.Get("Merging", 0) != 0, args.Get("Linked", 0) != 0));
+        return;
+    }
 
-    // === LIFESIM
-    //runBenchmarkLifeSim(logfile);
+    for (int p : { 1, 4 })
+        for (bool merging : { false, true })
+            RUN_BENCHMARK(out, args.runCount, Benchmark_Latency, BenchmarkParams_Latency(p, 10000, 10000, merging, false));
 
-    logfile.close();
+    RUN_BENCHMARK(out, args.runCount, Benchmark_Latency, BenchmarkParams_Latency(1, 10000, 10000, false, true));
 }
 
-void debugBenchmarks()
+void RunTeardown(const BenchmarkArgs& args, std::ostream& out)
 {
-    //using TestDomain = PulsecountDomain;
-
-    //RUN_BENCHMARK(std::cout, 1, Benchmark_Grid, BenchmarkParams_Grid(30, 1),
-    //    TestDomain);
-
-    //RUN_BENCHMARK(std::cout, 1, Benchmark_Fanout, BenchmarkParams_Fanout(1000, 5, 0),
-    //    TestDomain);
-
-    //RUN_BENCHMARK(std::cout, 1, Benchmark_Grid, BenchmarkParams_Grid(30, 1),
-        //TestDomain);
-
-    //RUN_BENCHMARK(std::cout, 1, Benchmark_Sequence, BenchmarkParams_Sequence(500, 1, 0),
-    //    TestDomain);
-
-    //RUN_BENCHMARK(std::cout, 1, Benchmark_Random, BenchmarkParams_Random(10, 25, 10, 0, 10, 25, 25, false),
-    //    ToposortDomain);
-
-    //RUN_BENCHMARK(std::cout, 1, Benchmark_Random, BenchmarkParams_Random(40, 11, 2, 0, 1, 40, 40, false, 41556, 21624),
-    //    TestDomain);
-
-    //const auto w = 10;
-    //const auto h = 11;
-
-    //for (int slowPercent=0; slowPercent<=50; slowPercent+=50)
-    //{
-    //    int seed1 = 4156;
-    //    int seed2 = 2124;
-
-    //    for (int j=1; j<=5; j++)
-    //    {
-    //        int x = (slowPercent * (w*(h-1))) / 100;
-    //        RUN_BENCHMARK(std::cout, 1, Benchmark_Random, BenchmarkParams_Random(w, h, 100, 0, 5, 25, x, false, seed1 / j, seed2 / j),
-    //            ToposortDomain);
-    //    }
-    //}
+    if (args.HasParams())
+    {
+        RUN_BENCHMARK(out, args.runCount, Benchmark_Teardown, BenchmarkParams_Teardown(args.Get("N", 100000), args.Get("W", 1), args.Get("Bulk", 1) != 0));
+        return;
+    }
 
-    //RunBenchmark<1>(Benchmark2<BTokenDomain>());
-    //RunBenchmark<1>(Benchmark2<SourceSetDomain>());
-    //RunBenchmark<3>(Benchmark2<ToposortDomain>());
+    for (int w : { 1, 100 })
+        for (bool bulk : { false, true })
+            RUN_BENCHMARK(out, args.runCount, Benchmark_Teardown, BenchmarkParams_Teardown(100000, w, bulk));
 }
 
-void profileBenchmark()
+void RunNuma(const BenchmarkArgs& args, std::ostream& out)
 {
-    //RUN_BENCHMARK(std::cout, 3, Benchmark_Grid, BenchmarkParams_Grid(100, 10000));
-
-    //RUN_BENCHMARK(std::cout, 1, Benchmark_Grid, BenchmarkParams_Grid(30, 10000),
-        //SourceSetDomain);
-
-    //RUN_BENCHMARK(std::cout, 3, Benchmark_Random, BenchmarkParams_Random(20, 11, 100, 0, 1, 40, 40, false, 41556, 21624),
-        //SubtreeDomain);
-        //ToposortSTDomain, ToposortDomain, PulsecountDomain, SubtreeDomain);
+    if (args.HasParams())
+    {
+        RUN_BENCHMARK(out, args.runCount, Benchmark_Numa, BenchmarkParams_Numa(args.Get("G", 4), args.Get("N", 100000), args.Get("K", 100), args.Get("Placement", 1) != 0));
+        return;
+    }
 
-    //RUN_BENCHMARK(std::cout, 1, Benchmark_LifeSim, BenchmarkParams_LifeSim(100, 15, 10000),
-        //ToposortSTDomainConc);
+    for (int g : { 2, 8 })
+        for (bool placement : { false, true })
+            RUN_BENCHMARK(out, args.runCount, Benchmark_Numa, BenchmarkParams_Numa(g, 100000, 100, placement));
 }
 
-} // ~anonymous namespace 
-
-int main()
+void RunMemory(const BenchmarkArgs& args, std::ostream& out)
 {
-    //runBenchmarks();
-    //debugBenchmarks();    
-    //profileBenchmark();
+    // Like the timed benchmarks, print to the console and the log.
+    std::ostringstream report;
+    WriteNodeFootprints(report, args.Get("N", 10000));
+
+    std::cout << report.str();
+    out << report.str();
 }
 
-#endif
+} // ~anonymous namespace
 
-int main()
+int main(int argc, char* argv[])
 {
-    return 0;
-}
\ No newline at end of file
+    static const std::vector<BenchmarkEntry> benchmarks =
+        {
+            { "grid",       RunGrid,        "Grid that grows to width N and shrinks back (N, K)" },
+            { "random",     RunRandom,      "Random graph of W x H nodes (W, H, K, FastDelay, SlowDelay,\nEdgeCount, SlowCount, RandomInput, EdgeSeed, SlowSeed)" },
+            { "fanout",     RunFanout,      "N nodes depending on a single input (N, K, Delay)" },
+            { "sequence",   RunSequence,    "Chain of N nodes (N, K, Delay)" },
+            { "lifesim",    RunLifeSim,     "Life simulation of N animals in W x W regions for K days (N, W, K)" },
+            { "latency",    RunLatency,     "End-to-end latency of enqueued transactions from P producers at\nR transactions per second each (P, R, K, Merging, Linked).\nR = 0 sends as fast as possible. Results are p99 in seconds, with p50, p99.9,\nmax, mean and throughput as additional metrics" },
+            { "teardown",   RunTeardown,    "Destruction of N nodes with observers that depend on W inputs (N, W, Bulk)" },
+            { "numa",       RunNuma,        "G groups with N nodes each process K enqueued transactions concurrently,\nwith or without NUMA placement (G, N, K, Placement)" },
+            { "memory",     RunMemory,      "Bytes per node for each node kind, for N nodes of a kind (N)" }
+        };
+
+    return RunBenchmarkMain(argc, argv, "CppReactBenchmark", benchmarks);
+}
@@ -0,0 +1,104 @@
+//          Copyright Sebastian Jeckel 2017.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include <iostream>
+#include <vector>
+
+#include "BenchmarkEventValueList.h"
+#include "BenchmarkMain.h"
+#include "BenchmarkPtrCache.h"
+#include "BenchmarkSlotMap.h"
+#include "BenchmarkSyncPoint.h"
+#include "BenchmarkTopoQueue.h"
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+namespace {
+
+void RunSlotMap(const BenchmarkArgs& args, std::ostream& out)
+{
+    if (args.HasParams())
+    {
+        BenchmarkParams_SlotMap params(args.Get("N", 1000), args.Get("K", 10000));
+
+        RUN_BENCHMARK(out, args.runCount, Benchmark_SlotMapInsertErase, params);
+        RUN_BENCHMARK(out, args.runCount, Benchmark_SlotMapLookup, params);
+        return;
+    }
+
+    for (int n : { 100, 10000, 1000000 })
+    {
+        RUN_BENCHMARK(out, args.runCount, Benchmark_SlotMapInsertErase, BenchmarkParams_SlotMap(n, 10000000 / n));
+        RUN_BENCHMARK(out, args.runCount, Benchmark_SlotMapLookup, BenchmarkParams_SlotMap(n, 10000000 / n));
+    }
+}
+
+void RunTopoQueue(const BenchmarkArgs& args, std::ostream& out)
+{
+    if (args.HasParams())
+    {
+        RUN_BENCHMARK(out, args.runCount, Benchmark_TopoQueue, BenchmarkParams_TopoQueue(args.Get("N", 100), args.Get("L", 10), args.Get("K", 10000)));
+        return;
+    }
+
+    for (int l : { 1, 10, 100 })
+        RUN_BENCHMARK(out, args.runCount, Benchmark_TopoQueue, BenchmarkParams_TopoQueue(100, l, 10000));
+
+    RUN_BENCHMARK(out, args.runCount, Benchmark_TopoQueue, BenchmarkParams_TopoQueue(10000, 100, 100));
+}
+
+void RunPtrCache(const BenchmarkArgs& args, std::ostream& out)
+{
+    if (args.HasParams())
+    {
+        RUN_BENCHMARK(out, args.runCount, Benchmark_PtrCache, BenchmarkParams_PtrCache(args.Get("N", 1000), args.Get("K", 1000000), args.Get("T", 1)));
+        return;
+    }
+
+    for (int t : { 1, 2, 4, 8 })
+        RUN_BENCHMARK(out, args.runCount, Benchmark_PtrCache, BenchmarkParams_PtrCache(1000, 1000000, t));
+}
+
+void RunSyncPoint(const BenchmarkArgs& args, std::ostream& out)
+{
+    if (args.HasParams())
+    {
+        RUN_BENCHMARK(out, args.runCount, Benchmark_SyncPointDependency, BenchmarkParams_SyncPointDependency(args.Get("K", 1000000), args.Get("T", 1)));
+        RUN_BENCHMARK(out, args.runCount, Benchmark_SyncPointMerge, BenchmarkParams_SyncPointMerge(args.Get("N", 4), args.Get("K", 1000000)));
+        return;
+    }
+
+    RUN_BENCHMARK(out, args.runCount, Benchmark_SyncPointDependency, BenchmarkParams_SyncPointDependency(1000000, 1));
+    RUN_BENCHMARK(out, args.runCount, Benchmark_SyncPointDependency, BenchmarkParams_SyncPointDependency(1000000, 4));
+    RUN_BENCHMARK(out, args.runCount, Benchmark_SyncPointMerge, BenchmarkParams_SyncPointMerge(4, 1000000));
+}
+
+void RunEventValueList(const BenchmarkArgs& args, std::ostream& out)
+{
+    if (args.HasParams())
+    {
+        RUN_BENCHMARK(out, args.runCount, Benchmark_EventValueList, BenchmarkParams_EventValueList(args.Get("N", 100), args.Get("K", 100000), args.Get("Reuse", 1) != 0));
+        return;
+    }
+
+    for (int n : { 1, 10, 1000 })
+        for (bool reuse : { true, false })
+            RUN_BENCHMARK(out, args.runCount, Benchmark_EventValueList, BenchmarkParams_EventValueList(n, 10000000 / n, reuse));
+}
+
+} // ~anonymous namespace
+
+int main(int argc, char* argv[])
+{
+    static const std::vector<BenchmarkEntry> benchmarks =
+        {
+            { "slotmap",    RunSlotMap,         "SlotMap insert/erase churn and random lookups over N elements (N, K)" },
+            { "topoqueue",  RunTopoQueue,       "TopoQueue push and fetch of N nodes over L levels per turn (N, L, K)" },
+            { "ptrcache",   RunPtrCache,        "WeakPtrCache lookups by T threads over N keys (N, K, T)" },
+            { "syncpoint",  RunSyncPoint,       "SyncPoint dependency copy by T threads and merge of N (K, T, N)" },
+            { "eventlist",  RunEventValueList,  "EventValueList growth by N events per turn (N, K, Reuse)" }
+        };
+
+    return RunBenchmarkMain(argc, argv, "CppReactMicroBenchmark", benchmarks);
+}
@@ -0,0 +1,1068 @@
+//          Copyright Sebastian Jeckel 2017.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef REACT_ANALYSIS_H_INCLUDED
+#define REACT_ANALYSIS_H_INCLUDED
+
+#pragma once
+
+#include "react/detail/defs.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <iterator>
+#include <locale>
+#include <map>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "react/api.h"
+#include "react/common/tracing.h"
+
+/***************************************/ REACT_IMPL_BEGIN /**************************************/
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/// TracedSpan
+/// A turn or node update of a trace, either recorded by this process or loaded from a file.
+///////////////////////////////////////////////////////////////////////////////////////////////////
+struct TracedSpan
+{
+    uint64_t        threadId;
+    TraceEventKind  kind;
+    uint64_t        beginTime;
+    uint64_t        endTime;
+    uint64_t        id;
+    int             level;
+};
+
+/// Builds a profile of each turn from the node updates it contains on the same thread.
+template <typename TTurnProfile>
+std::vector<TTurnProfile> MakeTurnProfiles(std::vector<TracedSpan> spans)
+{
+    // A turn comes before the updates that begin at the same time.
+    std::stable_sort(spans.begin(), spans.end(), [] (const TracedSpan& a, const TracedSpan& b)
+        {
+            if (a.threadId != b.threadId)
+                return a.threadId < b.threadId;
+
+            if (a.beginTime != b.beginTime)
+                return a.beginTime < b.beginTime;
+
+            return a.kind == TraceEventKind::turn && b.kind != TraceEventKind::turn;
+        });
+
+    std::vector<TTurnProfile> result;
+    const TracedSpan* turnSpan = nullptr;
+
+    for (const TracedSpan& span : spans)
+    {
+        if (span.kind == TraceEventKind::turn)
+        {
+            turnSpan = &span;
+            result.emplace_back();
+        }
+        else if (turnSpan != nullptr && turnSpan->threadId == span.threadId && span.endTime <= turnSpan->endTime)
+        {
+            result.back().updates.push_back({ static_cast<size_t>(span.id), std::chrono::nanoseconds(span.endTime - span.beginTime), span.level });
+        }
+    }
+
+    return result;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/// ChromeTraceReader
+/// Reads the turns and node updates of a trace in the Chrome trace event format, as written by
+/// WriteChromeTrace. Only complete events ("ph":"X") are used, everything else is skipped.
+///////////////////////////////////////////////////////////////////////////////////////////////////
+class ChromeTraceReader
+{
+public:
+    ChromeTraceReader(const char* begin, const char* end) :
+        pos_( begin ),
+        end_( end )
+    { }
+
+    bool Read(std::vector<TracedSpan>& spans)
+    {
+        SkipSpace();
+
+        // Either an object with a traceEvents array, or just the array.
+        if (Peek() == '[')
+            return ReadEvents(spans);
+
+        bool hasEvents = false;
+
+        bool isValid = ReadObject([&] (const std::string& key)
+            {
+                if (key != "traceEvents")
+                    return SkipValue();
+
+                hasEvents = true;
+                return ReadEvents(spans);
+            });
+
+        return isValid && hasEvents;
+    }
+
+private:
+    bool ReadEvents(std::vector<TracedSpan>& spans)
+    {
+        if (!Consume('['))
+            return false;
+
+        if (Consume(']'))
+            return true;
+
+        do
+        {
+            if (!ReadEvent(spans))
+                return false;
+        }
+        while (Consume(','));
+
+        return Consume(']');
+    }
+
+    bool ReadEvent(std::vector<TracedSpan>& spans)
+    {
+        std::string category;
+        std::string phase;
+
+        double ts = 0.0;
+        double dur = 0.0;
+        double pid = 0.0;
+        double tid = 0.0;
+        double id = 0.0;
+        double level = -1.0;
+
+        bool isValid = ReadObject([&] (const std::string& key)
+            {
+                if (key == "cat")
+                    return ReadString(category);
+                if (key == "ph")
+                    return ReadString(phase);
+                if (key == "ts")
+                    return ReadNumber(ts);
+                if (key == "dur")
+                    return ReadNumber(dur);
+                if (key == "pid")
+                    return ReadNumber(pid);
+                if (key == "tid")
+                    return ReadNumber(tid);
+
+                if (key != "args")
+                    return SkipValue();
+
+                return ReadObject([&] (const std::string& argKey)
+                    {
+                        if (argKey == "id")
+                            return ReadNumber(id);
+                        if (argKey == "level")
+                            return ReadNumber(level);
+
+                        return SkipValue();
+                    });
+            });
+
+        if (!isValid)
+            return false;
+
+        if (phase != "X")
+            return true;
+
+        TraceEventKind kind;
+
+        if (category == "turn")
+            kind = TraceEventKind::turn;
+        else if (category == "node")
+            kind = TraceEventKind::node_update;
+        else
+            return true;
+
+        // Times are in microseconds.
+        uint64_t beginTime = static_cast<uint64_t>(std::llround(ts * 1000.0));
+        uint64_t endTime = beginTime + static_cast<uint64_t>(std::llround(dur * 1000.0));
+
+        uint64_t threadId = (static_cast<uint64_t>(pid) << 32) | static_cast<uint64_t>(tid);
+
+        spans.push_back(TracedSpan{ threadId, kind, beginTime, endTime, static_cast<uint64_t>(id), static_cast<int>(level) });
+        return true;
+    }
+
+    template <typename F>
+    bool ReadObject(F&& readMember)
+    {
+        if (!Consume('{'))
+            return false;
+
+        if (Consume('}'))
+            return true;
+
+        do
+        {
+            std::string key;
+
+            if (!ReadString(key) || !Consume(':') || !readMember(key))
+                return false;
+        }
+        while (Consume(','));
+
+        return Consume('}');
+    }
+
+    bool ReadString(std::string& out)
+    {
+        if (!Consume('"'))
+            return false;
+
+        while (pos_ != end_ && *pos_ != '"')
+        {
+            char c = *pos_++;
+
+            if (c == '\\')
+            {
+                if (pos_ == end_)
+                    return false;
+
+                c = *pos_++;
+
+                // Code points are not needed, so they are replaced.
+                if (c == 'u')
+                {
+                    if (end_ - pos_ < 4)
+                        return false;
+
+                    pos_ += 4;
+                    c = '?';
+                }
+                else if (c == 'n')
+                {
+                    c = '\n';
+                }
+                else if (c == 't')
+                {
+                    c = '\t';
+                }
+            }
+
+            out += c;
+        }
+
+        return pos_ != end_ && *pos_++ == '"';
+    }
+
+    bool ReadNumber(double& out)
+    {
+        SkipSpace();
+
+        const char* begin = pos_;
+
+        while (pos_ != end_ && (std::isdigit(static_cast<unsigned char>(*pos_)) || std::strchr("+-.eE", *pos_) != nullptr))
+            ++pos_;
+
+        // Not strtod, because that depends on the locale.
+        std::istringstream in{ std::string(begin, pos_) };
+        in.imbue(std::locale::classic());
+
+        return static_cast<bool>(in >> out);
+    }
+
+    bool SkipValue()
+    {
+        SkipSpace();
+
+        if (Peek() == '{')
+            return ReadObject([this] (const std::string&) { return SkipValue(); });
+
+        if (Peek() == '"')
+        {
+            std::string s;
+            return ReadString(s);
+        }
+
+        if (Consume('['))
+        {
+            if (Consume(']'))
+                return true;
+
+            do
+            {
+                if (!SkipValue())
+                    return false;
+            }
+            while (Consume(','));
+
+            return Consume(']');
+        }
+
+        // Numbers, true, false and null.
+        const char* begin = pos_;
+
+        while (pos_ != end_ && (std::isalnum(static_cast<unsigned char>(*pos_)) || std::strchr("+-.", *pos_) != nullptr))
+            ++pos_;
+
+        return pos_ != begin;
+    }
+
+    bool Consume(char c)
+    {
+        SkipSpace();
+
+        if (Peek() != c)
+            return false;
+
+        ++pos_;
+        return true;
+    }
+
+    char Peek() const
+        { return pos_ != end_ ? *pos_ : '\0'; }
+
+    void SkipSpace()
+    {
+        while (pos_ != end_ && std::isspace(static_cast<unsigned char>(*pos_)))
+            ++pos_;
+    }
+
+    const char* pos_;
+    const char* end_;
+};
+
+/****************************************/ REACT_IMPL_END /***************************************/
+
+/*****************************************/ REACT_BEGIN /*****************************************/
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/// TurnProfile
+/// The nodes that were updated in a turn and how long each update took.
+///////////////////////////////////////////////////////////////////////////////////////////////////
+struct TurnProfile
+{
+    struct NodeUpdate
+    {
+        size_t                      nodeId;
+        std::chrono::nanoseconds    time;
+        int                         level   = -1;   // Level of the node when it was updated, or -1 if unknown
+    };
+
+    std::vector<NodeUpdate> updates;
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/// TurnAnalysis
+/// Work and span of a set of turns, to estimate what parallel propagation could gain.
+///////////////////////////////////////////////////////////////////////////////////////////////////
+struct TurnAnalysis
+{
+    struct LevelProfile
+    {
+        int                         level           = 0;
+        uint64_t                    turnCount       = 0;    // Turns that updated nodes on this level
+        uint64_t                    nodeCount       = 0;
+        std::chrono::nanoseconds    work            { 0 };
+        std::chrono::nanoseconds    span            { 0 };  // Sum of the slowest update per turn
+
+        double GetAverageWidth() const
+            { return turnCount > 0 ? static_cast<double>(nodeCount) / static_cast<double>(turnCount) : 0.0; }
+
+        double GetParallelism() const
+            { return span.count() > 0 ? static_cast<double>(work.count()) / static_cast<double>(span.count()) : 0.0; }
+    };
+
+    // One per level of each turn. Used to estimate the time of level-by-level parallel propagation.
+    struct LevelStep
+    {
+        std::chrono::nanoseconds    work;
+        std::chrono::nanoseconds    span;
+    };
+
+    uint64_t                    turnCount       = 0;
+    uint64_t                    updateCount     = 0;
+    std::chrono::nanoseconds    totalWork       { 0 };
+    std::chrono::nanoseconds    criticalPath    { 0 };  // Sum of the longest dependency chain per turn
+
+    std::vector<LevelProfile>   levels;
+    std::vector<LevelStep>      steps;
+
+    /// Average parallelism if dependencies were the only constraint.
+    double GetParallelism() const
+        { return criticalPath.count() > 0 ? static_cast<double>(totalWork.count()) / static_cast<double>(criticalPath.count()) : 0.0; }
+
+    /// Estimated speedup with coreCount cores, if each level is updated in parallel and levels are
+    /// processed one after another, like the graph does. Assumes no scheduling overhead.
+    double EstimateSpeedup(size_t coreCount) const
+    {
+        double parallelTime = 0.0;
+
+        for (const LevelStep& step : steps)
+            parallelTime += (std::max)(static_cast<double>(step.span.count()), static_cast<double>(step.work.count()) / static_cast<double>(coreCount));
+
+        return parallelTime > 0.0 ? static_cast<double>(totalWork.count()) / parallelTime : 0.0;
+    }
+
+    /// Upper bound of the speedup with coreCount cores, if nodes could start as soon as their predecessors are done.
+    double GetSpeedupBound(size_t coreCount) const
+    {
+        double parallelTime = (std::max)(static_cast<double>(criticalPath.count()), static_cast<double>(totalWork.count()) / static_cast<double>(coreCount));
+        return parallelTime > 0.0 ? static_cast<double>(totalWork.count()) / parallelTime : 0.0;
+    }
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/// Analyzes recorded turns of the group described by nodes, which is the result of Group::GetNodes.
+/// Nodes that are not part of the graph (anymore) are ignored. Updates are grouped by the level they
+/// were recorded with. Only updates without a recorded level use the current level of their node.
+///////////////////////////////////////////////////////////////////////////////////////////////////
+inline TurnAnalysis AnalyzeTurns(const std::vector<GraphNodeInfo>& nodes, const std::vector<TurnProfile>& turns)
+{
+    using std::chrono::nanoseconds;
+
+    TurnAnalysis result;
+
+    std::unordered_map<size_t, const GraphNodeInfo*> nodeMap;
+    for (const GraphNodeInfo& info : nodes)
+        nodeMap[info.nodeId] = &info;
+
+    std::map<int, TurnAnalysis::LevelProfile> levelMap;
+
+    for (const TurnProfile& turn : turns)
+    {
+        struct Update
+        {
+            const GraphNodeInfo*    info;
+            nanoseconds             time;
+            int                     level;
+        };
+
+        // Updates sorted by level, so predecessors are finished before their successors.
+        std::vector<Update> updates;
+        updates.reserve(turn.updates.size());
+
+        for (const TurnProfile::NodeUpdate& update : turn.updates)
+        {
+            auto it = nodeMap.find(update.nodeId);
+            if (it != nodeMap.end())
+                updates.push_back(Update{ it->second, update.time, update.level >= 0 ? update.level : it->second->level });
+        }
+
+        if (updates.empty())
+            continue;
+
+        std::stable_sort(updates.begin(), updates.end(),
+            [] (const Update& a, const Update& b) { return a.level < b.level; });
+
+        ++result.turnCount;
+
+        // Earliest finish time of each node, if every node starts once its updated predecessors are done.
+        std::unordered_map<size_t, nanoseconds> startTimes;
+        nanoseconds turnCriticalPath{ 0 };
+
+        size_t levelBegin = 0;
+
+        while (levelBegin < updates.size())
+        {
+            int level = updates[levelBegin].level;
+
+            TurnAnalysis::LevelStep step{ nanoseconds{ 0 }, nanoseconds{ 0 } };
+            size_t levelEnd = levelBegin;
+
+            for (; levelEnd < updates.size() && updates[levelEnd].level == level; ++levelEnd)
+            {
+                const GraphNodeInfo& info = *updates[levelEnd].info;
+                nanoseconds time = updates[levelEnd].time;
+
+                step.work += time;
+                step.span = (std::max)(step.span, time);
+
+                auto it = startTimes.find(info.nodeId);
+                nanoseconds finishTime = (it != startTimes.end() ? it->second : nanoseconds{ 0 }) + time;
+
+                turnCriticalPath = (std::max)(turnCriticalPath, finishTime);
+
+                for (size_t succId : info.successors)
+                {
+                    nanoseconds& succStart = startTimes[succId];
+                    succStart = (std::max)(succStart, finishTime);
+                }
+            }
+
+            auto& levelProfile = levelMap[level];
+            levelProfile.level = level;
+            levelProfile.turnCount += 1;
+            levelProfile.nodeCount += levelEnd - levelBegin;
+            levelProfile.work += step.work;
+            levelProfile.span += step.span;
+
+            result.updateCount += levelEnd - levelBegin;
+            result.totalWork += step.work;
+            result.steps.push_back(step);
+
+            levelBegin = levelEnd;
+        }
+
+        result.criticalPath += turnCriticalPath;
+    }
+
+    for (auto& e : levelMap)
+        result.levels.push_back(e.second);
+
+    return result;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/// Extracts the turns recorded by tracing in this process. Requires REACT_ENABLE_TRACING.
+/// Node ids are only meaningful for a single group, so only that group should be traced.
+///////////////////////////////////////////////////////////////////////////////////////////////////
+inline std::vector<TurnProfile> GetTracedTurns()
+{
+    using REACT_IMPL::TraceBuffer;
+    using REACT_IMPL::TraceEvent;
+    using REACT_IMPL::TraceEventKind;
+    using REACT_IMPL::TracedSpan;
+
+    std::vector<TracedSpan> spans;
+
+    REACT_IMPL::TraceRegistry::Instance().ForEachBuffer([&] (const TraceBuffer& buffer)
+        {
+            buffer.ForEach([&] (const TraceEvent& e)
+                {
+                    if (e.kind == TraceEventKind::node_update || e.kind == TraceEventKind::turn)
+                        spans.push_back(TracedSpan{ buffer.GetThreadIndex(), e.kind, e.beginTime, e.endTime, e.id, e.level });
+                });
+        });
+
+    return REACT_IMPL::MakeTurnProfiles<TurnProfile>(std::move(spans));
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/// Reads the turns of a trace that was saved with WriteChromeTrace, for example to analyze it offline.
+/// The trace only contains node ids and levels, so AnalyzeTurns still needs the nodes of the traced group.
+/// Returns false if the input is not a trace in the Chrome trace event format.
+///////////////////////////////////////////////////////////////////////////////////////////////////
+inline bool LoadTracedTurns(std::istream& in, std::vector<TurnProfile>& turns)
+{
+    std::string text{ std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>() };
+    std::vector<REACT_IMPL::TracedSpan> spans;
+
+    if (!REACT_IMPL::ChromeTraceReader(text.data(), text.data() + text.size()).Read(spans))
+        return false;
+
+    turns = REACT_IMPL::MakeTurnProfiles<TurnProfile>(std::move(spans));
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/// Writes a human-readable summary of an analysis.
+///////////////////////////////////////////////////////////////////////////////////////////////////
+inline void WriteTurnAnalysisReport(std::ostream& out, const TurnAnalysis& analysis, const std::vector<size_t>& coreCounts = { 2, 4, 8, 16 })
+{
+    auto toMicroseconds = [] (std::chrono::nanoseconds t)
+        { return static_cast<double>(t.count()) / 1000.0; };
+
+    out << "Turns:          " << analysis.turnCount << "\n";
+    out << "Node updates:   " << analysis.updateCount << "\n";
+    out << "Total work:     " << toMicroseconds(analysis.totalWork) << " us\n";
+    out << "Critical path:  " << toMicroseconds(analysis.criticalPath) << " us\n";
+    out << "Parallelism:    " << analysis.GetParallelism() << "\n";
+
+    out << "\nLevel\tTurns\tNodes\tWidth\tWork (us)\tSpan (us)\tParallelism\n";
+
+    for (const auto& level : analysis.levels)
+    {
+        out << level.level << "\t" << level.turnCount << "\t" << level.nodeCount << "\t" << level.GetAverageWidth() << "\t"
+            << toMicroseconds(level.work) << "\t" << toMicroseconds(level.span) << "\t" << level.GetParallelism() << "\n";
+    }
+
+    out << "\nCores\tSpeedup (by level)\tSpeedup (bound)\n";
+
+    for (size_t coreCount : coreCounts)
+        out << coreCount << "\t" << analysis.EstimateSpeedup(coreCount) << "\t" << analysis.GetSpeedupBound(coreCount) << "\n";
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/// GraphPartition
+/// Assignment of the nodes of a group to parts, so that each part can be rebuilt in its own group.
+/// Dependencies between parts become links, which propagate concurrently.
+///////////////////////////////////////////////////////////////////////////////////////////////////
+struct GraphPartition
+{
+    struct Part
+    {
+        std::vector<size_t> nodeIds;
+        double              cost        = 0.0;
+    };
+
+    // A node with successors in another part. Rebuilding the partition creates one link for each.
+    struct Link
+    {
+        size_t  sourceNodeId;
+        int     sourcePart;
+        int     targetPart;
+    };
+
+    std::vector<Part>                       parts;
+    std::vector<Link>                       links;
+    size_t                                  cutEdgeCount    = 0;
+    double                                  totalCost       = 0.0;
+
+    std::unordered_map<size_t, int>         nodeParts;
+    std::unordered_map<std::string, int>    namedNodeParts;     // Nodes with a debug name
+
+    /// Returns the part of a node, or -1 if it was not partitioned.
+    int GetPart(size_t nodeId) const
+    {
+        auto it = nodeParts.find(nodeId);
+        return it != nodeParts.end() ? it->second : -1;
+    }
+
+    /// Returns the part of the node with the given debug name, or -1 if there is none.
+    /// Node ids are only meaningful for the analyzed group, so a rebuilt graph should identify its nodes by name.
+    int FindPart(const std::string& debugName) const
+    {
+        auto it = namedNodeParts.find(debugName);
+        return it != namedNodeParts.end() ? it->second : -1;
+    }
+
+    /// Cost of the most expensive part relative to the average.
+    double GetImbalance() const
+    {
+        double maxCost = 0.0;
+        for (const Part& part : parts)
+            maxCost = (std::max)(maxCost, part.cost);
+
+        return totalCost > 0.0 ? maxCost * static_cast<double>(parts.size()) / totalCost : 1.0;
+    }
+};
+
+struct PartitionOptions
+{
+    double  maxImbalance        = 1.1;  // Maximum cost of a part relative to the average
+    int     refinementPasses    = 8;
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/// Partitions the group described by nodes, which is the result of Group::GetNodes, into at most
+/// partCount parts of balanced cost with few dependencies between them.
+///
+/// The cost of a node is its recorded update time if node statistics are enabled and the group has
+/// propagated, its update count if there are no times, and 1 otherwise.
+///
+/// Dependencies between the parts never form a cycle, so each turn passes through every linked group
+/// at most once. Weakly connected components that fit into a part are never split. Larger ones are cut
+/// into consecutive pieces of a depth-first topological order. Then nodes on the boundaries are moved
+/// between parts while that reduces the number of cut edges.
+///
+/// To rebuild, create one group per part and create each node in the group of its part. Dependencies
+/// on nodes of another group are linked automatically.
+///////////////////////////////////////////////////////////////////////////////////////////////////
+inline GraphPartition PartitionGraph(const std::vector<GraphNodeInfo>& nodes, size_t partCount, const PartitionOptions& options = { })
+{
+    GraphPartition result;
+
+    const size_t n = nodes.size();
+    const size_t k = (std::max)(size_t{ 1 }, (std::min)(partCount, n));
+
+    if (n == 0)
+        return result;
+
+    std::unordered_map<size_t, size_t> indexMap;
+    for (size_t i = 0; i < n; ++i)
+        indexMap[nodes[i].nodeId] = i;
+
+    // Edges by index, ignoring successors that are not part of nodes.
+    std::vector<std::vector<size_t>> successors(n);
+    std::vector<std::vector<size_t>> predecessors(n);
+
+    for (size_t i = 0; i < n; ++i)
+    {
+        for (size_t succId : nodes[i].successors)
+        {
+            auto it = indexMap.find(succId);
+            if (it == indexMap.end() || it->second == i)
+                continue;
+
+            successors[i].push_back(it->second);
+            predecessors[it->second].push_back(i);
+        }
+    }
+
+    // Costs
+    bool hasTimes = false;
+    bool hasCounts = false;
+
+    for (const GraphNodeInfo& info : nodes)
+    {
+        hasTimes |= info.stats.totalUpdateTime.count() > 0;
+        hasCounts |= info.stats.updateCount > 0;
+    }
+
+    std::vector<double> costs(n, 1.0);
+    double maxNodeCost = 0.0;
+
+    for (size_t i = 0; i < n; ++i)
+    {
+        if (hasTimes)
+            costs[i] = static_cast<double>(nodes[i].stats.totalUpdateTime.count());
+        else if (hasCounts)
+            costs[i] = static_cast<double>(nodes[i].stats.updateCount);
+
+        result.totalCost += costs[i];
+        maxNodeCost = (std::max)(maxNodeCost, costs[i]);
+    }
+
+    const double targetCost = result.totalCost / static_cast<double>(k);
+    const double maxCost = (std::max)(targetCost * options.maxImbalance, maxNodeCost);
+
+    // Depth-first topological order, which keeps chains of nodes together.
+    std::vector<size_t> order;
+    order.reserve(n);
+
+    {
+        std::vector<char> isVisited(n, 0);
+        std::vector<std::pair<size_t, size_t>> stack;
+
+        auto visit = [&] (size_t root)
+            {
+                isVisited[root] = 1;
+                stack.emplace_back(root, 0);
+
+                while (!stack.empty())
+                {
+                    auto& top = stack.back();
+
+                    if (top.second < successors[top.first].size())
+                    {
+                        size_t j = successors[top.first][top.second++];
+
+                        if (!isVisited[j])
+                        {
+                            isVisited[j] = 1;
+                            stack.emplace_back(j, 0);
+                        }
+                    }
+                    else
+                    {
+                        order.push_back(top.first);
+                        stack.pop_back();
+                    }
+                }
+            };
+
+        for (size_t i = 0; i < n; ++i)
+            if (predecessors[i].empty())
+                visit(i);
+
+        // Only reached if the input has cycles.
+        for (size_t i = 0; i < n; ++i)
+            if (!isVisited[i])
+                visit(i);
+
+        std::reverse(order.begin(), order.end());
+    }
+
+    // Weakly connected components
+    std::vector<size_t> components(n);
+    for (size_t i = 0; i < n; ++i)
+        components[i] = i;
+
+    auto findRoot = [&] (size_t i)
+        {
+            while (components[i] != i)
+                i = components[i] = components[components[i]];
+            return i;
+        };
+
+    for (size_t i = 0; i < n; ++i)
+        for (size_t j : successors[i])
+            components[findRoot(i)] = findRoot(j);
+
+    std::unordered_map<size_t, double> componentCosts;
+    for (size_t i = 0; i < n; ++i)
+        componentCosts[findRoot(i)] += costs[i];
+
+    std::vector<int> assignment(n, -1);
+    std::vector<double> partCosts(k, 0.0);
+    std::vector<size_t> partSizes(k, 0);
+
+    auto assign = [&] (size_t i, int part)
+        {
+            assignment[i] = part;
+            partCosts[part] += costs[i];
+            partSizes[part] += 1;
+        };
+
+    // Components that don't fit are cut into consecutive pieces of the topological order, so every
+    // edge between their pieces points to a part with a higher index.
+    {
+        size_t part = 0;
+
+        for (size_t i : order)
+        {
+            if (componentCosts[findRoot(i)] <= targetCost)
+                continue;
+
+            if (part + 1 < k && partSizes[part] > 0 && partCosts[part] + costs[i] / 2.0 > targetCost)
+                ++part;
+
+            assign(i, static_cast<int>(part));
+        }
+    }
+
+    // Remaining components go to the cheapest part, largest first.
+    {
+        std::vector<std::pair<double, size_t>> smallComponents;
+
+        for (const auto& e : componentCosts)
+            if (e.second <= targetCost)
+                smallComponents.emplace_back(e.second, e.first);
+
+        std::sort(smallComponents.begin(), smallComponents.end(),
+            [] (const auto& a, const auto& b) { return a.first > b.first || (a.first == b.first && a.second < b.second); });
+
+        std::unordered_map<size_t, int> componentParts;
+
+        for (const auto& c : smallComponents)
+        {
+            auto cheapest = std::min_element(partCosts.begin(), partCosts.end());
+            componentParts[c.second] = static_cast<int>(cheapest - partCosts.begin());
+
+            // Reserve the cost now, so the next component sees it.
+            *cheapest += c.first;
+        }
+
+        for (size_t i : order)
+        {
+            if (assignment[i] >= 0)
+                continue;
+
+            int part = componentParts[findRoot(i)];
+
+            assignment[i] = part;
+            partSizes[part] += 1;
+        }
+    }
+
+    // Number of edges between each pair of parts, to keep the parts acyclic while refining.
+    std::vector<size_t> partEdges(k * k, 0);
+
+    for (size_t i = 0; i < n; ++i)
+        for (size_t j : successors[i])
+            if (assignment[i] != assignment[j])
+                ++partEdges[assignment[i] * k + assignment[j]];
+
+    auto isAcyclic = [&]
+        {
+            std::vector<size_t> inDegrees(k, 0);
+
+            for (size_t a = 0; a < k; ++a)
+                for (size_t b = 0; b < k; ++b)
+                    if (partEdges[a * k + b] > 0)
+                        ++inDegrees[b];
+
+            std::vector<size_t> ready;
+            for (size_t a = 0; a < k; ++a)
+                if (inDegrees[a] == 0)
+                    ready.push_back(a);
+
+            size_t visitedCount = 0;
+
+            while (!ready.empty())
+            {
+                size_t a = ready.back();
+                ready.pop_back();
+                ++visitedCount;
+
+                for (size_t b = 0; b < k; ++b)
+                    if (partEdges[a * k + b] > 0 && --inDegrees[b] == 0)
+                        ready.push_back(b);
+            }
+
+            return visitedCount == k;
+        };
+
+    auto updateEdges = [&] (size_t i, int from, int to)
+        {
+            for (size_t j : successors[i])
+            {
+                int p = assignment[j];
+                if (from != p)
+                    --partEdges[from * k + p];
+                if (to != p)
+                    ++partEdges[to * k + p];
+            }
+
+            for (size_t j : predecessors[i])
+            {
+                int p = assignment[j];
+                if (p != from)
+                    --partEdges[p * k + from];
+                if (p != to)
+                    ++partEdges[p * k + to];
+            }
+        };
+
+    // Refinement: move boundary nodes to the neighboring part that removes the most cut edges.
+    std::vector<int> neighborCounts(k, 0);
+
+    for (int pass = 0; pass < options.refinementPasses; ++pass)
+    {
+        bool hasMoved = false;
+
+        for (size_t i : order)
+        {
+            int from = assignment[i];
+
+            if (partSizes[from] <= 1)
+                continue;
+
+            std::fill(neighborCounts.begin(), neighborCounts.end(), 0);
+
+            for (size_t j : successors[i])
+                ++neighborCounts[assignment[j]];
+            for (size_t j : predecessors[i])
+                ++neighborCounts[assignment[j]];
+
+            int bestPart = -1;
+            int bestGain = 0;
+
+            for (size_t to = 0; to < k; ++to)
+            {
+                int gain = neighborCounts[to] - neighborCounts[from];
+
+                if (static_cast<int>(to) == from || neighborCounts[to] == 0 || gain < bestGain)
+                    continue;
+
+                // Moves without gain are only taken if they improve the balance.
+                if (gain == 0 && partCosts[to] + costs[i] >= partCosts[from])
+                    continue;
+
+                if (partCosts[to] + costs[i] > maxCost)
+                    continue;
+
+                if (gain > bestGain || bestPart < 0)
+                {
+                    bestPart = static_cast<int>(to);
+                    bestGain = gain;
+                }
+            }
+
+            if (bestPart < 0)
+                continue;
+
+            updateEdges(i, from, bestPart);
+
+            if (!isAcyclic())
+            {
+                updateEdges(i, bestPart, from);
+                continue;
+            }
+
+            assignment[i] = bestPart;
+            partCosts[from] -= costs[i];
+            partCosts[bestPart] += costs[i];
+            partSizes[from] -= 1;
+            partSizes[bestPart] += 1;
+
+            // Moves without gain can't repeat forever, because each one strictly improves the balance.
+            hasMoved = true;
+        }
+
+        if (!hasMoved)
+            break;
+    }
+
+    // Drop empty parts.
+    std::vector<int> partIndices(k, -1);
+    {
+        int partIndex = 0;
+
+        for (size_t i : order)
+            if (partIndices[assignment[i]] < 0)
+                partIndices[assignment[i]] = partIndex++;
+
+        result.parts.resize(partIndex);
+    }
+
+    for (size_t i = 0; i < n; ++i)
+    {
+        int part = partIndices[assignment[i]];
+        assignment[i] = part;
+
+        result.parts[part].nodeIds.push_back(nodes[i].nodeId);
+        result.parts[part].cost += costs[i];
+        result.nodeParts[nodes[i].nodeId] = part;
+
+        if (!nodes[i].debugName.empty())
+            result.namedNodeParts[nodes[i].debugName] = part;
+    }
+
+    for (size_t i = 0; i < n; ++i)
+    {
+        std::vector<int> targetParts;
+
+        for (size_t j : successors[i])
+        {
+            if (assignment[j] == assignment[i])
+                continue;
+
+            ++result.cutEdgeCount;
+
+            if (std::find(targetParts.begin(), targetParts.end(), assignment[j]) == targetParts.end())
+                targetParts.push_back(assignment[j]);
+        }
+
+        std::sort(targetParts.begin(), targetParts.end());
+
+        for (int targetPart : targetParts)
+            result.links.push_back({ nodes[i].nodeId, assignment[i], targetPart });
+    }
+
+    return result;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/// Writes a human-readable summary of a partition.
+///////////////////////////////////////////////////////////////////////////////////////////////////
+inline void WritePartitionReport(std::ostream& out, const GraphPartition& partition)
+{
+    out << "Parts:          " << partition.parts.size() << "\n";
+    out << "Total cost:     " << partition.totalCost << "\n";
+    out << "Imbalance:      " << partition.GetImbalance() << "\n";
+    out << "Cut edges:      " << partition.cutEdgeCount << "\n";
+    out << "Links:          " << partition.links.size() << "\n";
+
+    std::vector<size_t> inLinkCounts(partition.parts.size(), 0);
+    std::vector<size_t> outLinkCounts(partition.parts.size(), 0);
+
+    for (const GraphPartition::Link& link : partition.links)
+    {
+        ++outLinkCounts[link.sourcePart];
+        ++inLinkCounts[link.targetPart];
+    }
+
+    out << "\nPart\tNodes\tCost\tShare\tIn links\tOut links\n";
+
+    for (size_t i = 0; i < partition.parts.size(); ++i)
+    {
+        const GraphPartition::Part& part = partition.parts[i];
+        double share = partition.totalCost > 0.0 ? part.cost / partition.totalCost : 0.0;
+
+        out << i << "\t" << part.nodeIds.size() << "\t" << part.cost << "\t" << share << "\t"
+            << inLinkCounts[i] << "\t" << outLinkCounts[i] << "\n";
+    }
+}
+
+/******************************************/ REACT_END /******************************************/
+
+#endif // REACT_ANALYSIS_H_INCLUDED
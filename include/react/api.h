@@ -9,6 +9,9 @@
 
 #pragma once
 
+#include <chrono>
+#include <cstdint>
+#include <string>
 #include <type_traits>
 #include <vector>
 
@@ -31,11 +34,106 @@ enum class TransactionFlags
 {
     none            = 0,
     allow_merging   = 1 << 1,
-    sync_linked     = 1 << 2
+    sync_linked     = 1 << 2,
+    priority_high   = 1 << 3,
+    priority_low    = 1 << 4
 };
 
 REACT_DEFINE_BITMASK_OPERATORS(TransactionFlags)
 
+enum class QueueOverflowPolicy
+{
+    block,
+    fail,
+    drop_oldest_mergeable
+};
+
+struct TransactionQueueStats
+{
+    size_t depth            = 0;
+    size_t rejectedCount    = 0;
+    size_t droppedCount     = 0;
+};
+
+struct NodeStats
+{
+    size_t                      nodeId          = 0;
+    const char*                 typeName        = "";
+    uint64_t                    updateCount     = 0;
+    uint64_t                    changedCount    = 0;
+    uint64_t                    eventCount      = 0;
+    std::chrono::nanoseconds    totalUpdateTime { 0 };
+    std::chrono::nanoseconds    maxUpdateTime   { 0 };
+};
+
+struct GraphNodeInfo
+{
+    size_t              nodeId      = 0;
+    std::string         debugName;
+    const char*         typeName    = "";
+    const char*         category    = "";
+    int                 level       = 0;
+    std::vector<size_t> successors;
+    NodeStats           stats;
+};
+
+struct NodeMemoryUsage
+{
+    const char* typeName        = "";
+    const char* category        = "";
+    size_t      nodeCount       = 0;
+    size_t      objectBytes     = 0;    // Node objects, including their shared_ptr control blocks
+    size_t      successorBytes  = 0;    // Capacity of the successor lists
+    size_t      bufferBytes     = 0;    // Capacity of buffers owned by the nodes, like event storage
+
+    size_t GetTotalBytes() const
+        { return objectBytes + successorBytes + bufferBytes; }
+};
+
+struct GraphMemoryUsage
+{
+    size_t                          nodeCount           = 0;
+    size_t                          nodeDataBytes       = 0;    // Per-node data of the graph, including unused slots
+    size_t                          nodeDataSlackBytes  = 0;    // Unused slots of the node data
+    std::vector<NodeMemoryUsage>    categories;                 // One per category, typeName is empty
+    std::vector<NodeMemoryUsage>    types;                      // One per type and category, by total bytes descending
+
+    size_t GetTotalBytes() const
+    {
+        size_t result = nodeDataBytes;
+        for (const NodeMemoryUsage& usage : categories)
+            result += usage.GetTotalBytes();
+        return result;
+    }
+};
+
+#if defined(REACT_ENABLE_NODE_STATS)
+    static constexpr bool is_node_stats_enabled = true;
+#else
+    static constexpr bool is_node_stats_enabled = false;
+#endif
+
+enum class ObserverOverflowPolicy
+{
+    block,
+    drop_newest
+};
+
+struct AsyncObserverOptions
+{
+    size_t                  capacity    = 64;
+    ObserverOverflowPolicy  policy      = ObserverOverflowPolicy::block;
+};
+
+static constexpr AsyncObserverOptions async_observer = { };
+
+struct CoalescedObserverOptions
+{
+    std::chrono::steady_clock::duration interval = std::chrono::steady_clock::duration::zero();
+};
+
+static constexpr CoalescedObserverOptions coalesced_observer = { };
+
 enum class Token { value };
 
 enum class InPlaceTag
@@ -45,6 +143,13 @@ enum class InPlaceTag
 
 static constexpr InPlaceTag in_place = InPlaceTag::value;
 
+enum class WithStatusTag
+{
+    value = 1
+};
+
+static constexpr WithStatusTag with_status = WithStatusTag::value;
+
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 /// API types
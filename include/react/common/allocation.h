@@ -0,0 +1,295 @@
+//          Copyright Sebastian Jeckel 2017.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef REACT_COMMON_ALLOCATION_H_INCLUDED
+#define REACT_COMMON_ALLOCATION_H_INCLUDED
+
+#pragma once
+
+#include "react/detail/defs.h"
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+/*****************************************/ REACT_BEGIN /*****************************************/
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/// AllocationStats
+///////////////////////////////////////////////////////////////////////////////////////////////////
+struct AllocationStats
+{
+    uint64_t    allocationCount     = 0;
+    uint64_t    deallocationCount   = 0;
+    uint64_t    allocatedBytes      = 0;
+};
+
+/******************************************/ REACT_END /******************************************/
+
+/***************************************/ REACT_IMPL_BEGIN /**************************************/
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/// AllocationCounters
+/// Updated by the allocation hooks. Constant-initialized, so they can be used before main.
+///////////////////////////////////////////////////////////////////////////////////////////////////
+struct AllocationCounters
+{
+    std::atomic<uint64_t>   allocationCount     { 0 };
+    std::atomic<uint64_t>   deallocationCount   { 0 };
+    std::atomic<uint64_t>   allocatedBytes      { 0 };
+
+    AllocationStats Get() const
+    {
+        AllocationStats result;
+        result.allocationCount = allocationCount.load(std::memory_order_relaxed);
+        result.deallocationCount = deallocationCount.load(std::memory_order_relaxed);
+        result.allocatedBytes = allocatedBytes.load(std::memory_order_relaxed);
+        return result;
+    }
+
+    void Reset()
+    {
+        allocationCount.store(0, std::memory_order_relaxed);
+        deallocationCount.store(0, std::memory_order_relaxed);
+        allocatedBytes.store(0, std::memory_order_relaxed);
+    }
+};
+
+inline AllocationCounters& GetGlobalAllocationCounters()
+{
+    static AllocationCounters counters;
+    return counters;
+}
+
+// Only accessed by its own thread, so it doesn't have to be atomic.
+// Constant-initialized, so it can be used while the thread starts or exits.
+inline AllocationStats& GetThreadAllocationCounters()
+{
+    thread_local AllocationStats counters;
+    return counters;
+}
+
+// Counters of the group that is processing a transaction on this thread, if any.
+inline AllocationCounters*& GetLocalAllocationTarget()
+{
+    thread_local AllocationCounters* target = nullptr;
+    return target;
+}
+
+inline void RecordAllocation(size_t size)
+{
+    AllocationCounters& global = GetGlobalAllocationCounters();
+    global.allocationCount.fetch_add(1, std::memory_order_relaxed);
+    global.allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+
+    AllocationStats& local = GetThreadAllocationCounters();
+    local.allocationCount += 1;
+    local.allocatedBytes += size;
+
+    if (AllocationCounters* target = GetLocalAllocationTarget())
+    {
+        target->allocationCount.fetch_add(1, std::memory_order_relaxed);
+        target->allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+    }
+}
+
+inline void RecordDeallocation()
+{
+    GetGlobalAllocationCounters().deallocationCount.fetch_add(1, std::memory_order_relaxed);
+    GetThreadAllocationCounters().deallocationCount += 1;
+
+    if (AllocationCounters* target = GetLocalAllocationTarget())
+        target->deallocationCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/// AllocationTargetScope
+/// Attributes allocations on this thread to the given counters until the scope ends.
+///////////////////////////////////////////////////////////////////////////////////////////////////
+class AllocationTargetScope
+{
+public:
+    explicit AllocationTargetScope(AllocationCounters& target) :
+        previous_( GetLocalAllocationTarget() )
+    {
+        GetLocalAllocationTarget() = &target;
+    }
+
+    AllocationTargetScope(const AllocationTargetScope&) = delete;
+    AllocationTargetScope& operator=(const AllocationTargetScope&) = delete;
+
+    ~AllocationTargetScope()
+        { GetLocalAllocationTarget() = previous_; }
+
+private:
+    AllocationCounters* previous_;
+};
+
+inline void* AllocateTracked(size_t size)
+{
+    RecordAllocation(size);
+
+    if (void* p = std::malloc(size > 0 ? size : 1))
+        return p;
+
+    throw std::bad_alloc{ };
+}
+
+inline void* AllocateTracked(size_t size, size_t alignment)
+{
+    RecordAllocation(size);
+
+    void* p = nullptr;
+
+#if defined(_MSC_VER)
+    p = _aligned_malloc(size > 0 ? size : 1, alignment);
+#else
+    if (posix_memalign(&p, alignment < sizeof(void*) ? sizeof(void*) : alignment, size > 0 ? size : 1) != 0)
+        p = nullptr;
+#endif
+
+    if (p == nullptr)
+        throw std::bad_alloc{ };
+
+    return p;
+}
+
+inline void DeallocateTracked(void* p)
+{
+    if (p == nullptr)
+        return;
+
+    RecordDeallocation();
+    std::free(p);
+}
+
+inline void DeallocateTrackedAligned(void* p)
+{
+    if (p == nullptr)
+        return;
+
+    RecordDeallocation();
+
+#if defined(_MSC_VER)
+    _aligned_free(p);
+#else
+    std::free(p);
+#endif
+}
+
+/****************************************/ REACT_IMPL_END /***************************************/
+
+/*****************************************/ REACT_BEGIN /*****************************************/
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/// Allocation tracking
+/// Allocations are only counted in programs that replace the global operator new and delete with
+/// REACT_DEFINE_ALLOCATION_HOOKS in exactly one translation unit. Otherwise, all counts are zero.
+///
+/// If REACT_ENABLE_ALLOCATION_TRACKING is defined when building the library and its users, each
+/// group additionally counts the allocations made on the thread processing its transactions,
+/// see Group::GetAllocationStats.
+///////////////////////////////////////////////////////////////////////////////////////////////////
+#if defined(REACT_ENABLE_ALLOCATION_TRACKING)
+    static constexpr bool is_allocation_tracking_enabled = true;
+#else
+    static constexpr bool is_allocation_tracking_enabled = false;
+#endif
+
+/// Returns the allocations of all threads since the program started.
+inline AllocationStats GetAllocationStats()
+    { return REACT_IMPL::GetGlobalAllocationCounters().Get(); }
+
+/// Returns the allocations of the calling thread since it started.
+inline AllocationStats GetThreadAllocationStats()
+    { return REACT_IMPL::GetThreadAllocationCounters(); }
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/// AllocationTracker
+/// Counts the allocations of the calling thread between construction (or the last Reset) and
+/// GetStats, so other threads of the program don't disturb the result. Must only be used by the
+/// thread that created it. Allocations on workers of a group are counted by the group instead.
+///////////////////////////////////////////////////////////////////////////////////////////////////
+class AllocationTracker
+{
+public:
+    AllocationTracker() :
+        start_( GetThreadAllocationStats() )
+    { }
+
+    AllocationStats GetStats() const
+    {
+        AllocationStats now = GetThreadAllocationStats();
+
+        AllocationStats result;
+        result.allocationCount = now.allocationCount - start_.allocationCount;
+        result.deallocationCount = now.deallocationCount - start_.deallocationCount;
+        result.allocatedBytes = now.allocatedBytes - start_.allocatedBytes;
+        return result;
+    }
+
+    void Reset()
+        { start_ = GetThreadAllocationStats(); }
+
+private:
+    AllocationStats start_;
+};
+
+/******************************************/ REACT_END /******************************************/
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/// Instrumentation macros
+///////////////////////////////////////////////////////////////////////////////////////////////////
+#define REACT_DEFINE_ALLOCATION_HOOKS \
+    void* operator new(std::size_t size) \
+        { return REACT_IMPL::AllocateTracked(size); } \
+    void* operator new[](std::size_t size) \
+        { return REACT_IMPL::AllocateTracked(size); } \
+    void* operator new(std::size_t size, const std::nothrow_t&) noexcept \
+        { try { return REACT_IMPL::AllocateTracked(size); } catch (...) { return nullptr; } } \
+    void* operator new[](std::size_t size, const std::nothrow_t&) noexcept \
+        { try { return REACT_IMPL::AllocateTracked(size); } catch (...) { return nullptr; } } \
+    void operator delete(void* p) noexcept \
+        { REACT_IMPL::DeallocateTracked(p); } \
+    void operator delete[](void* p) noexcept \
+        { REACT_IMPL::DeallocateTracked(p); } \
+    void operator delete(void* p, std::size_t) noexcept \
+        { REACT_IMPL::DeallocateTracked(p); } \
+    void operator delete[](void* p, std::size_t) noexcept \
+        { REACT_IMPL::DeallocateTracked(p); } \
+    void operator delete(void* p, const std::nothrow_t&) noexcept \
+        { REACT_IMPL::DeallocateTracked(p); } \
+    void operator delete[](void* p, const std::nothrow_t&) noexcept \
+        { REACT_IMPL::DeallocateTracked(p); } \
+    REACT_DEFINE_ALIGNED_ALLOCATION_HOOKS
+
+// Over-aligned new and delete only exist since C++17.
+#if defined(__cpp_aligned_new)
+    #define REACT_DEFINE_ALIGNED_ALLOCATION_HOOKS \
+        void* operator new(std::size_t size, std::align_val_t alignment) \
+            { return REACT_IMPL::AllocateTracked(size, static_cast<std::size_t>(alignment)); } \
+        void* operator new[](std::size_t size, std::align_val_t alignment) \
+            { return REACT_IMPL::AllocateTracked(size, static_cast<std::size_t>(alignment)); } \
+        void operator delete(void* p, std::align_val_t) noexcept \
+            { REACT_IMPL::DeallocateTrackedAligned(p); } \
+        void operator delete[](void* p, std::align_val_t) noexcept \
+            { REACT_IMPL::DeallocateTrackedAligned(p); } \
+        void operator delete(void* p, std::size_t, std::align_val_t) noexcept \
+            { REACT_IMPL::DeallocateTrackedAligned(p); } \
+        void operator delete[](void* p, std::size_t, std::align_val_t) noexcept \
+            { REACT_IMPL::DeallocateTrackedAligned(p); }
+#else
+    #define REACT_DEFINE_ALIGNED_ALLOCATION_HOOKS
+#endif
+
+#if defined(REACT_ENABLE_ALLOCATION_TRACKING)
+    #define REACT_ALLOCATION_TARGET_SCOPE(counters) \
+        REACT_IMPL::AllocationTargetScope allocationTargetScope_( counters )
+#else
+    #define REACT_ALLOCATION_TARGET_SCOPE(counters) ((void)0)
+#endif
+
+#endif // REACT_COMMON_ALLOCATION_H_INCLUDED
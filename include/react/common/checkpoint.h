@@ -0,0 +1,209 @@
+//          Copyright Sebastian Jeckel 2017.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef REACT_COMMON_CHECKPOINT_H_INCLUDED
+#define REACT_COMMON_CHECKPOINT_H_INCLUDED
+
+#pragma once
+
+#include "react/detail/defs.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+/*****************************************/ REACT_BEGIN /*****************************************/
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/// Appends raw bytes to a binary checkpoint image.
+///////////////////////////////////////////////////////////////////////////////////////////////////
+class CheckpointWriter
+{
+public:
+    explicit CheckpointWriter(std::vector<char>& buffer) :
+        buffer_( buffer )
+    { }
+
+    void Write(const void* data, size_t size)
+    {
+        const char* p = static_cast<const char*>(data);
+        buffer_.insert(buffer_.end(), p, p + size);
+    }
+
+    template <typename T>
+    void WriteValue(const T& value)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "WriteValue requires a trivially copyable type.");
+        Write(&value, sizeof(T));
+    }
+
+    /// Returns the current write position. It can be used to patch or truncate the image later.
+    size_t Tell() const
+        { return buffer_.size(); }
+
+    void Patch(size_t pos, const void* data, size_t size)
+        { std::memcpy(&buffer_[pos], data, size); }
+
+    void Truncate(size_t pos)
+        { buffer_.resize(pos); }
+
+private:
+    std::vector<char>& buffer_;
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/// Reads raw bytes from a binary checkpoint image.
+/// The reader does not own the image, so it can be used on top of a memory-mapped file.
+/// All read operations fail instead of reading past the end.
+///////////////////////////////////////////////////////////////////////////////////////////////////
+class CheckpointReader
+{
+public:
+    CheckpointReader(const void* data, size_t size) :
+        cur_( static_cast<const char*>(data) ),
+        end_( static_cast<const char*>(data) + size )
+    { }
+
+    bool Read(void* data, size_t size)
+    {
+        if (Remaining() < size)
+            return false;
+
+        std::memcpy(data, cur_, size);
+        cur_ += size;
+        return true;
+    }
+
+    template <typename T>
+    bool ReadValue(T& value)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "ReadValue requires a trivially copyable type.");
+        return Read(&value, sizeof(T));
+    }
+
+    /// Splits off the next size bytes as a separate reader.
+    bool ReadRange(size_t size, CheckpointReader& range)
+    {
+        if (Remaining() < size)
+            return false;
+
+        range = CheckpointReader{ cur_, size };
+        cur_ += size;
+        return true;
+    }
+
+    size_t Remaining() const
+        { return static_cast<size_t>(end_ - cur_); }
+
+    bool IsAtEnd() const
+        { return cur_ == end_; }
+
+private:
+    const char* cur_;
+    const char* end_;
+};
+
+/// Combines a kind character with a size or the tag of an element type.
+/// Tags only have to differ between formats that could be mistaken for each other.
+constexpr uint64_t MakeCheckpointTypeTag(char kind, uint64_t value)
+    { return (value << 8) | static_cast<unsigned char>(kind); }
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/// Defines how a state value is stored in a checkpoint.
+/// Arithmetic types, enums, strings and vectors thereof are supported out of the box.
+/// Other types can be made serializable by specializing this template. Besides Save and Load,
+/// a specialization provides a type_tag that identifies its format. Images are only loaded into
+/// nodes with the same tag.
+///////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename T, typename = void>
+struct CheckpointTraits
+{
+    static constexpr bool is_serializable = false;
+};
+
+template <typename T>
+struct CheckpointTraits<T, std::enable_if_t<std::is_arithmetic<T>::value || std::is_enum<T>::value>>
+{
+    static constexpr bool is_serializable = true;
+
+    static constexpr uint64_t type_tag = MakeCheckpointTypeTag(
+        std::is_same<T, bool>::value ? 'b' :
+        std::is_enum<T>::value ? 'e' :
+        std::is_floating_point<T>::value ? 'f' :
+        std::is_signed<T>::value ? 'i' : 'u', sizeof(T));
+
+    static void Save(CheckpointWriter& out, const T& value)
+        { out.WriteValue(value); }
+
+    static bool Load(CheckpointReader& in, T& value)
+        { return in.ReadValue(value); }
+};
+
+template <>
+struct CheckpointTraits<std::string>
+{
+    static constexpr bool is_serializable = true;
+
+    static constexpr uint64_t type_tag = MakeCheckpointTypeTag('s', sizeof(char));
+
+    static void Save(CheckpointWriter& out, const std::string& value)
+    {
+        out.WriteValue(static_cast<uint64_t>(value.size()));
+        out.Write(value.data(), value.size());
+    }
+
+    static bool Load(CheckpointReader& in, std::string& value)
+    {
+        uint64_t size;
+        if (!in.ReadValue(size) || in.Remaining() < size)
+            return false;
+
+        value.resize(static_cast<size_t>(size));
+        return in.Read(&value[0], value.size());
+    }
+};
+
+template <typename T>
+struct CheckpointTraits<std::vector<T>, std::enable_if_t<CheckpointTraits<T>::is_serializable>>
+{
+    static constexpr bool is_serializable = true;
+
+    static constexpr uint64_t type_tag = MakeCheckpointTypeTag('v', CheckpointTraits<T>::type_tag);
+
+    static void Save(CheckpointWriter& out, const std::vector<T>& value)
+    {
+        out.WriteValue(static_cast<uint64_t>(value.size()));
+
+        for (const T& e : value)
+            CheckpointTraits<T>::Save(out, e);
+    }
+
+    static bool Load(CheckpointReader& in, std::vector<T>& value)
+    {
+        uint64_t size;
+        if (!in.ReadValue(size))
+            return false;
+
+        value.clear();
+        value.reserve(static_cast<size_t>((std::min)(size, static_cast<uint64_t>(in.Remaining()))));
+
+        for (uint64_t i = 0; i < size; ++i)
+        {
+            T e;
+            if (!CheckpointTraits<T>::Load(in, e))
+                return false;
+            value.push_back(std::move(e));
+        }
+
+        return true;
+    }
+};
+
+/******************************************/ REACT_END /******************************************/
+
+#endif // REACT_COMMON_CHECKPOINT_H_INCLUDED
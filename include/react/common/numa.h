@@ -0,0 +1,70 @@
+//          Copyright Sebastian Jeckel 2017.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef REACT_COMMON_NUMA_H_INCLUDED
+#define REACT_COMMON_NUMA_H_INCLUDED
+
+#pragma once
+
+#include "react/detail/defs.h"
+
+#include <cstddef>
+#include <cstdint>
+
+/***************************************/ REACT_IMPL_BEGIN /**************************************/
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/// NUMA placement
+/// Placement is best effort. Where the platform doesn't support it, or the node doesn't exist,
+/// the functions do nothing and return false.
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+/// Moves the pages that are completely inside [p, p + size) to the given node and keeps them there.
+/// Only supported on Linux. Elsewhere, memory is placed on the node of the thread that first touches it.
+bool BindMemoryToNumaNode(const void* p, size_t size, int numaNode);
+
+/// Restores the default policy for the pages that are completely inside [p, p + size).
+/// Memory that was bound has to be unbound before it is freed, or the heap keeps reusing it with the old placement.
+bool UnbindMemoryFromNumaNode(const void* p, size_t size);
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/// NumaThreadScope
+/// Restricts the current thread to the processors of a NUMA node until the scope ends.
+/// A negative node leaves the thread as it is, as does a node that the thread is already bound to by an outer scope.
+/// The processors of each node are only read once per process.
+///////////////////////////////////////////////////////////////////////////////////////////////////
+class NumaThreadScope
+{
+public:
+    explicit NumaThreadScope(int numaNode);
+
+    NumaThreadScope(const NumaThreadScope&) = delete;
+    NumaThreadScope& operator=(const NumaThreadScope&) = delete;
+
+    ~NumaThreadScope();
+
+    bool IsBound() const
+        { return isBound_; }
+
+private:
+    bool isBound_ = false;
+
+    // Node of the enclosing scope on this thread, restored when this one ends.
+    int previousNumaNode_ = -1;
+
+    // Previous affinity of the thread, in the format of the platform.
+    alignas(8) unsigned char previousAffinity_[128];
+};
+
+/****************************************/ REACT_IMPL_END /***************************************/
+
+/*****************************************/ REACT_BEGIN /*****************************************/
+
+/// Returns the number of NUMA nodes of this machine. Returns 1 if it can't be determined.
+int GetNumaNodeCount();
+
+/******************************************/ REACT_END /******************************************/
+
+#endif // REACT_COMMON_NUMA_H_INCLUDED
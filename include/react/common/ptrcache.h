@@ -11,19 +11,26 @@
 
 #include "react/detail/Defs.h"
 
+#include <array>
+#include <cstddef>
+#include <functional>
 #include <memory>
 #include <mutex>
+#include <shared_mutex>
 #include <unordered_map>
 
 /*****************************************/ REACT_BEGIN /*****************************************/
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 /// A cache to objects of type shared_ptr<V> that stores weak pointers.
-/// Thread-safe.
+/// Thread-safe. Keys are distributed over independently locked shards.
+/// Lookups that hit only take a shared lock on their shard, so concurrent readers don't block each other.
 ///////////////////////////////////////////////////////////////////////////////////////////////////
-template <typename K, typename V>
+template <typename K, typename V, size_t N = 16>
 class WeakPtrCache
 {
+    static_assert(N > 0, "WeakPtrCache requires at least one shard.");
+
 public:
     /// Returns a shared pointer to an object that existings in the cache, indexed by key.
     /// If no hit was found, createFunc is used to construct the object managed by shared pointer.
@@ -31,39 +38,76 @@ public:
     template <typename F>
     std::shared_ptr<V> LookupOrCreate(const K& key, F&& createFunc)
     {
-        std::lock_guard<std::mutex> scopedLock(mutex_);
+        Shard& shard = GetShard(key);
 
-        auto it = map_.find(key);
-        if (it != map_.end())
+        // Fast path.
+        {
+            std::shared_lock<std::shared_timed_mutex> scopedLock(shard.mutex);
+
+            auto it = shard.map.find(key);
+            if (it != shard.map.end())
+            {
+                if (auto ptr = it->second.lock())
+                    return ptr;
+            }
+        }
+
+        std::lock_guard<std::shared_timed_mutex> scopedLock(shard.mutex);
+
+        // Another thread might have created the object in the meantime.
+        auto it = shard.map.find(key);
+        if (it != shard.map.end())
         {
             // Lock fails, if the object was cached before, but has been released already.
             // In that case we re-create it.
             if (auto ptr = it->second.lock())
-            {
                 return ptr;
-            }
         }
 
         std::shared_ptr<V> v = createFunc();
-        auto res = map_.emplace(key, v);
+        shard.map[key] = v;
         return v;
     }
 
-    /// Removes an entry from the cache.
+    /// Removes an entry from the cache, if the object it refers to has been released.
+    /// Entries that have been re-created for the same key in the meantime are kept.
     void Erase(const K& key)
     {
-        std::lock_guard<std::mutex> scopedLock(mutex_);
+        Shard& shard = GetShard(key);
 
-        auto it = map_.find(key);
-        if (it != map_.end())
-        {
-            map_.erase(it);
-        }
+        std::lock_guard<std::shared_timed_mutex> scopedLock(shard.mutex);
+
+        auto it = shard.map.find(key);
+        if (it != shard.map.end() && it->second.expired())
+            shard.map.erase(it);
     }
 
 private:
-    std::mutex mutex_;
-    std::unordered_map<K, std::weak_ptr<V>> map_;
+    static const size_t cache_line_size = 64;
+
+    // Shards are padded instead of over-aligned. The cache is a member of objects created with make_shared,
+    // which doesn't have to honor extended alignment before C++17. A full line of padding keeps
+    // neighbouring shards apart regardless of where the array starts.
+    struct Shard
+    {
+        std::shared_timed_mutex                 mutex;
+        std::unordered_map<K, std::weak_ptr<V>> map;
+
+        char padding[cache_line_size];
+    };
+
+    Shard& GetShard(const K& key)
+    {
+        // Pointer keys have their low bits zeroed due to alignment, so the hash is mixed first.
+        size_t h = std::hash<K>{ }(key);
+        h ^= h >> 16;
+        h *= 0x9E3779B1u;
+        h ^= h >> 16;
+
+        return shards_[h % N];
+    }
+
+    std::array<Shard, N> shards_;
 };
 
 
@@ -16,6 +16,7 @@
 #include <iterator>
 #include <memory>
 #include <type_traits>
+#include <vector>
 
 /*****************************************/ REACT_BEGIN /*****************************************/
 
@@ -49,7 +50,7 @@ public:
         { return reinterpret_cast<T&>(data_[index]); }
 
     const T& operator[](size_t index) const
-        { return reinterpret_cast<T&>(data_[index]); }
+        { return reinterpret_cast<const T&>(data_[index]); }
 
     size_t Insert(T value)
     {
@@ -70,8 +71,8 @@ public:
 
     void Erase(size_t index)
     {
-        // If we erased something other than the last element, save in free index list.
-        if (index != (size_ - 1))
+        // If we erased something other than the last occupied slot, save in free index list.
+        if (index != (size_ + freeSize_ - 1))
         {
             freeIndices_[freeSize_++] = index;
         }
@@ -80,6 +81,46 @@ public:
         --size_;
     }
 
+    /// Calls func(index, value) for each element, in ascending index order.
+    template <typename F>
+    void ForEach(F&& func) const
+    {
+        // Work on a sorted copy of the free indices, so the order of future inserts is not affected.
+        std::vector<size_t> freeIndices(freeIndices_.get(), freeIndices_.get() + freeSize_);
+        std::sort(freeIndices.begin(), freeIndices.end());
+
+        const size_t totalSize = size_ + freeSize_;
+        auto freeIt = freeIndices.begin();
+
+        for (size_t index = 0; index < totalSize; ++index)
+        {
+            if (freeIt != freeIndices.end() && *freeIt == index)
+                ++freeIt;
+            else
+                func(index, GetDataAt(index));
+        }
+    }
+
+    /// Number of slots that are in use or on the free list.
+    size_t GetExtent() const
+        { return size_ + freeSize_; }
+
+    /// Number of elements.
+    size_t GetSize() const
+        { return size_; }
+
+    /// Number of allocated slots.
+    size_t GetCapacity() const
+        { return capacity_; }
+
+    /// Storage of the slots. Changes when the map grows.
+    const void* GetStorage() const
+        { return data_.get(); }
+
+    /// Bytes allocated for slots and the free list.
+    size_t GetAllocatedSize() const
+        { return capacity_ * (sizeof(StorageType) + sizeof(size_t)); }
+
     void Clear()
     {
         // Sort free indexes so we can remove check for them in linear time.
@@ -129,8 +170,8 @@ private:
     T& GetDataAt(size_t index)
         { return reinterpret_cast<T&>(data_[index]); }
 
-    T& GetDataAt(size_t index) const
-        { return reinterpret_cast<T&>(data_[index]); }
+    const T& GetDataAt(size_t index) const
+        { return reinterpret_cast<const T&>(data_[index]); }
 
     bool IsAtFullCapacity() const
         { return capacity_ == size_; }
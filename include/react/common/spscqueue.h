@@ -0,0 +1,87 @@
+//          Copyright Sebastian Jeckel 2017.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef REACT_COMMON_SPSCQUEUE_H_INCLUDED
+#define REACT_COMMON_SPSCQUEUE_H_INCLUDED
+
+#pragma once
+
+#include "react/detail/defs.h"
+#include "react/common/utility.h"
+
+#include <atomic>
+#include <utility>
+#include <vector>
+
+/*****************************************/ REACT_BEGIN /*****************************************/
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/// A bounded single-producer, single-consumer ring buffer.
+/// TryPush may only be called by one thread at a time, and so may TryConsume. Both are lock-free.
+///////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename T>
+class SpscQueue
+{
+public:
+    explicit SpscQueue(size_t capacity) :
+        slots_( capacity + 1 )
+    { }
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    /// Returns false if the queue is full. In that case, value is not moved from.
+    template <typename U>
+    bool TryPush(U&& value)
+    {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        size_t next = Next(tail);
+
+        if (next == head_.load(std::memory_order_acquire))
+            return false;
+
+        slots_[tail].emplace(std::forward<U>(value));
+        tail_.store(next, std::memory_order_release);
+        return true;
+    }
+
+    /// Calls func with the oldest element, then removes it. Returns false if the queue is empty.
+    template <typename F>
+    bool TryConsume(F&& func)
+    {
+        size_t head = head_.load(std::memory_order_relaxed);
+
+        if (head == tail_.load(std::memory_order_acquire))
+            return false;
+
+        func(*slots_[head]);
+        slots_[head].reset();
+
+        head_.store(Next(head), std::memory_order_release);
+        return true;
+    }
+
+    size_t GetCapacity() const
+        { return slots_.size() - 1; }
+
+private:
+    size_t Next(size_t index) const
+        { return index + 1 < slots_.size() ? index + 1 : 0; }
+
+    // One slot is always left empty to tell a full queue from an empty one.
+    std::vector<REACT_IMPL::Optional<T>> slots_;
+
+    static const size_t cache_line_size = 64;
+
+    // Producer and consumer indices are kept on separate cache lines. Padding is used instead of alignas,
+    // because queues are allocated with make_shared, which doesn't have to honor extended alignment before C++17.
+    std::atomic<size_t> head_{ 0 };
+    char                padding_[cache_line_size];
+    std::atomic<size_t> tail_{ 0 };
+};
+
+/******************************************/ REACT_END /******************************************/
+
+#endif // REACT_COMMON_SPSCQUEUE_H_INCLUDED
@@ -12,8 +12,11 @@
 #include "react/detail/defs.h"
 
 #include <algorithm>
+#include <array>
+#include <atomic>
 #include <chrono>
 #include <condition_variable>
+#include <functional>
 #include <iterator>
 #include <mutex>
 #include <vector>
@@ -39,77 +42,133 @@ public:
     class Dependency;
 
 private:
-    class ISyncTarget
+    class SyncPointState
     {
     public:
-        virtual ~ISyncTarget() = default;
+        void IncrementWaitCount()
+        {
+            waitCount_.fetch_add(1, std::memory_order_relaxed);
+        }
 
-        virtual void IncrementWaitCount() = 0;
-        
-        virtual void DecrementWaitCount() = 0;
-    };
+        void DecrementWaitCount()
+        {
+            // Only the last release has to notify, and only if someone is blocked in Wait or a
+            // continuation is pending. Both sides use seq_cst accesses on waitCount_ and waiterCount_,
+            // so either the waiter sees the count has dropped to zero or this sees the registered waiter.
+            if (waitCount_.fetch_sub(1) != 1)
+                return;
 
-    class SyncPointState : public ISyncTarget
-    {
-    public:
-        virtual void IncrementWaitCount() override
-        {// mutex_
-            std::lock_guard<std::mutex> scopedLock(mtx_);
-            ++waitCount_;
-        }// ~mutex_
+            if (waiterCount_.load() == 0)
+                return;
+
+            std::vector<std::function<void()>> continuations;
+
+            {// mutex_
+                std::lock_guard<std::mutex> scopedLock(mtx_);
+
+                // The count might have been raised again in the meantime.
+                // In that case, continuations are left for the next release.
+                if (IsDone())
+                {
+                    continuations.swap(continuations_);
+                    waiterCount_.fetch_sub(static_cast<int>(continuations.size()));
+                }
+            }// ~mutex_
 
-        virtual void DecrementWaitCount() override
-        {// mutex_
+            cv_.notify_all();
+
+            for (auto& func : continuations)
+                func();
+        }
+
+        /// Calls func once the count drops to zero. If it is zero already, func is called immediately.
+        /// Otherwise, it's called by the thread that releases the last dependency.
+        template <typename F>
+        void Then(F&& func)
+        {
+            // func is only moved from if it was stored.
+            if (! TryThen(std::forward<F>(func)))
+                func();
+        }
+
+        /// Like Then, but if the count is zero already, func is not called and false is returned.
+        template <typename F>
+        bool TryThen(F&& func)
+        {
             std::lock_guard<std::mutex> scopedLock(mtx_);
-            --waitCount_;
 
-            if (waitCount_ == 0)
-                cv_.notify_all();
-        }// ~mutex_
+            // A pending continuation counts as a waiter.
+            waiterCount_.fetch_add(1);
+
+            if (! IsDone())
+            {
+                continuations_.emplace_back(std::forward<F>(func));
+                return true;
+            }
+
+            waiterCount_.fetch_sub(1);
+            return false;
+        }
 
         void Wait()
         {
+            if (IsDone())
+                return;
+
             std::unique_lock<std::mutex> lock(mtx_);
-            cv_.wait(lock, [this] { return waitCount_ == 0; });
+            WaiterScope scope(waiterCount_);
+            cv_.wait(lock, [this] { return IsDone(); });
         }
         
         template <typename TRep, typename TPeriod>
         bool WaitFor(const std::chrono::duration<TRep, TPeriod>& relTime)
         {
+            if (IsDone())
+                return true;
+
             std::unique_lock<std::mutex> lock(mtx_);
-            return cv_.wait_for(lock, relTime, [this] { return waitCount_ == 0; });
+            WaiterScope scope(waiterCount_);
+            return cv_.wait_for(lock, relTime, [this] { return IsDone(); });
         }
 
         template <typename TRep, typename TPeriod>
         bool WaitUntil(const std::chrono::duration<TRep, TPeriod>& relTime)
         {
+            if (IsDone())
+                return true;
+
             std::unique_lock<std::mutex> lock(mtx_);
-            return cv_.wait_until(lock, relTime, [this] { return waitCount_ == 0; });
+            WaiterScope scope(waiterCount_);
+            return cv_.wait_until(lock, relTime, [this] { return IsDone(); });
         }
 
+        bool IsDone() const
+            { return waitCount_.load() == 0; }
+
     private:
-        std::mutex              mtx_;
-        std::condition_variable cv_;
+        struct WaiterScope
+        {
+            explicit WaiterScope(std::atomic<int>& waiterCount) :
+                waiterCount_( waiterCount )
+            {
+                waiterCount_.fetch_add(1);
+            }
 
-        int waitCount_ = 0;
-    };
+            ~WaiterScope()
+            {
+                waiterCount_.fetch_sub(1);
+            }
 
-    class SyncTargetCollection : public ISyncTarget
-    {
-    public:
-        virtual void IncrementWaitCount() override
-        {
-            for (const auto& e : targets)
-                e->IncrementWaitCount();
-        }
+            std::atomic<int>& waiterCount_;
+        };
 
-        virtual void DecrementWaitCount() override
-        {
-            for (const auto& e : targets)
-                e->DecrementWaitCount();
-        }
+        std::mutex              mtx_;
+        std::condition_variable cv_;
+
+        std::vector<std::function<void()>> continuations_;
 
-        std::vector<std::shared_ptr<ISyncTarget>> targets;
+        std::atomic<int> waitCount_{ 0 };
+        std::atomic<int> waiterCount_{ 0 };
     };
 
 public:
@@ -146,6 +205,28 @@ public:
         return state_->WaitUntil(relTime);
     }
 
+    /// Returns true if all dependencies of this sync point are released. Does not block.
+    bool IsDone() const
+    {
+        return state_->IsDone();
+    }
+
+    /// Registers a continuation that is called once all dependencies are released.
+    /// If they already are, func is called immediately on the calling thread. Otherwise it's called on the
+    /// thread that releases the last dependency, so it should not block.
+    template <typename F>
+    void Then(F&& func)
+    {
+        state_->Then(std::forward<F>(func));
+    }
+
+    /// Like Then, but if all dependencies are released already, func is not called and false is returned.
+    template <typename F>
+    bool TryThen(F&& func)
+    {
+        return state_->TryThen(std::forward<F>(func));
+    }
+
     /// A RAII-style token object that represents a dependency of a SyncPoint.
     class Dependency
     {
@@ -154,99 +235,135 @@ public:
         Dependency() = default;
 
         /// Constructs a single dependency for a sync point.
-        explicit Dependency(const SyncPoint& sp) :
-            target_( sp.state_ )
+        explicit Dependency(const SyncPoint& sp)
         {
-            target_->IncrementWaitCount();
+            AddTarget(sp.state_);
+            IncrementWaitCounts();
         }
 
         /// Merges an input range of other dependencies into a single dependency.
-        /// This allows to create APIs that are agnostic of how many dependent operations they process.        
+        /// This allows to create APIs that are agnostic of how many dependent operations they process.
+        /// The targets of the merged dependencies are flattened and duplicates are removed.
         template <typename TBegin, typename TEnd>
         Dependency(TBegin first, TEnd last)
         {
-            auto count = std::distance(first, last);
-
-            if (count == 1)
-            {
-                target_ = first->target_;
-                if (target_)
-                    target_->IncrementWaitCount();
-            }
-            else if (count > 1)
-            {
-                auto collection = std::make_shared<SyncTargetCollection>();
-                collection->targets.reserve(count);
-            
-                for (; !(first == last); ++first)
-                    if (first->target_) // There's no point in propagating released/empty dependencies.
-                        collection->targets.push_back(first->target_);
-
-                collection->IncrementWaitCount();
+            // There's no point in propagating released/empty dependencies, they don't have targets.
+            for (; !(first == last); ++first)
+                first->ForEachTarget([this] (const auto& target) { AddTarget(target); });
 
-                target_ = std::move(collection);
-            }
+            IncrementWaitCounts();
         }
 
         /// Copy constructor and assignment split a dependency.
         /// The new dependency that has the same target(s) as other.
-        Dependency(const Dependency& other) :
-            target_( other.target_ )
+        Dependency(const Dependency& other)
         {
-            if (target_)
-                target_->IncrementWaitCount();
+            other.ForEachTarget([this] (const auto& target) { AddTarget(target); });
+            IncrementWaitCounts();
         }
 
         Dependency& operator=(const Dependency& other)
         {
-            if (other.target_)
-                other.target_->IncrementWaitCount();
+            if (this == &other)
+                return *this;
 
-            if (target_)
-                target_->DecrementWaitCount();
+            other.IncrementWaitCounts();
+            Release();
 
-            target_ = other.target_;
+            other.ForEachTarget([this] (const auto& target) { AddTarget(target); });
             return *this;
         }
 
         /// Move constructor and assignment transfer a dependency.
         /// The moved from object is left unbound.
-        Dependency(Dependency&& other) :
-            target_( std::move(other.target_) )
-        { }
+        /// Both are noexcept, so containers of dependencies move them on reallocation instead of copying.
+        Dependency(Dependency&& other) noexcept
+        {
+            MoveTargetsFrom(other);
+        }
 
-        Dependency& operator=(Dependency&& other)
+        Dependency& operator=(Dependency&& other) noexcept
         {
-            if (target_)
-                target_->DecrementWaitCount();
+            if (this == &other)
+                return *this;
 
-            target_ = std::move(other.target_);
+            Release();
+            MoveTargetsFrom(other);
             return *this;
         }
 
         /// The destructor releases a dependency, if it's not unbound.
         ~Dependency()
         {
-            if (target_)
-                target_->DecrementWaitCount();
+            Release();
         }
 
         /// Manually releases the dependency. Afterwards it is unbound.
         void Release()
         {
-            if (target_)
-            {
-                target_->DecrementWaitCount();
-                target_ = nullptr;
-            }
+            ForEachTarget([] (const auto& target) { target->DecrementWaitCount(); });
+            Reset();
         }
 
         /// Returns if a dependency is released, i.e. if it is unbound.
         bool IsReleased() const
-            { return target_ == nullptr; }
+            { return inlineCount_ == 0; }
 
     private:
-        std::shared_ptr<ISyncTarget> target_;
+        static constexpr size_t inline_capacity = 4;
+
+        template <typename F>
+        void ForEachTarget(F&& func) const
+        {
+            for (size_t i = 0; i < inlineCount_; ++i)
+                func(inlineTargets_[i]);
+
+            for (const auto& target : overflowTargets_)
+                func(target);
+        }
+
+        void AddTarget(const std::shared_ptr<SyncPointState>& target)
+        {
+            // Linear search is fine, since dependencies usually have only a few distinct targets.
+            bool isDuplicate = false;
+            ForEachTarget([&] (const auto& other) { isDuplicate |= (other == target); });
+
+            if (isDuplicate)
+                return;
+
+            // Overflow is only used once the inline storage is full.
+            if (inlineCount_ < inline_capacity)
+                inlineTargets_[inlineCount_++] = target;
+            else
+                overflowTargets_.push_back(target);
+        }
+
+        void IncrementWaitCounts() const
+            { ForEachTarget([] (const auto& target) { target->IncrementWaitCount(); }); }
+
+        void MoveTargetsFrom(Dependency& other) noexcept
+        {
+            for (size_t i = 0; i < other.inlineCount_; ++i)
+                inlineTargets_[i] = std::move(other.inlineTargets_[i]);
+
+            inlineCount_ = other.inlineCount_;
+            overflowTargets_ = std::move(other.overflowTargets_);
+
+            other.Reset();
+        }
+
+        void Reset() noexcept
+        {
+            for (size_t i = 0; i < inlineCount_; ++i)
+                inlineTargets_[i] = nullptr;
+
+            inlineCount_ = 0;
+            overflowTargets_.clear();
+        }
+
+        std::array<std::shared_ptr<SyncPointState>, inline_capacity>   inlineTargets_;
+        size_t                                                          inlineCount_ = 0;
+        std::vector<std::shared_ptr<SyncPointState>>                    overflowTargets_;
     };
 
 private:
@@ -0,0 +1,352 @@
+//          Copyright Sebastian Jeckel 2017.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef REACT_COMMON_TRACING_H_INCLUDED
+#define REACT_COMMON_TRACING_H_INCLUDED
+
+#pragma once
+
+#include "react/detail/defs.h"
+#include "react/common/utility.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <typeinfo>
+#include <vector>
+
+/***************************************/ REACT_IMPL_BEGIN /**************************************/
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/// TraceEvent
+///////////////////////////////////////////////////////////////////////////////////////////////////
+enum class TraceEventKind : uint8_t
+{
+    batch,
+    turn,
+    level,
+    node_update,
+    link_enqueue
+};
+
+struct TraceEvent
+{
+    const char*             name;
+    const std::type_info*   type;       // If set, the event is named after this type instead
+    uint64_t                beginTime;
+    uint64_t                endTime;
+    uint64_t                id;
+    int                     level;      // Level of the updated node, or -1
+    TraceEventKind          kind;
+};
+
+inline const char* GetTraceEventName(const TraceEvent& e)
+{
+    // Demangling is too slow to do while recording.
+    return e.type != nullptr ? GetTypeName(*e.type) : e.name;
+}
+
+inline uint64_t GetTraceTime()
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/// TraceBuffer
+/// A ring buffer that is written by a single thread without locking. Once full, the oldest events
+/// are overwritten. Each slot has a sequence number, which is odd while the slot is written.
+/// Readers on other threads skip slots that were overwritten while they were read.
+///////////////////////////////////////////////////////////////////////////////////////////////////
+class TraceBuffer
+{
+public:
+    static const size_t capacity = 1 << 16;
+
+    explicit TraceBuffer(uint32_t threadIndex) :
+        slots_( new Slot[capacity] ),
+        threadIndex_( threadIndex )
+    { }
+
+    void Record(const TraceEvent& e)
+    {
+        uint64_t pos = writeCount_.load(std::memory_order_relaxed);
+        Slot& slot = slots_[pos % capacity];
+
+        uint64_t words[word_count] = { };
+        std::memcpy(words, &e, sizeof(TraceEvent));
+
+        slot.sequence.store(2 * pos + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        for (size_t i = 0; i < word_count; ++i)
+            slot.words[i].store(words[i], std::memory_order_relaxed);
+
+        slot.sequence.store(2 * pos + 2, std::memory_order_release);
+        writeCount_.store(pos + 1, std::memory_order_release);
+    }
+
+    template <typename F>
+    void ForEach(F&& func) const
+    {
+        uint64_t writeCount = writeCount_.load(std::memory_order_acquire);
+        uint64_t first = writeCount > capacity ? writeCount - capacity : 0;
+
+        first = (std::max)(first, clearCount_.load(std::memory_order_acquire));
+
+        for (uint64_t pos = first; pos < writeCount; ++pos)
+        {
+            const Slot& slot = slots_[pos % capacity];
+
+            uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+            if (sequence != 2 * pos + 2)
+                continue;
+
+            uint64_t words[word_count];
+
+            for (size_t i = 0; i < word_count; ++i)
+                words[i] = slot.words[i].load(std::memory_order_relaxed);
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+
+            // Torn by the writer in the meantime.
+            if (slot.sequence.load(std::memory_order_relaxed) != sequence)
+                continue;
+
+            TraceEvent e;
+            std::memcpy(&e, words, sizeof(TraceEvent));
+
+            func(e);
+        }
+    }
+
+    /// Hides the events recorded so far. The writer is not affected.
+    void Clear()
+        { clearCount_.store(writeCount_.load(std::memory_order_acquire), std::memory_order_release); }
+
+    uint32_t GetThreadIndex() const
+        { return threadIndex_; }
+
+private:
+    static const size_t word_count = (sizeof(TraceEvent) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    struct Slot
+    {
+        std::atomic<uint64_t> sequence{ 0 };
+        std::atomic<uint64_t> words[word_count];
+    };
+
+    std::unique_ptr<Slot[]> slots_;
+
+    std::atomic<uint64_t> writeCount_{ 0 };
+    std::atomic<uint64_t> clearCount_{ 0 };
+
+    uint32_t threadIndex_;
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/// TraceRegistry
+/// Owns the buffers of all threads that recorded events. Buffers outlive their threads.
+/// The lock is only taken when a thread records its first event and when the trace is read.
+///////////////////////////////////////////////////////////////////////////////////////////////////
+class TraceRegistry
+{
+public:
+    static TraceRegistry& Instance()
+    {
+        static TraceRegistry instance;
+        return instance;
+    }
+
+    static TraceBuffer& GetLocalBuffer()
+    {
+        thread_local std::shared_ptr<TraceBuffer> localBuffer = Instance().CreateBuffer();
+        return *localBuffer;
+    }
+
+    template <typename F>
+    void ForEachBuffer(F&& func)
+    {
+        std::lock_guard<std::mutex> scopedLock(mutex_);
+
+        for (const auto& buffer : buffers_)
+            func(*buffer);
+    }
+
+private:
+    std::shared_ptr<TraceBuffer> CreateBuffer()
+    {
+        std::lock_guard<std::mutex> scopedLock(mutex_);
+
+        buffers_.push_back(std::make_shared<TraceBuffer>(static_cast<uint32_t>(buffers_.size())));
+        return buffers_.back();
+    }
+
+    std::mutex mutex_;
+
+    std::vector<std::shared_ptr<TraceBuffer>> buffers_;
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/// TraceScope
+/// Records a span from construction to destruction.
+///////////////////////////////////////////////////////////////////////////////////////////////////
+class TraceScope
+{
+public:
+    TraceScope(TraceEventKind kind, const char* name, uint64_t id) :
+        event_( TraceEvent{ name, nullptr, GetTraceTime(), 0, id, -1, kind } )
+    { }
+
+    TraceScope(TraceEventKind kind, const std::type_info& type, uint64_t id, int level) :
+        event_( TraceEvent{ "", &type, GetTraceTime(), 0, id, level, kind } )
+    { }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+    ~TraceScope()
+    {
+        event_.endTime = GetTraceTime();
+        TraceRegistry::GetLocalBuffer().Record(event_);
+    }
+
+private:
+    TraceEvent event_;
+};
+
+inline const char* GetTraceCategory(TraceEventKind kind)
+{
+    switch (kind)
+    {
+    case TraceEventKind::batch:         return "batch";
+    case TraceEventKind::turn:          return "turn";
+    case TraceEventKind::level:         return "level";
+    case TraceEventKind::node_update:   return "node";
+    case TraceEventKind::link_enqueue:  return "link";
+    default:                            return "unknown";
+    }
+}
+
+inline void WriteJsonString(std::ostream& out, const char* s)
+{
+    out << '"';
+
+    for (; *s != '\0'; ++s)
+    {
+        if (*s == '"' || *s == '\\')
+            out << '\\' << *s;
+        else if (static_cast<unsigned char>(*s) >= 0x20)
+            out << *s;
+    }
+
+    out << '"';
+}
+
+/// Writes a time in nanoseconds as microseconds with three decimals, so it can be read back exactly.
+inline void WriteTraceMicroseconds(std::ostream& out, uint64_t time)
+{
+    uint64_t fraction = time % 1000;
+
+    out << time / 1000 << '.' << fraction / 100 << fraction / 10 % 10 << fraction % 10;
+}
+
+/****************************************/ REACT_IMPL_END /***************************************/
+
+/*****************************************/ REACT_BEGIN /*****************************************/
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/// Tracing
+/// Define REACT_ENABLE_TRACING when building the library and its users to record spans for
+/// batches, turns, levels, node updates and linked transactions. Without it, nothing is recorded
+/// and the instrumentation compiles to nothing.
+///////////////////////////////////////////////////////////////////////////////////////////////////
+#if defined(REACT_ENABLE_TRACING)
+    static constexpr bool is_tracing_enabled = true;
+#else
+    static constexpr bool is_tracing_enabled = false;
+#endif
+
+/// Discards all recorded events.
+inline void ClearTrace()
+{
+    REACT_IMPL::TraceRegistry::Instance().ForEachBuffer([] (REACT_IMPL::TraceBuffer& buffer) { buffer.Clear(); });
+}
+
+/// Writes all recorded events in the Chrome trace event format.
+/// The output can be loaded in chrome://tracing or Perfetto. Node updates are named after the node type
+/// and store the node id and level in their args. LoadTracedTurns in react/analysis.h reads it back.
+inline void WriteChromeTrace(std::ostream& out)
+{
+    using REACT_IMPL::TraceBuffer;
+    using REACT_IMPL::TraceEvent;
+
+    // Timestamps are relative to the first recorded event.
+    uint64_t startTime = (std::numeric_limits<uint64_t>::max)();
+
+    REACT_IMPL::TraceRegistry::Instance().ForEachBuffer([&] (const TraceBuffer& buffer)
+        {
+            buffer.ForEach([&] (const TraceEvent& e) { startTime = (std::min)(startTime, e.beginTime); });
+        });
+
+    bool isFirst = true;
+
+    out << "{\"traceEvents\":[";
+
+    REACT_IMPL::TraceRegistry::Instance().ForEachBuffer([&] (const TraceBuffer& buffer)
+        {
+            buffer.ForEach([&] (const TraceEvent& e)
+                {
+                    if (!isFirst)
+                        out << ',';
+                    isFirst = false;
+
+                    out << "\n{\"name\":";
+                    REACT_IMPL::WriteJsonString(out, REACT_IMPL::GetTraceEventName(e));
+                    out << ",\"cat\":\"" << REACT_IMPL::GetTraceCategory(e.kind) << '"'
+                        << ",\"ph\":\"X\""
+                        << ",\"ts\":";
+                    REACT_IMPL::WriteTraceMicroseconds(out, e.beginTime - startTime);
+                    out << ",\"dur\":";
+                    REACT_IMPL::WriteTraceMicroseconds(out, e.endTime - e.beginTime);
+                    out << ",\"pid\":1"
+                        << ",\"tid\":" << buffer.GetThreadIndex()
+                        << ",\"args\":{\"id\":" << e.id;
+
+                    if (e.kind == REACT_IMPL::TraceEventKind::node_update)
+                        out << ",\"level\":" << e.level;
+
+                    out << "}}";
+                });
+        });
+
+    out << "\n],\"displayTimeUnit\":\"ns\"}\n";
+}
+
+/******************************************/ REACT_END /******************************************/
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/// Instrumentation macros
+///////////////////////////////////////////////////////////////////////////////////////////////////
+#define REACT_TRACE_CONCAT_IMPL(a, b) a ## b
+#define REACT_TRACE_CONCAT(a, b) REACT_TRACE_CONCAT_IMPL(a, b)
+
+#if defined(REACT_ENABLE_TRACING)
+    #define REACT_TRACE_SCOPE(kind, name, id) \
+        REACT_IMPL::TraceScope REACT_TRACE_CONCAT(traceScope_, __LINE__)( REACT_IMPL::TraceEventKind::kind, name, static_cast<uint64_t>(id) )
+    #define REACT_TRACE_NODE_SCOPE(type, nodeId, level) \
+        REACT_IMPL::TraceScope REACT_TRACE_CONCAT(traceScope_, __LINE__)( REACT_IMPL::TraceEventKind::node_update, type, static_cast<uint64_t>(nodeId), level )
+#else
+    #define REACT_TRACE_SCOPE(kind, name, id) ((void)0)
+    #define REACT_TRACE_NODE_SCOPE(type, nodeId, level) ((void)0)
+#endif
+
+#endif // REACT_COMMON_TRACING_H_INCLUDED
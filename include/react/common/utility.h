@@ -11,10 +11,21 @@
 
 #include "react/detail/defs.h"
 
+#include <cstdlib>
+#include <mutex>
+#include <new>
+#include <string>
 #include <tuple>
+#include <typeindex>
+#include <typeinfo>
 #include <type_traits>
+#include <unordered_map>
 #include <utility>
 
+#if defined(__GNUG__)
+    #include <cxxabi.h>
+#endif
+
 /***************************************/ REACT_IMPL_BEGIN /**************************************/
 
 template<size_t N>
@@ -60,6 +71,87 @@ bool IsBitmaskSet(T flags, T mask)
     return (flags & mask) != (T)0;
 }
 
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/// Optional
+/// Storage for a value that may or may not be present.
+/// Use until C++17 std::optional is available. Only has the parts of its interface that are needed.
+///////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename T>
+class Optional
+{
+public:
+    Optional() = default;
+
+    Optional(const Optional&) = delete;
+    Optional& operator=(const Optional&) = delete;
+
+    ~Optional()
+        { reset(); }
+
+    template <typename ... Us>
+    T& emplace(Us&& ... args)
+    {
+        reset();
+
+        T* p = new (&storage_) T(std::forward<Us>(args) ...);
+        hasValue_ = true;
+        return *p;
+    }
+
+    void reset()
+    {
+        if (hasValue_)
+        {
+            hasValue_ = false;
+            reinterpret_cast<T*>(&storage_)->~T();
+        }
+    }
+
+    bool has_value() const
+        { return hasValue_; }
+
+    T& operator*()
+        { return *reinterpret_cast<T*>(&storage_); }
+
+    const T& operator*() const
+        { return *reinterpret_cast<const T*>(&storage_); }
+
+private:
+    typename std::aligned_storage<sizeof(T), alignof(T)>::type storage_;
+    bool hasValue_ = false;
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/// GetTypeName
+/// Returns the readable name of a type. GCC and Clang mangle the result of type_info::name,
+/// so it is demangled on first use and cached for the rest of the program.
+///////////////////////////////////////////////////////////////////////////////////////////////////
+inline const char* GetTypeName(const std::type_info& type)
+{
+    static std::mutex mutex;
+    static std::unordered_map<std::type_index, std::string> names;
+
+    std::lock_guard<std::mutex> scopedLock(mutex);
+
+    auto it = names.find(type);
+    if (it != names.end())
+        return it->second.c_str();
+
+    std::string name = type.name();
+
+#if defined(__GNUG__)
+    int status = 0;
+    char* demangled = abi::__cxa_demangle(type.name(), nullptr, nullptr, &status);
+
+    if (status == 0 && demangled != nullptr)
+        name = demangled;
+
+    std::free(demangled);
+#endif
+
+    return names.emplace(type, std::move(name)).first->second.c_str();
+}
+
 /****************************************/ REACT_IMPL_END /***************************************/
 
 /// Expand args by wrapping them in a dummy function
@@ -49,17 +49,76 @@ public:
         EventNode::NodeBase( group )
     { }
 
+    /// Returns the events of the current turn for modification.
+    /// A batch that was shared with this node is copied first, so it stays immutable for other holders.
     EventValueList<E>& Events()
-        { return events_; }
+    {
+        if (sharedEvents_)
+        {
+            // Batches created by GetSharedEvents are a copy of events_ already.
+            if (events_.empty())
+                events_ = *sharedEvents_;
+
+            sharedEvents_.reset();
+        }
+
+        return events_;
+    }
 
     const EventValueList<E>& Events() const
-        { return events_; }
+        { return sharedEvents_ ? *sharedEvents_ : events_; }
+
+    /// Returns the events of the current turn as an immutable batch.
+    /// The batch is created on first request and shared by all callers until the node is cleared.
+    const std::shared_ptr<const EventValueList<E>>& GetSharedEvents() const
+    {
+        if (! sharedEvents_)
+            sharedEvents_ = std::make_shared<const EventValueList<E>>(events_);
+
+        return sharedEvents_;
+    }
 
     virtual void Clear() noexcept override
-        { events_.clear(); }
+    {
+        events_.clear();
+        sharedEvents_.reset();
+    }
+
+    virtual size_t GetEventCount() const override
+        { return Events().size(); }
+
+    virtual size_t GetBufferSize() const override
+    {
+        size_t size = events_.capacity() * sizeof(E);
+
+        // A batch created by GetSharedEvents is a copy of events_. A batch that was adopted with
+        // AddSharedEvents, leaving events_ empty, is counted by the node that created it.
+        if (sharedEvents_ && !events_.empty())
+            size += sharedEvents_->capacity() * sizeof(E);
+
+        return size;
+    }
+
+protected:
+    /// Adds a batch of events that was produced by another node.
+    /// The first batch of a turn is referenced without copying.
+    void AddSharedEvents(std::shared_ptr<const EventValueList<E>>&& events)
+    {
+        if (! sharedEvents_ && events_.empty())
+        {
+            sharedEvents_ = std::move(events);
+            return;
+        }
+
+        // Multiple batches in one turn have to be concatenated.
+        EventValueList<E>& ownEvents = Events();
+        ownEvents.insert(ownEvents.end(), events->begin(), events->end());
+    }
 
 private:
     EventValueList<E> events_;
+
+    mutable std::shared_ptr<const EventValueList<E>> sharedEvents_;
 };
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
@@ -425,7 +484,7 @@ public:
         srcGraphPtr->UnregisterNode(outputNodeId_);
 
         auto& linkCache = GetGraphPtr()->GetLinkCache();
-        linkCache.Erase(this);
+        linkCache.Erase(static_cast<IReactNode*>(GetInternals(dep_).GetNodePtr().get()));
 
         this->UnregisterMe();
     }
@@ -436,8 +495,8 @@ public:
     virtual UpdateResult Update(TurnId turnId) noexcept override
         { return UpdateResult::changed; }
 
-    void SetEvents(EventValueList<E>&& events)
-        { this->Events() = std::move(events); }
+    void SetEvents(std::shared_ptr<const EventValueList<E>>&& events)
+        { this->AddSharedEvents(std::move(events)); }
 
 private:
     struct VirtualOutputNode : public IReactNode
@@ -449,12 +508,16 @@ private:
         {
             if (auto p = parent.lock())
             {
-                auto* rawPtr = p->GetGraphPtr().get();
+                auto* rawPtr = p->GetGraphPtr();
+
+                // All target groups reference the same immutable batch.
+                std::shared_ptr<const EventValueList<E>> events = GetInternals(p->dep_).GetNodePtr()->GetSharedEvents();
+
                 output[rawPtr].push_back(
-                    [storedParent = std::move(p), storedEvents = GetInternals(p->dep_).Events()] () mutable
+                    [storedParent = std::move(p), storedEvents = std::move(events)] () mutable
                     {
                         NodeId nodeId = storedParent->GetNodeId();
-                        auto& graphPtr = storedParent->GetGraphPtr();
+                        auto* graphPtr = storedParent->GetGraphPtr();
 
                         graphPtr->PushInput(nodeId,
                             [&storedParent, &storedEvents]
@@ -503,11 +566,8 @@ public:
     NodeId GetNodeId() const
         { return nodePtr_->GetNodeId(); }
 
-    EventValueList<E>& Events()
-        { return nodePtr_->Events(); }
-
     const EventValueList<E>& Events() const
-        { return nodePtr_->Events(); }
+        { return static_cast<const EventNode<E>&>(*nodePtr_).Events(); }
 
 private:
     std::shared_ptr<EventNode<E>> nodePtr_;
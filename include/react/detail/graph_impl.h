@@ -13,15 +13,26 @@
 
 #include <algorithm>
 #include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <deque>
+#include <iosfwd>
+#include <limits>
+#include <string>
+#include <unordered_map>
 #include <type_traits>
 #include <utility>
 #include <vector>
 #include <map>
+#include <memory>
 #include <mutex>
 
 #include <tbb/concurrent_queue.h>
 #include <tbb/task.h>
 
+#include "react/common/allocation.h"
+#include "react/common/checkpoint.h"
+#include "react/common/numa.h"
 #include "react/common/ptrcache.h"
 #include "react/common/slotmap.h"
 #include "react/common/syncpoint.h"
@@ -38,14 +49,25 @@ public:
         graph_( graph )
     { }
 
+    /// Adds a transaction, subject to the capacity of the queue. Returns false if it was rejected.
+    /// If the transaction is dropped later to make space for another one, droppedFlag is set before its dependency is released.
     template <typename F>
-    void Push(F&& func, SyncPoint::Dependency dep, TransactionFlags flags)
-    {
-        transactions_.push(StoredTransaction{ std::forward<F>(func), std::move(dep), flags });
+    bool Push(F&& func, SyncPoint::Dependency dep, TransactionFlags flags, std::shared_ptr<std::atomic<bool>> droppedFlag)
+        { return DoPush(StoredTransaction{ std::forward<F>(func), std::move(dep), flags, std::move(droppedFlag) }, true); }
 
-        if (count_.fetch_add(1, std::memory_order_release) == 0)
-            tbb::task::enqueue(*new(tbb::task::allocate_root()) WorkerTask(*this));
-    }
+    /// Adds a transaction without checking the capacity.
+    /// Used for transactions from linked groups, which must neither block their worker nor be lost.
+    template <typename F>
+    void PushUnbounded(F&& func, SyncPoint::Dependency dep, TransactionFlags flags)
+        { DoPush(StoredTransaction{ std::forward<F>(func), std::move(dep), flags }, false); }
+
+    /// Adds an empty transaction once time is reached, so a new batch is started even if nothing else is enqueued.
+    /// All queues share a single timer thread, which is created on first use. Only called by the worker.
+    void ScheduleWakeup(OutputClock::time_point time);
+
+    void SetCapacity(size_t capacity, QueueOverflowPolicy policy);
+
+    TransactionQueueStats GetStats() const;
 
 private:
     struct StoredTransaction
@@ -53,13 +75,16 @@ private:
         std::function<void()>   func;
         SyncPoint::Dependency   dep;
         TransactionFlags        flags;
+
+        std::shared_ptr<std::atomic<bool>> droppedFlag;
     };
 
     class WorkerTask : public tbb::task
     {
     public:
-        WorkerTask(TransactionQueue& parent) :
-            parent_( parent )
+        WorkerTask(TransactionQueue& parent, std::shared_ptr<ReactGraph>&& graphPtr) :
+            parent_( parent ),
+            graphPtr_( std::move(graphPtr) )
         { }
 
         tbb::task* execute()
@@ -70,46 +95,223 @@ private:
 
     private:
         TransactionQueue& parent_;
+
+        // Keeps the graph alive while the queue is processed, even if the group is released by
+        // another thread once the last transaction is complete.
+        std::shared_ptr<ReactGraph> graphPtr_;
+    };
+
+    // Lanes are ordered by priority, starting with the highest.
+    enum : size_t
+    {
+        lane_high,
+        lane_normal,
+        lane_low,
+        lane_count
     };
 
+    // After a non-empty lane has been passed over this many times, it's served next.
+    static const size_t starvation_limit = 16;
+
+    // A batch ends after this many transactions, so deferred outputs are flushed under sustained load as well.
+    static const size_t max_batch_size = 256;
+
+    static size_t GetLane(TransactionFlags flags)
+    {
+        if (IsBitmaskSet(flags, TransactionFlags::priority_high))
+            return lane_high;
+        else if (IsBitmaskSet(flags, TransactionFlags::priority_low))
+            return lane_low;
+        else
+            return lane_normal;
+    }
+
+    bool DoPush(StoredTransaction&& transaction, bool isBounded);
+
+    void StartWorker();
+
+    // Only called by the worker.
+    bool HasTransactions(size_t lane, bool isLocked) const;
+
+    bool TryPop(StoredTransaction& transaction, size_t& lane);
+
+    bool TryPopMergeable(size_t lane, StoredTransaction& transaction);
+
     void ProcessQueue();
 
     size_t ProcessNextBatch();
 
-    tbb::concurrent_queue<StoredTransaction> transactions_;
+    // Requires the lock. Only counts the locked lanes.
+    size_t GetSize() const;
+
+    // Without a capacity, transactions are pushed to these lanes without locking.
+    tbb::concurrent_queue<StoredTransaction> unboundedLanes_[lane_count];
+
+    // Set while the capacity is limited, or while the locked lanes still hold transactions.
+    // Otherwise, the locked lanes are empty.
+    std::atomic<bool> isLocked_{ false };
+
+    mutable std::mutex          mutex_;
+    std::condition_variable     notFullCondition_;
+
+    std::deque<StoredTransaction>   lanes_[lane_count];
+
+    // Only accessed by the worker.
+    size_t              skipCounts_[lane_count] = { };
+
+    // Transactions taken from an unbounded lane by TryPopMergeable that couldn't be merged. They go first.
+    // Only accessed by the worker.
+    StoredTransaction   heldTransactions_[lane_count];
+    bool                hasHeldTransaction_[lane_count] = { };
+
+    // Capacity of 0 means unbounded.
+    size_t              capacity_ = 0;
+    QueueOverflowPolicy policy_ = QueueOverflowPolicy::block;
 
     std::atomic<size_t> count_{ 0 };
 
+    std::atomic<size_t> rejectedCount_{ 0 };
+    std::atomic<size_t> droppedCount_{ 0 };
+
+    // Earliest wakeup that is still pending. Later ones are covered by it. Only accessed by the worker.
+    OutputClock::time_point wakeupTime_ = (OutputClock::time_point::min)();
+
     ReactGraph& graph_;
 };
 
-class ReactGraph
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/// TopoQueue
+/// Nodes scheduled for the current turn. FetchNext moves all nodes of the lowest level to Next.
+///////////////////////////////////////////////////////////////////////////////////////////////////
+class TopoQueue
+{
+public:
+    void Push(NodeId nodeId, int level)
+        { queueData_.emplace_back(nodeId, level); }
+
+    bool FetchNext();
+
+    const std::vector<NodeId>& Next() const
+        { return nextData_; }
+
+    bool IsEmpty() const
+        { return queueData_.empty(); }
+
+    int GetLevel() const
+        { return minLevel_; }
+
+private:
+    using Entry = std::pair<NodeId /*nodeId*/, int /*level*/>;
+
+    std::vector<Entry>  queueData_;
+    std::vector<NodeId> nextData_;
+
+    int minLevel_ = (std::numeric_limits<int>::max)();
+};
+
+class ReactGraph : public std::enable_shared_from_this<ReactGraph>
 {
 public:
     using LinkCache = WeakPtrCache<void*, IReactNode>;
 
+    // Defined out of line, because Group is incomplete here.
+    ReactGraph();
+    ~ReactGraph();
+
     NodeId RegisterNode(IReactNode* nodePtr, NodeCategory category);
     void UnregisterNode(NodeId nodeId);
 
     void AttachNode(NodeId node, NodeId parentId);
     void DetachNode(NodeId node, NodeId parentId);
 
+    /// Until EndTeardown, destroyed nodes are neither detached nor erased one by one. EndTeardown then frees
+    /// their node data at once and removes them from the successors of surviving nodes. In between, the graph
+    /// must not be used for transactions. Calls can be nested.
+    void BeginTeardown();
+    void EndTeardown();
+
     template <typename F>
     void PushInput(NodeId nodeId, F&& inputCallback);
 
     void AddSyncPointDependency(SyncPoint::Dependency dep, bool syncLinked);
 
+    /// Returns a dependency on the sync points that linked transactions of the current turn have to wait for.
+    SyncPoint::Dependency GetLinkDependency() const
+        { return SyncPoint::Dependency{ begin(linkDependencies_), end(linkDependencies_) }; }
+
     void AllowLinkedTransactionMerging(bool allowMerging);
 
+    /// Returns a handle to this graph. Only valid while it has registered nodes.
+    const Group& GetGroup() const
+        { return *selfGroup_; }
+
+    void SetLinkedTransactionPriority(TransactionFlags priority);
+
+    /// Defers the output of a node until the current batch of turns is done. See IReactNode::FlushOutput.
+    void DeferOutput(NodeId nodeId)
+        { deferredOutputs_.push_back(nodeId); }
+
+    /// Turns between BeginBatch and EndBatch form a batch. Outside of a batch, each turn is its own batch.
+    /// Sync point dependencies of the turns are released once deferred outputs of the batch have been flushed.
+    void BeginBatch()
+        { ++batchLevel_; }
+
+    void EndBatch();
+
     template <typename F>
     void DoTransaction(F&& transactionCallback);
 
     template <typename F>
-    void EnqueueTransaction(F&& func, SyncPoint::Dependency dep, TransactionFlags flags);
+    bool EnqueueTransaction(F&& func, SyncPoint::Dependency dep, TransactionFlags flags, std::shared_ptr<std::atomic<bool>> droppedFlag = nullptr);
+
+    /// Binds the node data of the graph and the worker that processes enqueued transactions to a NUMA node.
+    /// A negative node removes the placement. Memory that was moved already stays where it is.
+    void SetNumaNode(int numaNode);
+
+    int GetNumaNode() const
+        { return numaNode_.load(std::memory_order_relaxed); }
+
+    void SetTransactionQueueCapacity(size_t capacity, QueueOverflowPolicy policy)
+        { transactionQueue_.SetCapacity(capacity, policy); }
+
+    TransactionQueueStats GetTransactionQueueStats() const
+        { return transactionQueue_.GetStats(); }
     
     LinkCache& GetLinkCache()
         { return linkCache_; }
 
+    /// Node statistics are only collected if REACT_ENABLE_NODE_STATS is defined. Otherwise, the results are empty.
+    std::vector<NodeStats> GetNodeStats() const;
+    std::vector<NodeStats> GetHotNodes(size_t count) const;
+    std::vector<NodeStats> GetWastedNodes(size_t count, double minUnchangedRatio) const;
+    void ResetNodeStats();
+
+    /// Allocations are only counted if REACT_ENABLE_ALLOCATION_TRACKING is defined and the allocation
+    /// hooks are installed. See react/common/allocation.h.
+    AllocationStats GetAllocationStats() const
+        { return allocationCounters_.Get(); }
+
+    void ResetAllocationStats()
+        { allocationCounters_.Reset(); }
+
+    void SetNodeObjectSize(NodeId nodeId, size_t size)
+        { nodeData_[nodeId].objectSize = static_cast<uint32_t>(size); }
+
+    // Not synchronized with the worker, like GetNodeInfos.
+    GraphMemoryUsage GetMemoryUsage() const;
+
+    /// An empty name removes the debug name of the node.
+    void SetDebugName(NodeId nodeId, std::string name);
+
+    // Not synchronized with the worker, so the caller must make sure no transaction is in progress.
+    std::vector<GraphNodeInfo> GetNodeInfos() const;
+
+    void WriteDot(std::ostream& out) const;
+    void WriteJson(std::ostream& out) const;
+
+    void SaveCheckpoint(CheckpointWriter& out) const;
+    bool LoadCheckpoint(CheckpointReader& in);
+
 private:
     struct NodeData
     {
@@ -125,49 +327,57 @@ private:
 
         NodeCategory category = NodeCategory::normal;
 
+        bool    queued      = false;
         int     level       = 0;
         int     newLevel    = 0 ;
-        bool    queued      = false;
+
+        // Only used for memory reports.
+        uint32_t objectSize = 0;
 
         IReactNode*  nodePtr = nullptr;
 
         std::vector<NodeId> successors;
     };
 
-    class TopoQueue
+    struct NodeUpdateStats
     {
-    public:
-        void Push(NodeId nodeId, int level)
-            { queueData_.emplace_back(nodeId, level); }
-
-        bool FetchNext();
-
-        const std::vector<NodeId>& Next() const
-            { return nextData_; }
+        uint64_t updateCount    = 0;
+        uint64_t changedCount   = 0;
+        uint64_t eventCount     = 0;
+        uint64_t totalTime      = 0;
+        uint64_t maxTime        = 0;
+    };
 
-        bool IsEmpty() const
-            { return queueData_.empty(); }
+    void Propagate();
+    void UpdateLinkNodes();
 
-    private:
-        using Entry = std::pair<NodeId /*nodeId*/, int /*level*/>;
+    UpdateResult UpdateNode(NodeId nodeId, NodeData& node);
 
-        std::vector<Entry>  queueData_;
-        std::vector<NodeId> nextData_;
+    NodeStats MakeNodeStats(NodeId nodeId, const NodeData& node) const;
 
-        int minLevel_ = (std::numeric_limits<int>::max)();
-    };
+    // Binds the node data storage to a node, or restores the default policy if numaNode is negative.
+    void PlaceNodeData(int numaNode);
 
-    void Propagate();
-    void UpdateLinkNodes();
+    template <typename F>
+    void EnqueueLinkedTransaction(F&& func, SyncPoint::Dependency dep, TransactionFlags flags)
+        { transactionQueue_.PushUnbounded(std::forward<F>(func), std::move(dep), flags); }
 
     void ScheduleSuccessors(NodeData & node);
     void RecalculateSuccessorLevels(NodeData & node);
 
+    void FlushDeferredOutputs();
+
+    void ReleaseDependencies();
+
 private:
     TransactionQueue    transactionQueue_{ *this };
 
     SlotMap<NodeData>   nodeData_;
 
+    // Indexed by node id. Stays empty unless the library is built with REACT_ENABLE_NODE_STATS,
+    // so the counters don't take up space in the node data of every graph.
+    std::vector<NodeUpdateStats> nodeStats_;
+
     TopoQueue scheduledNodes_;
 
     std::vector<NodeId>         changedInputs_;
@@ -178,15 +388,47 @@ private:
     std::vector<SyncPoint::Dependency> localDependencies_;
     std::vector<SyncPoint::Dependency> linkDependencies_;
 
+    // Dependencies of completed turns, until the batch is done.
+    std::vector<SyncPoint::Dependency> heldDependencies_;
+
     LinkCache linkCache_;
 
+    // Most nodes don't have a name, so they are stored separately.
+    // Names are set from user threads, while the graph may be inspected or torn down on the worker.
+    mutable std::mutex                      debugNamesMutex_;
+    std::unordered_map<NodeId, std::string> debugNames_;
+
+    std::vector<NodeId> deferredOutputs_;
+    std::vector<NodeId> flushedOutputs_;
+
     int  transactionLevel_ = 0;
+    int  batchLevel_ = 0;
     bool allowLinkedTransactionMerging_ = false;
+    bool isTearingDown_ = false;
+    int  teardownLevel_ = 0;
+
+    // Nodes that are still registered during teardown.
+    size_t teardownNodeCount_ = 0;
+
+    // Read by the worker, which may run while the placement is changed.
+    std::atomic<int> numaNode_{ -1 };
+
+    TransactionFlags linkedTransactionPriority_ = TransactionFlags::none;
+
+    AllocationCounters allocationCounters_;
+
+    // Set while the graph has registered nodes, because nodes only keep a raw pointer to it.
+    // Nodes and their handles return it from GetGroup, so it isn't copied for each call.
+    std::unique_ptr<Group> selfGroup_;
 };
 
 template <typename F>
 void ReactGraph::PushInput(NodeId nodeId, F&& inputCallback)
 {
+    REACT_ALLOCATION_TARGET_SCOPE(allocationCounters_);
+
+    assert(!isTearingDown_ && "Inputs are not allowed during teardown");
+
     auto& node = nodeData_[nodeId];
     auto* nodePtr = node.nodePtr;
 
@@ -202,6 +444,8 @@ void ReactGraph::PushInput(NodeId nodeId, F&& inputCallback)
 template <typename F>
 void ReactGraph::DoTransaction(F&& transactionCallback)
 {
+    REACT_ALLOCATION_TARGET_SCOPE(allocationCounters_);
+
     // Transaction callback may add multiple inputs.
     ++transactionLevel_;
     std::forward<F>(transactionCallback)();
@@ -211,9 +455,9 @@ void ReactGraph::DoTransaction(F&& transactionCallback)
 }
 
 template <typename F>
-void ReactGraph::EnqueueTransaction(F&& func, SyncPoint::Dependency dep, TransactionFlags flags)
+bool ReactGraph::EnqueueTransaction(F&& func, SyncPoint::Dependency dep, TransactionFlags flags, std::shared_ptr<std::atomic<bool>> droppedFlag)
 {
-    transactionQueue_.Push(std::forward<F>(func), std::move(dep), flags);
+    return transactionQueue_.Push(std::forward<F>(func), std::move(dep), flags, std::move(droppedFlag));
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
@@ -226,6 +470,10 @@ public:
         graphPtr_( std::make_shared<ReactGraph>() )
     {  }
 
+    explicit GroupInternals(std::shared_ptr<ReactGraph> graphPtr) :
+        graphPtr_( std::move(graphPtr) )
+    {  }
+
     GroupInternals(const GroupInternals&) = default;
     GroupInternals& operator=(const GroupInternals&) = default;
 
@@ -11,12 +11,15 @@
 
 #include "react/detail/defs.h"
 
+#include <chrono>
+#include <cstdint>
 #include <functional>
 #include <memory>
 #include <unordered_map>
 #include <utility>
 
 #include "react/api.h"
+#include "react/common/checkpoint.h"
 #include "react/common/utility.h"
 
 /***************************************/ REACT_IMPL_BEGIN /**************************************/
@@ -39,7 +42,7 @@ enum class UpdateResult
     shifted
 };
 
-enum class NodeCategory
+enum class NodeCategory : uint8_t
 {
     normal,
     input,
@@ -53,6 +56,8 @@ struct IReactNode;
 
 using LinkOutputMap = std::unordered_map<ReactGraph*, std::vector<std::function<void()>>>;
 
+using OutputClock = std::chrono::steady_clock;
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 /// IReactNode
 ///////////////////////////////////////////////////////////////////////////////////////////////////
@@ -67,9 +72,72 @@ struct IReactNode
 
     virtual void CollectOutput(LinkOutputMap& output)
         { }
-};
 
+    /// Returns the number of events the node produced this turn. Only used for node statistics.
+    virtual size_t GetEventCount() const
+        { return 0; }
+
+    /// Returns the capacity in bytes of buffers owned by the node, like its event storage. Only used for memory reports.
+    virtual size_t GetBufferSize() const
+        { return 0; }
+
+    /// Called once the current batch of turns is done, if the node deferred its output with ReactGraph::DeferOutput.
+    /// Returns false if the node is not ready yet. It then lowers retryTime to when it should be flushed again.
+    virtual bool FlushOutput(OutputClock::time_point now, OutputClock::time_point& retryTime)
+        { return true; }
+
+    /// Returns the CheckpointTraits type_tag of the saved value, or 0 if the node has nothing to save.
+    virtual uint64_t GetStateTypeTag() const
+        { return 0; }
+
+    /// Writes the node value to a checkpoint. Returns false if the node has nothing to save.
+    virtual bool SaveState(CheckpointWriter& out) const
+        { return false; }
+
+    /// Reads a value saved by SaveState without changing the node. Returns false if the data could not be read.
+    virtual bool CheckState(CheckpointReader& in) const
+        { return false; }
 
+    /// Restores a node value saved by SaveState. Returns false if the data could not be read.
+    virtual bool RestoreState(CheckpointReader& in)
+        { return false; }
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/// WorkerThreadScope
+/// Marks this thread as running a task of the library, like the worker of a group or the drain task
+/// of an async observer, until the scope ends. Such threads must not wait for other tasks, which
+/// might need this thread to run.
+///////////////////////////////////////////////////////////////////////////////////////////////////
+class WorkerThreadScope
+{
+public:
+    WorkerThreadScope() :
+        previous_( GetFlag() )
+    {
+        GetFlag() = true;
+    }
+
+    WorkerThreadScope(const WorkerThreadScope&) = delete;
+    WorkerThreadScope& operator=(const WorkerThreadScope&) = delete;
+
+    ~WorkerThreadScope()
+    {
+        GetFlag() = previous_;
+    }
+
+    static bool IsWorkerThread()
+        { return GetFlag(); }
+
+private:
+    static bool& GetFlag()
+    {
+        thread_local bool isWorkerThread = false;
+        return isWorkerThread;
+    }
+
+    bool previous_;
+};
 
 /****************************************/ REACT_IMPL_END /***************************************/
 
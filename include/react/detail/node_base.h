@@ -22,13 +22,67 @@
 
 class ReactGraph;
 
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/// SizeRecordingAllocator
+/// Adds the size of each allocation to a counter. With allocate_shared, that is the size of the
+/// object together with its control block. Only allocate uses the counter, so it doesn't have to
+/// outlive the call to allocate_shared.
+///////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename T>
+struct SizeRecordingAllocator
+{
+    using value_type = T;
+
+    explicit SizeRecordingAllocator(size_t* sizePtrIn) :
+        sizePtr( sizePtrIn )
+    { }
+
+    template <typename U>
+    SizeRecordingAllocator(const SizeRecordingAllocator<U>& other) :
+        sizePtr( other.sizePtr )
+    { }
+
+    T* allocate(size_t n)
+    {
+        *sizePtr += n * sizeof(T);
+        return std::allocator<T>().allocate(n);
+    }
+
+    void deallocate(T* p, size_t n)
+        { std::allocator<T>().deallocate(p, n); }
+
+    size_t* sizePtr;
+};
+
+template <typename T, typename U>
+bool operator==(const SizeRecordingAllocator<T>&, const SizeRecordingAllocator<U>&)
+    { return true; }
+
+template <typename T, typename U>
+bool operator!=(const SizeRecordingAllocator<T>&, const SizeRecordingAllocator<U>&)
+    { return false; }
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/// CreateNode
+/// Only the creator of a node knows its final type, so it reports the size to the graph.
+///////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename NODE, typename ... ARGS>
+static std::shared_ptr<NODE> CreateNode(ARGS&& ... args)
+{
+    size_t size = 0;
+
+    auto node = std::allocate_shared<NODE>(SizeRecordingAllocator<NODE>{ &size }, std::forward<ARGS>(args) ...);
+    node->SetObjectSize(size);
+    return node;
+}
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 /// CreateWrappedNode
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 template <typename RET, typename NODE, typename ... ARGS>
 static RET CreateWrappedNode(ARGS&& ... args)
 {
-    auto node = std::make_shared<NODE>(std::forward<ARGS>(args) ...);
+    auto node = CreateNode<NODE>(std::forward<ARGS>(args) ...);
     return RET(std::move(node));
 }
 
@@ -39,7 +93,7 @@ class NodeBase : public IReactNode
 {
 public:
     NodeBase(const Group& group) :
-        group_( group )
+        graphPtr_( GetInternals(group).GetGraphPtr().get() )
     { }
     
     NodeBase(const NodeBase&) = delete;
@@ -67,19 +121,19 @@ public:
     NodeId GetNodeId() const
         { return nodeId_; }
 
+    /// Nodes only store a raw pointer to their graph. The graph keeps a handle to itself while it has nodes.
     auto GetGroup() const -> const Group&
-        { return group_; }
+        { return graphPtr_->GetGroup(); }
 
-    auto GetGroup() -> Group&
-        { return group_; }
+    /// The graph keeps itself alive while it has registered nodes, so this is valid for the lifetime of the node.
+    auto GetGraphPtr() const -> ReactGraph*
+        { return graphPtr_; }
 
-protected:
-    auto GetGraphPtr() const -> const std::shared_ptr<ReactGraph>&
-        { return GetInternals(group_).GetGraphPtr(); }
-
-    auto GetGraphPtr() -> std::shared_ptr<ReactGraph>&
-        { return GetInternals(group_).GetGraphPtr(); }
+    /// Called by CreateNode once the node is constructed. Only used for memory reports.
+    void SetObjectSize(size_t size)
+        { GetGraphPtr()->SetNodeObjectSize(nodeId_, size); }
 
+protected:
     void RegisterMe(NodeCategory category = NodeCategory::normal)
         { nodeId_ = GetGraphPtr()->RegisterNode(this, category); }
     
@@ -95,7 +149,7 @@ protected:
 private:
     NodeId nodeId_;
 
-    Group group_;
+    ReactGraph* graphPtr_;
 };
 
 /****************************************/ REACT_IMPL_END /***************************************/
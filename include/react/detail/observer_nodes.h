@@ -11,12 +11,20 @@
 
 #include "react/detail/defs.h"
 #include "react/api.h"
+#include "react/common/spscqueue.h"
 #include "react/common/utility.h"
 
+#include <atomic>
+#include <condition_variable>
+#include <deque>
 #include <memory>
+#include <mutex>
+#include <thread>
 #include <utility>
 #include <tuple>
 
+#include <tbb/task.h>
+
 #include "node_base.h"
 
 /***************************************/ REACT_IMPL_BEGIN /**************************************/
@@ -163,6 +171,438 @@ private:
     std::tuple<State<TSyncs> ...> syncHolder_;
 };
 
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/// EventBatch
+///////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename E>
+struct EventBatch
+{
+    std::shared_ptr<const EventValueList<E>> events;
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/// AsyncObserverQueue
+/// Decouples an observer function from propagation. The observer node pushes the arguments of
+/// each call into a bounded SPSC queue, which is drained by a task on the TBB worker pool.
+/// At most one task drains a queue at a time, so calls are made in the order of the turns.
+///////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename F, typename TValue>
+class AsyncObserverQueue : public std::enable_shared_from_this<AsyncObserverQueue<F, TValue>>
+{
+public:
+    template <typename FIn>
+    AsyncObserverQueue(FIn&& func, const AsyncObserverOptions& options) :
+        func_( std::forward<FIn>(func) ),
+        queue_( options.capacity > 0 ? options.capacity : 1 ),
+        policy_( options.policy )
+    { }
+
+    /// Called by the propagating thread. Depending on the policy, waits or drops the value if the queue is full.
+    /// Worker threads must not wait for the drain task, so with the block policy, they put values that don't fit
+    /// into an unbounded overflow list instead.
+    template <typename ... TArgs>
+    void Push(TArgs&& ... args)
+    {
+        TValue value( std::forward<TArgs>(args) ... );
+
+        if (! TryPush(value))
+        {
+            if (policy_ == ObserverOverflowPolicy::drop_newest)
+                return;
+
+            if (WorkerThreadScope::IsWorkerThread())
+                PushOverflow(std::move(value));
+            else
+                WaitAndPush(std::move(value));
+        }
+
+        // Only the push that makes the queue non-empty starts a drain task.
+        if (pendingCount_.fetch_add(1, std::memory_order_acq_rel) == 0)
+            tbb::task::enqueue(*new(tbb::task::allocate_root()) DrainTask(this->shared_from_this()));
+    }
+
+    /// Called when the observer is destroyed. Afterwards, the function is not called anymore.
+    /// Waits for a call that is in progress on another thread. Values that have not been consumed are discarded.
+    void Close()
+    {
+        isClosed_.store(true);
+
+        // The function itself released the observer, so there's nothing to wait for.
+        if (invokingThread_.load(std::memory_order_relaxed) == std::this_thread::get_id())
+            return;
+
+        std::lock_guard<std::mutex> scopedLock(invokeMutex_);
+    }
+
+private:
+    class DrainTask : public tbb::task
+    {
+    public:
+        explicit DrainTask(std::shared_ptr<AsyncObserverQueue>&& queuePtr) :
+            queuePtr_( std::move(queuePtr) )
+        { }
+
+        tbb::task* execute()
+        {
+            queuePtr_->Drain();
+            return nullptr;
+        }
+
+    private:
+        // Keeps the queue alive until it's drained, even if the observer has been released.
+        std::shared_ptr<AsyncObserverQueue> queuePtr_;
+    };
+
+    bool TryPush(TValue& value)
+    {
+        // Once values went to the overflow list, it has to be drained before the ring buffer is used again.
+        if (hasOverflow_.load(std::memory_order_acquire))
+        {
+            std::lock_guard<std::mutex> scopedLock(overflowMutex_);
+
+            if (! overflow_.empty())
+            {
+                overflow_.push_back(std::move(value));
+                return true;
+            }
+        }
+
+        return queue_.TryPush(std::move(value));
+    }
+
+    void PushOverflow(TValue&& value)
+    {
+        std::lock_guard<std::mutex> scopedLock(overflowMutex_);
+
+        overflow_.push_back(std::move(value));
+        hasOverflow_.store(true, std::memory_order_release);
+    }
+
+    void WaitAndPush(TValue&& value)
+    {
+        std::unique_lock<std::mutex> lock(notFullMutex_);
+
+        // Either the producer sees the space made by the consumer, or the consumer sees the waiting producer.
+        isProducerWaiting_.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        while (! queue_.TryPush(std::move(value)))
+            notFullCondition_.wait(lock);
+
+        isProducerWaiting_.store(false, std::memory_order_relaxed);
+    }
+
+    void Drain()
+    {
+        WorkerThreadScope workerScope;
+
+        size_t count = pendingCount_.load(std::memory_order_acquire);
+
+        do
+        {
+            // Each counted value was pushed before it was counted, so it's guaranteed to be there.
+            for (size_t i = 0; i < count; ++i)
+                ConsumeNext();
+
+            count = pendingCount_.fetch_sub(count, std::memory_order_acq_rel) - count;
+        }
+        while (count != 0);
+    }
+
+    void ConsumeNext()
+    {
+        // Values in the ring buffer are older than those in the overflow list.
+        if (queue_.TryConsume([this] (TValue& value) { Invoke(value); }))
+        {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+
+            if (isProducerWaiting_.load(std::memory_order_relaxed))
+            {
+                {// notFullMutex_
+                    std::lock_guard<std::mutex> scopedLock(notFullMutex_);
+                }// ~notFullMutex_
+
+                notFullCondition_.notify_one();
+            }
+
+            return;
+        }
+
+        std::unique_lock<std::mutex> lock(overflowMutex_);
+
+        TValue value = std::move(overflow_.front());
+        overflow_.pop_front();
+
+        if (overflow_.empty())
+            hasOverflow_.store(false, std::memory_order_release);
+
+        lock.unlock();
+
+        Invoke(value);
+    }
+
+    void Invoke(TValue& value)
+    {
+        std::lock_guard<std::mutex> scopedLock(invokeMutex_);
+
+        if (isClosed_.load(std::memory_order_relaxed))
+            return;
+
+        invokingThread_.store(std::this_thread::get_id(), std::memory_order_relaxed);
+
+        apply([this] (const auto& ... args)
+            { this->func_(Unwrap(args) ...); }, value);
+
+        invokingThread_.store(std::thread::id{ }, std::memory_order_relaxed);
+    }
+
+    template <typename T>
+    static const T& Unwrap(const T& value)
+        { return value; }
+
+    template <typename E>
+    static const EventValueList<E>& Unwrap(const EventBatch<E>& batch)
+        { return *batch.events; }
+
+    F func_;
+
+    SpscQueue<TValue> queue_;
+
+    ObserverOverflowPolicy policy_;
+
+    std::atomic<size_t> pendingCount_{ 0 };
+
+    // Blocked producer.
+    std::mutex                  notFullMutex_;
+    std::condition_variable     notFullCondition_;
+    std::atomic<bool>           isProducerWaiting_{ false };
+
+    // Values a worker thread could not put into the ring buffer.
+    std::mutex                  overflowMutex_;
+    std::deque<TValue>          overflow_;
+    std::atomic<bool>           hasOverflow_{ false };
+
+    // Held while the function is called.
+    std::mutex                  invokeMutex_;
+    std::atomic<std::thread::id> invokingThread_{ std::thread::id{ } };
+    std::atomic<bool>           isClosed_{ false };
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/// AsyncStateObserverNode
+/// State values are copied into the queue. The referenced values of State<Ref<T>> are not.
+///////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename F, typename ... TDeps>
+class AsyncStateObserverNode : public ObserverNode
+{
+public:
+    template <typename FIn>
+    AsyncStateObserverNode(const Group& group, const AsyncObserverOptions& options, FIn&& func, const State<TDeps>& ... deps) :
+        AsyncStateObserverNode::ObserverNode( group ),
+        queuePtr_( std::make_shared<QueueType>(std::forward<FIn>(func), options) ),
+        depHolder_( deps ... )
+    {
+        this->RegisterMe(NodeCategory::output);
+        REACT_EXPAND_PACK(this->AttachToMe(GetInternals(deps).GetNodeId()));
+
+        queuePtr_->Push(GetInternals(deps).Value() ...);
+    }
+
+    ~AsyncStateObserverNode()
+    {
+        queuePtr_->Close();
+
+        apply([this] (const auto& ... deps)
+            { REACT_EXPAND_PACK(this->DetachFromMe(GetInternals(deps).GetNodeId())); }, depHolder_);
+        this->UnregisterMe();
+    }
+
+    virtual UpdateResult Update(TurnId turnId) noexcept override
+    {
+        apply([this] (const auto& ... deps)
+            { this->queuePtr_->Push(GetInternals(deps).Value() ...); }, depHolder_);
+        return UpdateResult::unchanged;
+    }
+
+private:
+    using QueueType = AsyncObserverQueue<F, std::tuple<TDeps ...>>;
+
+    std::shared_ptr<QueueType> queuePtr_;
+
+    std::tuple<State<TDeps> ...> depHolder_;
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/// AsyncEventObserverNode
+/// Event batches are not copied. The queue references the immutable batch of the subject.
+///////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename F, typename E>
+class AsyncEventObserverNode : public ObserverNode
+{
+public:
+    template <typename FIn>
+    AsyncEventObserverNode(const Group& group, const AsyncObserverOptions& options, FIn&& func, const Event<E>& subject) :
+        AsyncEventObserverNode::ObserverNode( group ),
+        queuePtr_( std::make_shared<QueueType>(std::forward<FIn>(func), options) ),
+        subject_( subject )
+    {
+        this->RegisterMe(NodeCategory::output);
+        this->AttachToMe(GetInternals(subject).GetNodeId());
+    }
+
+    ~AsyncEventObserverNode()
+    {
+        queuePtr_->Close();
+
+        this->DetachFromMe(GetInternals(subject_).GetNodeId());
+        this->UnregisterMe();
+    }
+
+    virtual UpdateResult Update(TurnId turnId) noexcept override
+    {
+        queuePtr_->Push(EventBatch<E>{ GetInternals(subject_).GetNodePtr()->GetSharedEvents() });
+        return UpdateResult::unchanged;
+    }
+
+private:
+    using QueueType = AsyncObserverQueue<F, std::tuple<EventBatch<E>>>;
+
+    std::shared_ptr<QueueType> queuePtr_;
+
+    Event<E> subject_;
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/// AsyncSyncedEventObserverNode
+///////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename F, typename E, typename ... TSyncs>
+class AsyncSyncedEventObserverNode : public ObserverNode
+{
+public:
+    template <typename FIn>
+    AsyncSyncedEventObserverNode(const Group& group, const AsyncObserverOptions& options, FIn&& func, const Event<E>& subject, const State<TSyncs>& ... syncs) :
+        AsyncSyncedEventObserverNode::ObserverNode( group ),
+        queuePtr_( std::make_shared<QueueType>(std::forward<FIn>(func), options) ),
+        subject_( subject ),
+        syncHolder_( syncs ... )
+    {
+        this->RegisterMe(NodeCategory::output);
+        this->AttachToMe(GetInternals(subject).GetNodeId());
+        REACT_EXPAND_PACK(this->AttachToMe(GetInternals(syncs).GetNodeId()));
+    }
+
+    ~AsyncSyncedEventObserverNode()
+    {
+        queuePtr_->Close();
+
+        apply([this] (const auto& ... syncs)
+            { REACT_EXPAND_PACK(this->DetachFromMe(GetInternals(syncs).GetNodeId())); }, syncHolder_);
+        this->DetachFromMe(GetInternals(subject_).GetNodeId());
+        this->UnregisterMe();
+    }
+
+    virtual UpdateResult Update(TurnId turnId) noexcept override
+    {
+        // Updates might be triggered even if only sync nodes changed. Ignore those.
+        if (GetInternals(this->subject_).Events().empty())
+            return UpdateResult::unchanged;
+
+        apply([this] (const auto& ... syncs)
+            {
+                this->queuePtr_->Push(
+                    EventBatch<E>{ GetInternals(this->subject_).GetNodePtr()->GetSharedEvents() },
+                    GetInternals(syncs).Value() ...);
+            }, syncHolder_);
+
+        return UpdateResult::unchanged;
+    }
+
+private:
+    using QueueType = AsyncObserverQueue<F, std::tuple<EventBatch<E>, TSyncs ...>>;
+
+    std::shared_ptr<QueueType> queuePtr_;
+
+    Event<E> subject_;
+
+    std::tuple<State<TSyncs> ...> syncHolder_;
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/// CoalescedStateObserverNode
+/// Instead of calling the function every turn, the node defers its output until the current batch
+/// of turns is done. The function is then called once with the latest values.
+/// With a non-zero interval, calls are at least that far apart. The last change is always delivered.
+///////////////////////////////////////////////////////////////////////////////////////////////////
+template <typename F, typename ... TDeps>
+class CoalescedStateObserverNode : public ObserverNode
+{
+public:
+    template <typename FIn>
+    CoalescedStateObserverNode(const Group& group, const CoalescedObserverOptions& options, FIn&& func, const State<TDeps>& ... deps) :
+        CoalescedStateObserverNode::ObserverNode( group ),
+        func_( std::forward<FIn>(func) ),
+        depHolder_( deps ... ),
+        interval_( options.interval )
+    {
+        this->RegisterMe(NodeCategory::output);
+        REACT_EXPAND_PACK(this->AttachToMe(GetInternals(deps).GetNodeId()));
+
+        CallFunc(OutputClock::now());
+    }
+
+    ~CoalescedStateObserverNode()
+    {
+        apply([this] (const auto& ... deps)
+            { REACT_EXPAND_PACK(this->DetachFromMe(GetInternals(deps).GetNodeId())); }, depHolder_);
+        this->UnregisterMe();
+    }
+
+    virtual UpdateResult Update(TurnId turnId) noexcept override
+    {
+        if (! isDeferred_)
+        {
+            isDeferred_ = true;
+            this->GetGraphPtr()->DeferOutput(this->GetNodeId());
+        }
+
+        return UpdateResult::unchanged;
+    }
+
+    virtual bool FlushOutput(OutputClock::time_point now, OutputClock::time_point& retryTime) override
+    {
+        OutputClock::time_point nextCallTime = lastCallTime_ + interval_;
+
+        if (now < nextCallTime)
+        {
+            if (retryTime > nextCallTime)
+                retryTime = nextCallTime;
+            return false;
+        }
+
+        isDeferred_ = false;
+        CallFunc(now);
+        return true;
+    }
+
+private:
+    void CallFunc(OutputClock::time_point now)
+    {
+        lastCallTime_ = now;
+
+        apply([this] (const auto& ... deps)
+            { this->func_(GetInternals(deps).Value() ...); }, depHolder_);
+    }
+
+    F func_;
+
+    std::tuple<State<TDeps> ...> depHolder_;
+
+    OutputClock::duration   interval_;
+    OutputClock::time_point lastCallTime_;
+
+    bool isDeferred_ = false;
+};
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 /// ObserverInternals
 ///////////////////////////////////////////////////////////////////////////////////////////////////
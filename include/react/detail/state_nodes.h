@@ -11,8 +11,11 @@
 
 #include "react/detail/defs.h"
 
+#include <iterator>
 #include <memory>
+#include <mutex>
 #include <queue>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
@@ -50,7 +53,50 @@ public:
     const S& Value() const
         { return value_; }
 
+    virtual uint64_t GetStateTypeTag() const override
+        { return GetTypeTag(std::integral_constant<bool, CheckpointTraits<S>::is_serializable>{ }); }
+
+    virtual bool SaveState(CheckpointWriter& out) const override
+        { return SaveValue(out, std::integral_constant<bool, CheckpointTraits<S>::is_serializable>{ }); }
+
+    virtual bool CheckState(CheckpointReader& in) const override
+        { return CheckValue(in, std::integral_constant<bool, CheckpointTraits<S>::is_serializable>{ }); }
+
+    virtual bool RestoreState(CheckpointReader& in) override
+        { return RestoreValue(in, std::integral_constant<bool, CheckpointTraits<S>::is_serializable>{ }); }
+
 private:
+    static uint64_t GetTypeTag(std::true_type)
+        { return CheckpointTraits<S>::type_tag; }
+
+    static uint64_t GetTypeTag(std::false_type)
+        { return 0; }
+
+    bool SaveValue(CheckpointWriter& out, std::true_type) const
+    {
+        CheckpointTraits<S>::Save(out, value_);
+        return true;
+    }
+
+    bool SaveValue(CheckpointWriter& out, std::false_type) const
+        { return false; }
+
+    // Loads into a copy, so the same data can be restored afterwards.
+    bool CheckValue(CheckpointReader& in, std::true_type) const
+    {
+        S value = value_;
+        return CheckpointTraits<S>::Load(in, value);
+    }
+
+    bool CheckValue(CheckpointReader& in, std::false_type) const
+        { return false; }
+
+    bool RestoreValue(CheckpointReader& in, std::true_type)
+        { return CheckpointTraits<S>::Load(in, value_); }
+
+    bool RestoreValue(CheckpointReader& in, std::false_type)
+        { return false; }
+
     S value_;
 };
 
@@ -73,7 +119,7 @@ public:
         StateVarNode::StateNode( group, std::forward<T>(value) ),
         newValue_( value )
     {
-        this->RegisterMe();
+        this->RegisterMe(NodeCategory::input);
     }
 
     ~StateVarNode()
@@ -109,6 +155,15 @@ public:
         }
     }
 
+    /// A checkpoint only holds the current value. Input that was set, but not propagated yet, is dropped.
+    virtual bool RestoreState(CheckpointReader& in) override
+    {
+        isInputAdded_ = false;
+        isInputModified_ = false;
+
+        return StateVarNode::StateNode::RestoreState(in);
+    }
+
     template <typename T>
     void SetValue(T&& newValue)
     {
@@ -285,7 +340,7 @@ public:
         srcGraphPtr->UnregisterNode(outputNodeId_);
 
         auto& linkCache = GetGraphPtr()->GetLinkCache();
-        linkCache.Erase(this);
+        linkCache.Erase(static_cast<IReactNode*>(GetInternals(dep_).GetNodePtr().get()));
 
         this->UnregisterMe();
     }
@@ -296,9 +351,6 @@ public:
     virtual UpdateResult Update(TurnId turnId) noexcept override
         { return UpdateResult::changed; }
 
-    void SetValue(S&& newValue)
-        { this->Value() = std::move(newValue); }
-
 private:
     struct VirtualOutputNode : public IReactNode
     {
@@ -309,15 +361,35 @@ private:
         {
             if (auto p = parent.lock())
             {
-                auto* rawPtr = p->GetGraphPtr().get();
-                output[rawPtr].push_back([storedParent = std::move(p), storedValue = GetInternals(p->dep_).Value()] () mutable -> void
+                auto* rawPtr = p->GetGraphPtr();
+
+                bool isTransferPending;
+                {
+                    std::lock_guard<std::mutex> scopedLock(p->pendingMutex_);
+
+                    // Latest value wins. A slow target only ever applies the newest value.
+                    p->pendingValue_.emplace(GetInternals(p->dep_).Value());
+
+                    isTransferPending = p->isTransferPending_;
+                    p->isTransferPending_ = true;
+
+                    // The sync dependencies of a coalesced turn are held until the pending transfer is applied.
+                    // A separate transaction to forward them might be done first, e.g. if it's in a higher lane.
+                    if (isTransferPending)
+                        p->AddPendingDependency(GetInternals(p->srcGroup_).GetGraphPtr()->GetLinkDependency());
+                }
+
+                if (isTransferPending)
+                    return;
+
+                output[rawPtr].push_back([storedParent = std::move(p)] () -> void
                     {
                         NodeId nodeId = storedParent->GetNodeId();
-                        auto& graphPtr = storedParent->GetGraphPtr();
+                        auto* graphPtr = storedParent->GetGraphPtr();
 
-                        graphPtr->PushInput(nodeId, [&storedParent, &storedValue]
+                        graphPtr->PushInput(nodeId, [&storedParent]
                             {
-                                storedParent->SetValue(std::move(storedValue));
+                                storedParent->ApplyPendingValue();
                             });
                     });
             }
@@ -326,11 +398,45 @@ private:
         std::weak_ptr<StateLinkNode> parent;
     };
 
+    // Requires pendingMutex_.
+    void AddPendingDependency(SyncPoint::Dependency&& dep)
+    {
+        if (dep.IsReleased())
+            return;
+
+        SyncPoint::Dependency deps[] = { std::move(pendingDep_), std::move(dep) };
+        pendingDep_ = SyncPoint::Dependency{ std::begin(deps), std::end(deps) };
+    }
+
+    void ApplyPendingValue()
+    {
+        SyncPoint::Dependency dep;
+        {
+            std::lock_guard<std::mutex> scopedLock(pendingMutex_);
+
+            this->Value() = std::move(*pendingValue_);
+            pendingValue_.reset();
+            isTransferPending_ = false;
+
+            dep = std::move(pendingDep_);
+        }
+
+        // Released once the turn that applies the value is done, like the dependencies of the transfer itself.
+        if (! dep.IsReleased())
+            this->GetGraphPtr()->AddSyncPointDependency(std::move(dep), true);
+    }
+
     State<S>    dep_;
     Group       srcGroup_;
     NodeId      outputNodeId_;
 
     VirtualOutputNode linkOutput_;
+
+    // Single pending slot, written by the source graph and consumed by the target graph.
+    std::mutex              pendingMutex_;
+    Optional<S>             pendingValue_;
+    SyncPoint::Dependency   pendingDep_;
+    bool                    isTransferPending_ = false;
 };
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
@@ -408,7 +514,7 @@ private:
 template <typename S>
 static State<S> SameGroupOrLink(const Group& targetGroup, const State<S>& dep)
 {
-    if (dep.GetGroup() == targetGroup)
+    if (GetInternals(dep).GetNodePtr()->GetGraphPtr() == GetInternals(targetGroup).GetGraphPtr().get())
         return dep;
     else
         return StateLink<S>::Create(targetGroup, dep);
@@ -12,6 +12,7 @@
 #include "react/detail/defs.h"
 
 #include <memory>
+#include <string>
 #include <type_traits>
 #include <utility>
 
@@ -62,8 +63,9 @@ public:
     auto GetGroup() const -> const Group&
         { return GetNodePtr()->GetGroup(); }
 
-    auto GetGroup() -> Group&
-        { return GetNodePtr()->GetGroup(); }
+    /// Sets a name that identifies the node in graph exports.
+    void SetDebugName(std::string name)
+        { this->GetNodePtr()->GetGraphPtr()->SetDebugName(this->GetNodeId(), std::move(name)); }
 
     friend bool operator==(const Event<E>& a, const Event<E>& b)
         { return a.GetNodePtr() == b.GetNodePtr(); }
@@ -88,7 +90,7 @@ protected:
         using REACT_IMPL::EventProcessingNode;
         using REACT_IMPL::SameGroupOrLink;
 
-        return std::make_shared<EventProcessingNode<E, T, typename std::decay<F>::type>>(
+        return REACT_IMPL::CreateNode<EventProcessingNode<E, T, typename std::decay<F>::type>>(
             group, std::forward<F>(func), SameGroupOrLink(group, dep));
     }
 
@@ -98,7 +100,7 @@ protected:
         using REACT_IMPL::SyncedEventProcessingNode;
         using REACT_IMPL::SameGroupOrLink;
 
-        return std::make_shared<SyncedEventProcessingNode<E, T, typename std::decay<F>::type, Us ...>>(
+        return REACT_IMPL::CreateNode<SyncedEventProcessingNode<E, T, typename std::decay<F>::type, Us ...>>(
             group, std::forward<F>(func), SameGroupOrLink(group, dep), SameGroupOrLink(group, syncs) ...);
     }
 
@@ -150,7 +152,7 @@ private:
     static auto CreateSourceNode(const Group& group) -> decltype(auto)
     {
         using REACT_IMPL::EventSourceNode;
-        return std::make_shared<EventSourceNode<E>>(group);
+        return REACT_IMPL::CreateNode<EventSourceNode<E>>(group);
     }
 
     template <typename T>
@@ -163,7 +165,7 @@ private:
         auto* castedPtr = static_cast<EventSourceNode<E>*>(this->GetNodePtr().get());
 
         NodeId nodeId = castedPtr->GetNodeId();
-        auto& graphPtr = GetInternals(this->GetGroup()).GetGraphPtr();
+        auto* graphPtr = this->GetNodePtr()->GetGraphPtr();
 
         graphPtr->PushInput(nodeId, [castedPtr, &value] { castedPtr->EmitValue(std::forward<T>(value)); });
     }
@@ -206,7 +208,7 @@ private:
     static auto CreateSlotNode(const Group& group) -> decltype(auto)
     {
         using REACT_IMPL::EventSlotNode;
-        return std::make_shared<EventSlotNode<E>>(group);
+        return REACT_IMPL::CreateNode<EventSlotNode<E>>(group);
     }
 
     void AddSlotInput(const Event<E>& input)
@@ -217,7 +219,7 @@ private:
         SlotNodeType* castedPtr = static_cast<SlotNodeType*>(this->GetNodePtr().get());
 
         NodeId nodeId = castedPtr->GetInputNodeId();
-        auto& graphPtr = GetInternals(this->GetGroup()).GetGraphPtr();
+        auto* graphPtr = this->GetNodePtr()->GetGraphPtr();
 
         graphPtr->PushInput(nodeId, [this, castedPtr, &input] { castedPtr->AddSlotInput(SameGroupOrLink(GetGroup(), input)); });
     }
@@ -230,7 +232,7 @@ private:
         SlotNodeType* castedPtr = static_cast<SlotNodeType*>(this->GetNodePtr().get());
 
         NodeId nodeId = castedPtr->GetInputNodeId();
-        auto& graphPtr = GetInternals(this->GetGroup()).GetGraphPtr();
+        auto* graphPtr = this->GetNodePtr()->GetGraphPtr();
 
         graphPtr->PushInput(nodeId, [this, castedPtr, &input] { castedPtr->RemoveSlotInput(SameGroupOrLink(GetGroup(), input)); });
     }
@@ -243,7 +245,7 @@ private:
         SlotNodeType* castedPtr = static_cast<SlotNodeType*>(this->GetNodePtr().get());
 
         NodeId nodeId = castedPtr->GetInputNodeId();
-        auto& graphPtr = GetInternals(this->GetGroup()).GetGraphPtr();
+        auto* graphPtr = this->GetNodePtr()->GetGraphPtr();
 
         graphPtr->PushInput(nodeId, [castedPtr] { castedPtr->RemoveAllSlotInputs(); });
     }
@@ -286,7 +288,7 @@ private:
 
         std::shared_ptr<IReactNode> nodePtr = linkCache.LookupOrCreate(k, [&]
             {
-                auto nodePtr = std::make_shared<EventLinkNode<E>>(group, input);
+                auto nodePtr = REACT_IMPL::CreateNode<EventLinkNode<E>>(group, input);
                 nodePtr->SetWeakSelfPtr(std::weak_ptr<EventLinkNode<E>>{ nodePtr });
                 return std::static_pointer_cast<IReactNode>(nodePtr);
             });
@@ -405,7 +407,7 @@ static auto Join(const Event<U1>& dep1, const Event<Us>& ... deps) -> Event<std:
 template <typename E>
 static Event<E> SameGroupOrLink(const Group& targetGroup, const Event<E>& dep)
 {
-    if (dep.GetGroup() == targetGroup)
+    if (GetInternals(dep).GetNodePtr()->GetGraphPtr() == GetInternals(targetGroup).GetGraphPtr().get())
         return dep;
     else
         return EventLink<E>::Create(targetGroup, dep);
@@ -11,10 +11,20 @@
 
 #include "react/detail/defs.h"
 
+#include <atomic>
+#include <chrono>
+#include <iosfwd>
 #include <memory>
 #include <utility>
+#include <vector>
+
+#if defined(__cpp_impl_coroutine)
+    #include <coroutine>
+#endif
 
 #include "react/API.h"
+#include "react/common/allocation.h"
+#include "react/common/checkpoint.h"
 #include "react/common/syncpoint.h"
 
 #include "react/detail/graph_interface.h"
@@ -22,6 +32,85 @@
 
 /*****************************************/ REACT_BEGIN /*****************************************/
 
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/// A handle to the completion of an enqueued transaction.
+/// The transaction is complete once its changes have been propagated. If it was enqueued with
+/// TransactionFlags::sync_linked, linked transactions in other groups have to be complete as well.
+///////////////////////////////////////////////////////////////////////////////////////////////////
+class TransactionStatus
+{
+public:
+    TransactionStatus() = default;
+
+    TransactionStatus(const TransactionStatus&) = default;
+    TransactionStatus& operator=(const TransactionStatus&) = default;
+
+    TransactionStatus(TransactionStatus&&) = default;
+    TransactionStatus& operator=(TransactionStatus&&) = default;
+
+    /// Returns true if the transaction is complete. Does not block.
+    /// Rejected transactions are done immediately.
+    bool IsDone() const
+        { return syncPoint_.IsDone(); }
+
+    /// Returns true if the transaction was rejected, because the transaction queue was full.
+    bool IsRejected() const
+        { return isRejected_; }
+
+    /// Returns true if the transaction was dropped from a full queue by QueueOverflowPolicy::drop_oldest_mergeable.
+    /// A dropped transaction is done, but it never ran. Only transactions with allow_merging can be dropped.
+    bool IsDropped() const
+        { return isDropped_ != nullptr && isDropped_->load(std::memory_order_acquire); }
+
+    /// Blocks the calling thread until the transaction is complete.
+    void Wait()
+        { syncPoint_.Wait(); }
+
+    /// Like Wait, but times out after relTime. Returns false if the timeout was hit.
+    template <typename TRep, typename TPeriod>
+    bool WaitFor(const std::chrono::duration<TRep, TPeriod>& relTime)
+        { return syncPoint_.WaitFor(relTime); }
+
+    /// Calls func once the transaction is complete.
+    /// If it already is, func is called immediately. Otherwise it's called on the thread that completed the transaction,
+    /// after its turn is done. func may use the group, for example to enqueue further transactions.
+    template <typename F>
+    void Then(F&& func)
+        { syncPoint_.Then(std::forward<F>(func)); }
+
+#if defined(__cpp_impl_coroutine)
+    struct Awaiter
+    {
+        bool await_ready() const
+            { return syncPoint.IsDone(); }
+
+        // The transaction might be completed after await_ready. Returning false resumes the coroutine right away,
+        // instead of resuming it from inside of await_suspend.
+        bool await_suspend(std::coroutine_handle<> handle)
+            { return syncPoint.TryThen([handle] { handle.resume(); }); }
+
+        void await_resume() const
+            { }
+
+        SyncPoint syncPoint;
+    };
+
+    /// Suspends the awaiting coroutine until the transaction is complete.
+    /// The coroutine is resumed on the thread that completed the transaction.
+    Awaiter operator co_await() const
+        { return Awaiter{ syncPoint_ }; }
+#endif
+
+private:
+    SyncPoint   syncPoint_;
+    bool        isRejected_ = false;
+
+    // Shared with the queued transaction. Only allocated if it can be dropped.
+    std::shared_ptr<std::atomic<bool>> isDropped_;
+
+    friend class Group;
+};
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 /// Group
 ///////////////////////////////////////////////////////////////////////////////////////////////////
@@ -40,13 +129,127 @@ public:
     void DoTransaction(F&& func)
         { GetGraphPtr()->DoTransaction(std::forward<F>(func)); }
 
+    /// Enqueues a transaction to be executed asynchronously.
+    /// TransactionFlags::priority_high and priority_low select a lane other than the normal one. Higher lanes are
+    /// drained first, but a lane that was passed over too often is served next. Transactions only merge within a lane.
+    /// Returns false if the transaction was rejected, because the transaction queue is full.
     template <typename F>
-    void EnqueueTransaction(F&& func, TransactionFlags flags = TransactionFlags::none)
-        { GetGraphPtr()->EnqueueTransaction(std::forward<F>(func), SyncPoint::Dependency{ }, flags); }
+    bool EnqueueTransaction(F&& func, TransactionFlags flags = TransactionFlags::none)
+        { return GetGraphPtr()->EnqueueTransaction(std::forward<F>(func), SyncPoint::Dependency{ }, flags); }
 
     template <typename F>
-    void EnqueueTransaction(F&& func, const SyncPoint& syncPoint, TransactionFlags flags = TransactionFlags::none)
-        { GetGraphPtr()->EnqueueTransaction(std::forward<F>(func), SyncPoint::Dependency{ syncPoint }, flags); }
+    bool EnqueueTransaction(F&& func, const SyncPoint& syncPoint, TransactionFlags flags = TransactionFlags::none)
+        { return GetGraphPtr()->EnqueueTransaction(std::forward<F>(func), SyncPoint::Dependency{ syncPoint }, flags); }
+
+    /// Like EnqueueTransaction, but returns a handle to poll, wait for or await the completion of the transaction.
+    template <typename F>
+    TransactionStatus EnqueueTransaction(WithStatusTag, F&& func, TransactionFlags flags = TransactionFlags::none)
+    {
+        TransactionStatus status;
+
+        if (REACT_IMPL::IsBitmaskSet(flags, TransactionFlags::allow_merging))
+            status.isDropped_ = std::make_shared<std::atomic<bool>>(false);
+
+        status.isRejected_ = !GetGraphPtr()->EnqueueTransaction(std::forward<F>(func), SyncPoint::Dependency{ status.syncPoint_ }, flags, status.isDropped_);
+        return status;
+    }
+
+    /// Places this group on a NUMA node. The worker that processes enqueued transactions only runs on processors
+    /// of that node, so buffers that grow during propagation are allocated there. The node data of the group is moved
+    /// to the node where the platform supports it (Linux). A negative node removes the placement.
+    /// Nodes are allocated by the thread that creates them, so large graphs should be built by a thread of that node.
+    void SetNumaNode(int numaNode)
+        { GetGraphPtr()->SetNumaNode(numaNode); }
+
+    /// Returns the NUMA node of this group, or -1 if it is not placed.
+    int GetNumaNode() const
+        { return GetGraphPtr()->GetNumaNode(); }
+
+    /// Limits the number of transactions waiting in the queue of this group. A capacity of 0 means unbounded,
+    /// which is the default. The policy decides what happens to transactions that are enqueued while the queue is full:
+    ///     block                   - EnqueueTransaction blocks until there is space. The worker of this group
+    ///                               never blocks on its own queue. Transactions it enqueues are accepted beyond
+    ///                               the capacity instead. That covers observers, enqueued transactions and
+    ///                               continuations of completed transactions that enqueue to the same group.
+    ///                               Synchronous transactions and inputs on other threads still block, as does
+    ///                               the worker of another group. Two groups whose workers enqueue to each other
+    ///                               can therefore deadlock if both queues are full.
+    ///     fail                    - The transaction is rejected.
+    ///     drop_oldest_mergeable   - The oldest queued transaction with allow_merging is dropped to make space.
+    ///                               If there is none, the new transaction is rejected.
+    /// Transactions forwarded from linked groups are never blocked or rejected.
+    void SetTransactionQueueCapacity(size_t capacity, QueueOverflowPolicy policy = QueueOverflowPolicy::block)
+        { GetGraphPtr()->SetTransactionQueueCapacity(capacity, policy); }
+
+    /// Returns the current queue depth and the number of rejected and dropped transactions.
+    TransactionQueueStats GetTransactionQueueStats() const
+        { return GetGraphPtr()->GetTransactionQueueStats(); }
+
+    /// Returns update counts, update times and produced events of all nodes in this group.
+    /// Statistics are only collected if REACT_ENABLE_NODE_STATS is defined. Otherwise, the result is empty.
+    std::vector<NodeStats> GetNodeStats() const
+        { return GetGraphPtr()->GetNodeStats(); }
+
+    /// Returns up to count nodes with the highest total update time.
+    std::vector<NodeStats> GetHotNodes(size_t count) const
+        { return GetGraphPtr()->GetHotNodes(count); }
+
+    /// Returns up to count nodes whose updates mostly didn't change anything, i.e. that have an unchanged ratio
+    /// of at least minUnchangedRatio. They are sorted by the time spent on those updates. Observers are excluded.
+    std::vector<NodeStats> GetWastedNodes(size_t count, double minUnchangedRatio = 0.9) const
+        { return GetGraphPtr()->GetWastedNodes(count, minUnchangedRatio); }
+
+    void ResetNodeStats()
+        { GetGraphPtr()->ResetNodeStats(); }
+
+    /// Returns the allocations made while this group processed inputs and transactions.
+    /// Requires REACT_ENABLE_ALLOCATION_TRACKING and REACT_DEFINE_ALLOCATION_HOOKS, see react/common/allocation.h.
+    AllocationStats GetAllocationStats() const
+        { return GetGraphPtr()->GetAllocationStats(); }
+
+    void ResetAllocationStats()
+        { GetGraphPtr()->ResetAllocationStats(); }
+
+    /// Returns the memory used by the nodes of this group, by category and type.
+    /// Memory that is shared between nodes or allocated by values, like the contents of strings, is not included.
+    /// Must not be called while a transaction is in progress, or while nodes are created or destroyed.
+    GraphMemoryUsage GetMemoryUsage() const
+        { return GetGraphPtr()->GetMemoryUsage(); }
+
+    /// Returns all nodes of this group with their levels, successors, debug names and statistics.
+    /// Edges are given by the successors of each node.
+    /// Must not be called while a transaction is in progress, or while nodes are created or destroyed.
+    std::vector<GraphNodeInfo> GetNodes() const
+        { return GetGraphPtr()->GetNodeInfos(); }
+
+    /// Writes the graph of this group in Graphviz DOT format. Has the same precondition as GetNodes.
+    void WriteDot(std::ostream& out) const
+        { GetGraphPtr()->WriteDot(out); }
+
+    /// Writes the graph of this group as JSON. Has the same precondition as GetNodes.
+    void WriteJson(std::ostream& out) const
+        { GetGraphPtr()->WriteJson(out); }
+
+    /// Serializes the values of all state nodes with serializable types into a binary image.
+    /// Must not be called while a transaction is in progress. Input that is not propagated yet is not saved.
+    std::vector<char> SaveCheckpoint() const
+    {
+        std::vector<char> image;
+        CheckpointWriter out{ image };
+        GetGraphPtr()->SaveCheckpoint(out);
+        return image;
+    }
+
+    /// Restores an image created by SaveCheckpoint into a structurally identical group, without running
+    /// any update functions. The image is only read, so it can be a memory-mapped file.
+    /// Returns false if the image does not match this group, including the value types of its states.
+    /// In that case, nothing is restored.
+    /// Input that was set on the restored state variables, but not propagated yet, is dropped.
+    bool LoadCheckpoint(const void* data, size_t size)
+    {
+        CheckpointReader in{ data, size };
+        return GetGraphPtr()->LoadCheckpoint(in);
+    }
 
     friend bool operator==(const Group& a, const Group& b)
         { return a.GetGraphPtr() == b.GetGraphPtr(); }
@@ -59,6 +262,41 @@ public:
 
     friend auto GetInternals(const Group& g) -> const REACT_IMPL::GroupInternals&
         { return g; }
+
+private:
+    explicit Group(std::shared_ptr<REACT_IMPL::ReactGraph> graphPtr) :
+        Group::GroupInternals( std::move(graphPtr) )
+    { }
+
+    friend class REACT_IMPL::ReactGraph;
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/// TeardownScope
+/// Speeds up the destruction of the nodes of a group, for example before dropping a large graph.
+/// While the scope is active, destroyed nodes skip detaching from their predecessors and the group
+/// must not be used for transactions or inputs. When it ends, the node data of the destroyed nodes
+/// is freed at once. Nodes that are still alive, for example because an observer is held elsewhere,
+/// are detached from the destroyed ones and the group can be used as before.
+///////////////////////////////////////////////////////////////////////////////////////////////////
+class TeardownScope
+{
+public:
+    explicit TeardownScope(Group group) :
+        group_( std::move(group) )
+    {
+        GetInternals(group_).GetGraphPtr()->BeginTeardown();
+    }
+
+    TeardownScope(const TeardownScope&) = delete;
+    TeardownScope& operator=(const TeardownScope&) = delete;
+
+    ~TeardownScope()
+        { GetInternals(group_).GetGraphPtr()->EndTeardown(); }
+
+private:
+    // Keeps the graph alive after its last node is destroyed.
+    Group group_;
 };
 
 /******************************************/ REACT_END /******************************************/
@@ -14,6 +14,7 @@
 #include "react/group.h"
 
 #include <memory>
+#include <string>
 #include <utility>
 
 #include "react/detail/observer_nodes.h"
@@ -59,12 +60,64 @@ public:
     static Observer Create(F&& func, const Event<T>& subject, const State<Us>& ... states)
         { return CreateSyncedEventObserverNode(subject.GetGroup(), std::forward<F>(func), subject, states ...); }
 
+    // Construct async state observer with explicit group
+    // Async observers are called on a worker thread. Per observer, calls are made in the order of the turns.
+    // The options set the capacity of the observer queue and what happens when it's full. With the block policy,
+    // turns processed by the worker of a group don't wait; calls that don't fit are queued beyond the capacity.
+    // Once the observer is destroyed, it's not called anymore. Destruction waits for a call in progress.
+    template <typename F, typename T1, typename ... Ts>
+    static Observer Create(const Group& group, const AsyncObserverOptions& options, F&& func, const State<T1>& subject1, const State<Ts>& ... subjects)
+        { return CreateAsyncStateObserverNode(group, options, std::forward<F>(func), subject1, subjects ...); }
+
+    // Construct async state observer with implicit group
+    template <typename F, typename T1, typename ... Ts>
+    static Observer Create(const AsyncObserverOptions& options, F&& func, const State<T1>& subject1, const State<Ts>& ... subjects)
+        { return CreateAsyncStateObserverNode(subject1.GetGroup(), options, std::forward<F>(func), subject1, subjects ...); }
+
+    // Construct async event observer with explicit group
+    template <typename F, typename T>
+    static Observer Create(const Group& group, const AsyncObserverOptions& options, F&& func, const Event<T>& subject)
+        { return CreateAsyncEventObserverNode(group, options, std::forward<F>(func), subject); }
+
+    // Construct async event observer with implicit group
+    template <typename F, typename T>
+    static Observer Create(const AsyncObserverOptions& options, F&& func, const Event<T>& subject)
+        { return CreateAsyncEventObserverNode(subject.GetGroup(), options, std::forward<F>(func), subject); }
+
+    // Construct async synced event observer with explicit group
+    template <typename F, typename T, typename ... Us>
+    static Observer Create(const Group& group, const AsyncObserverOptions& options, F&& func, const Event<T>& subject, const State<Us>& ... states)
+        { return CreateAsyncSyncedEventObserverNode(group, options, std::forward<F>(func), subject, states ...); }
+
+    // Construct async synced event observer with implicit group
+    template <typename F, typename T, typename ... Us>
+    static Observer Create(const AsyncObserverOptions& options, F&& func, const Event<T>& subject, const State<Us>& ... states)
+        { return CreateAsyncSyncedEventObserverNode(subject.GetGroup(), options, std::forward<F>(func), subject, states ...); }
+
+    // Construct coalesced state observer with explicit group
+    // Coalesced observers are called at most once per batch of transactions, or per interval, with the latest values.
+    // A batch is at most a few hundred enqueued transactions. A synchronous input is a batch of its own.
+    // If the interval has not passed yet, the last change is delivered by an empty transaction that is enqueued
+    // once it has. Like any enqueued transaction, it must not overlap with synchronous inputs to the same group.
+    template <typename F, typename T1, typename ... Ts>
+    static Observer Create(const Group& group, const CoalescedObserverOptions& options, F&& func, const State<T1>& subject1, const State<Ts>& ... subjects)
+        { return CreateCoalescedStateObserverNode(group, options, std::forward<F>(func), subject1, subjects ...); }
+
+    // Construct coalesced state observer with implicit group
+    template <typename F, typename T1, typename ... Ts>
+    static Observer Create(const CoalescedObserverOptions& options, F&& func, const State<T1>& subject1, const State<Ts>& ... subjects)
+        { return CreateCoalescedStateObserverNode(subject1.GetGroup(), options, std::forward<F>(func), subject1, subjects ...); }
+
     Observer(const Observer&) = default;
     Observer& operator=(const Observer&) = default;
 
     Observer(Observer&&) = default;
     Observer& operator=(Observer&&) = default;
 
+    /// Sets a name that identifies the node in graph exports.
+    void SetDebugName(std::string name)
+        { nodePtr_->GetGraphPtr()->SetDebugName(nodePtr_->GetNodeId(), std::move(name)); }
+
 protected: //Internal
     Observer(std::shared_ptr<NodeType>&& nodePtr) :
         nodePtr_(std::move(nodePtr))
@@ -75,7 +128,7 @@ private:
     static auto CreateStateObserverNode(const Group& group, F&& func, const State<T1>& dep1, const State<Ts>& ... deps) -> decltype(auto)
     {
         using REACT_IMPL::StateObserverNode;
-        return std::make_shared<StateObserverNode<typename std::decay<F>::type, T1, Ts ...>>(
+        return REACT_IMPL::CreateNode<StateObserverNode<typename std::decay<F>::type, T1, Ts ...>>(
             group, std::forward<F>(func), SameGroupOrLink(group, dep1), SameGroupOrLink(group, deps) ...);
     }
 
@@ -83,7 +136,7 @@ private:
     static auto CreateEventObserverNode(const Group& group, F&& func, const Event<T>& dep) -> decltype(auto)
     {
         using REACT_IMPL::EventObserverNode;
-        return std::make_shared<EventObserverNode<typename std::decay<F>::type, T>>(
+        return REACT_IMPL::CreateNode<EventObserverNode<typename std::decay<F>::type, T>>(
             group, std::forward<F>(func), SameGroupOrLink(group, dep));
     }
 
@@ -91,10 +144,42 @@ private:
     static auto CreateSyncedEventObserverNode(const Group& group, F&& func, const Event<T>& dep, const State<Us>& ... syncs) -> decltype(auto)
     {
         using REACT_IMPL::SyncedEventObserverNode;
-        return std::make_shared<SyncedEventObserverNode<typename std::decay<F>::type, T, Us ...>>(
+        return REACT_IMPL::CreateNode<SyncedEventObserverNode<typename std::decay<F>::type, T, Us ...>>(
             group, std::forward<F>(func), SameGroupOrLink(group, dep), SameGroupOrLink(group, syncs) ...);
     }
 
+    template <typename F, typename T1, typename ... Ts>
+    static auto CreateAsyncStateObserverNode(const Group& group, const AsyncObserverOptions& options, F&& func, const State<T1>& dep1, const State<Ts>& ... deps) -> decltype(auto)
+    {
+        using REACT_IMPL::AsyncStateObserverNode;
+        return REACT_IMPL::CreateNode<AsyncStateObserverNode<typename std::decay<F>::type, T1, Ts ...>>(
+            group, options, std::forward<F>(func), SameGroupOrLink(group, dep1), SameGroupOrLink(group, deps) ...);
+    }
+
+    template <typename F, typename T>
+    static auto CreateAsyncEventObserverNode(const Group& group, const AsyncObserverOptions& options, F&& func, const Event<T>& dep) -> decltype(auto)
+    {
+        using REACT_IMPL::AsyncEventObserverNode;
+        return REACT_IMPL::CreateNode<AsyncEventObserverNode<typename std::decay<F>::type, T>>(
+            group, options, std::forward<F>(func), SameGroupOrLink(group, dep));
+    }
+
+    template <typename F, typename T, typename ... Us>
+    static auto CreateAsyncSyncedEventObserverNode(const Group& group, const AsyncObserverOptions& options, F&& func, const Event<T>& dep, const State<Us>& ... syncs) -> decltype(auto)
+    {
+        using REACT_IMPL::AsyncSyncedEventObserverNode;
+        return REACT_IMPL::CreateNode<AsyncSyncedEventObserverNode<typename std::decay<F>::type, T, Us ...>>(
+            group, options, std::forward<F>(func), SameGroupOrLink(group, dep), SameGroupOrLink(group, syncs) ...);
+    }
+
+    template <typename F, typename T1, typename ... Ts>
+    static auto CreateCoalescedStateObserverNode(const Group& group, const CoalescedObserverOptions& options, F&& func, const State<T1>& dep1, const State<Ts>& ... deps) -> decltype(auto)
+    {
+        using REACT_IMPL::CoalescedStateObserverNode;
+        return REACT_IMPL::CreateNode<CoalescedStateObserverNode<typename std::decay<F>::type, T1, Ts ...>>(
+            group, options, std::forward<F>(func), SameGroupOrLink(group, dep1), SameGroupOrLink(group, deps) ...);
+    }
+
 private:
     std::shared_ptr<NodeType> nodePtr_;
 };
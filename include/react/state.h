@@ -16,6 +16,7 @@
 #include "react/detail/state_nodes.h"
 
 #include <memory>
+#include <string>
 #include <tuple>
 #include <type_traits>
 #include <utility>
@@ -55,8 +56,9 @@ public:
     auto GetGroup() const -> const Group&
         { return this->GetNodePtr()->GetGroup(); }
 
-    auto GetGroup() -> Group&
-        { return this->GetNodePtr()->GetGroup(); }
+    /// Sets a name that identifies the node in graph exports.
+    void SetDebugName(std::string name)
+        { this->GetNodePtr()->GetGraphPtr()->SetDebugName(this->GetNodeId(), std::move(name)); }
 
     friend bool operator==(const State<S>& a, const State<S>& b)
         { return a.GetNodePtr() == b.GetNodePtr(); }
@@ -82,7 +84,7 @@ private:
         using REACT_IMPL::StateFuncNode;
         using REACT_IMPL::SameGroupOrLink;
 
-        return std::make_shared<StateFuncNode<S, typename std::decay<F>::type, T1, Ts ...>>(
+        return REACT_IMPL::CreateNode<StateFuncNode<S, typename std::decay<F>::type, T1, Ts ...>>(
             group, std::forward<F>(func), SameGroupOrLink(group, dep1), SameGroupOrLink(group, deps) ...);
     }
 
@@ -142,14 +144,14 @@ private:
     static auto CreateVarNode(const Group& group) -> decltype(auto)
     {
         using REACT_IMPL::StateVarNode;
-        return std::make_shared<StateVarNode<S>>(group);
+        return REACT_IMPL::CreateNode<StateVarNode<S>>(group);
     }
 
     template <typename T>
     static auto CreateVarNode(const Group& group, T&& value) -> decltype(auto)
     {
         using REACT_IMPL::StateVarNode;
-        return std::make_shared<StateVarNode<S>>(group, std::forward<T>(value));
+        return REACT_IMPL::CreateNode<StateVarNode<S>>(group, std::forward<T>(value));
     }
 
     template <typename T>
@@ -161,7 +163,7 @@ private:
         VarNodeType* castedPtr = static_cast<VarNodeType*>(this->GetNodePtr().get());
 
         NodeId nodeId = castedPtr->GetNodeId();
-        auto& graphPtr = GetInternals(this->GetGroup()).GetGraphPtr();
+        auto* graphPtr = this->GetNodePtr()->GetGraphPtr();
 
         graphPtr->PushInput(nodeId, [castedPtr, &newValue] { castedPtr->SetValue(std::forward<T>(newValue)); });
     }
@@ -175,7 +177,7 @@ private:
         VarNodeType* castedPtr = static_cast<VarNodeType*>(this->GetNodePtr().get());
         
         NodeId nodeId = castedPtr->GetNodeId();
-        auto& graphPtr = GetInternals(this->GetGroup()).GetGraphPtr();
+        auto* graphPtr = this->GetNodePtr()->GetGraphPtr();
 
         graphPtr->PushInput(nodeId, [castedPtr, &func] { castedPtr->ModifyValue(func); });
     }
@@ -218,7 +220,7 @@ private:
         using REACT_IMPL::StateSlotNode;
         using REACT_IMPL::SameGroupOrLink;
 
-        return std::make_shared<StateSlotNode<S>>(group, SameGroupOrLink(group, input));
+        return REACT_IMPL::CreateNode<StateSlotNode<S>>(group, SameGroupOrLink(group, input));
     }
 
     void SetSlotInput(const State<S>& newInput)
@@ -230,7 +232,7 @@ private:
         auto* castedPtr = static_cast<StateSlotNode<S>*>(this->GetNodePtr().get());
 
         NodeId nodeId = castedPtr->GetInputNodeId();
-        auto& graphPtr = GetInternals(this->GetGroup()).GetGraphPtr();
+        auto* graphPtr = this->GetNodePtr()->GetGraphPtr();
 
         graphPtr->PushInput(nodeId, [this, castedPtr, &newInput] { castedPtr->SetInput(SameGroupOrLink(GetGroup(), newInput)); });
     }
@@ -273,7 +275,7 @@ private:
 
         std::shared_ptr<IReactNode> nodePtr = linkCache.LookupOrCreate(k, [&]
             {
-                auto nodePtr = std::make_shared<StateLinkNode<S>>(group, input);
+                auto nodePtr = REACT_IMPL::CreateNode<StateLinkNode<S>>(group, input);
                 nodePtr->SetWeakSelfPtr(std::weak_ptr<StateLinkNode<S>>{ nodePtr });
                 return std::static_pointer_cast<IReactNode>(nodePtr);
             });
@@ -0,0 +1,267 @@
+//          Copyright Sebastian Jeckel 2017.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include "react/detail/defs.h"
+
+#include <climits>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#if defined(_WIN32)
+    #define WIN32_LEAN_AND_MEAN
+    #define NOMINMAX
+    #include <windows.h>
+#elif defined(__linux__)
+    #include <pthread.h>
+    #include <sched.h>
+    #include <sys/syscall.h>
+    #include <unistd.h>
+#endif
+
+#include "react/common/numa.h"
+
+/***************************************/ REACT_IMPL_BEGIN /**************************************/
+
+#if defined(_WIN32)
+
+static_assert(sizeof(GROUP_AFFINITY) <= 128, "Affinity buffer too small.");
+
+bool BindMemoryToNumaNode(const void* p, size_t size, int numaNode)
+{
+    // Windows can only place memory when it is allocated.
+    return false;
+}
+
+bool UnbindMemoryFromNumaNode(const void* p, size_t size)
+{
+    return false;
+}
+
+NumaThreadScope::NumaThreadScope(int numaNode)
+{
+    if (numaNode < 0 || numaNode > USHRT_MAX)
+        return;
+
+    GROUP_AFFINITY affinity = { };
+
+    if (!GetNumaNodeProcessorMaskEx(static_cast<USHORT>(numaNode), &affinity) || affinity.Mask == 0)
+        return;
+
+    isBound_ = SetThreadGroupAffinity(GetCurrentThread(), &affinity, reinterpret_cast<GROUP_AFFINITY*>(previousAffinity_)) != 0;
+}
+
+NumaThreadScope::~NumaThreadScope()
+{
+    if (isBound_)
+        SetThreadGroupAffinity(GetCurrentThread(), reinterpret_cast<const GROUP_AFFINITY*>(previousAffinity_), nullptr);
+}
+
+#elif defined(__linux__)
+
+static_assert(sizeof(cpu_set_t) <= 128, "Affinity buffer too small.");
+
+// Parses lists like "0-3,8-11" from sysfs. Calls func(first, last) for each range.
+template <typename F>
+static bool ParseNumaList(const std::string& path, F&& func)
+{
+    std::ifstream in(path.c_str());
+    std::string list;
+
+    if (!std::getline(in, list) || list.empty())
+        return false;
+
+    size_t pos = 0;
+
+    while (pos < list.size())
+    {
+        size_t end = list.find(',', pos);
+        if (end == std::string::npos)
+            end = list.size();
+
+        std::string range = list.substr(pos, end - pos);
+        size_t dash = range.find('-');
+
+        int first = std::stoi(range.substr(0, dash));
+        int last = dash != std::string::npos ? std::stoi(range.substr(dash + 1)) : first;
+
+        func(first, last);
+
+        pos = end + 1;
+    }
+
+    return true;
+}
+
+// Applies a memory policy to the pages that are completely inside [p, p + size).
+static bool SetMemoryPolicy(const void* p, size_t size, int mode, const unsigned long* nodeMask, size_t maxNode, unsigned flags)
+{
+#if defined(SYS_mbind)
+    if (p == nullptr)
+        return false;
+
+    uintptr_t pageSize = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+    uintptr_t begin = (reinterpret_cast<uintptr_t>(p) + pageSize - 1) & ~(pageSize - 1);
+    uintptr_t end = (reinterpret_cast<uintptr_t>(p) + size) & ~(pageSize - 1);
+
+    if (begin >= end)
+        return false;
+
+    return syscall(SYS_mbind, reinterpret_cast<void*>(begin), end - begin, mode, nodeMask, maxNode, flags) == 0;
+#else
+    return false;
+#endif
+}
+
+bool BindMemoryToNumaNode(const void* p, size_t size, int numaNode)
+{
+    // From numaif.h, which is not available without libnuma.
+    static const int mpol_preferred = 1;
+    static const unsigned mpol_mf_move = 1 << 1;
+
+    static const size_t bits_per_word = sizeof(unsigned long) * CHAR_BIT;
+
+    if (numaNode < 0 || numaNode >= GetNumaNodeCount())
+        return false;
+
+    std::vector<unsigned long> nodeMask(numaNode / bits_per_word + 1, 0);
+    nodeMask[numaNode / bits_per_word] |= 1ul << (numaNode % bits_per_word);
+
+    return SetMemoryPolicy(p, size, mpol_preferred, nodeMask.data(), nodeMask.size() * bits_per_word + 1, mpol_mf_move);
+}
+
+bool UnbindMemoryFromNumaNode(const void* p, size_t size)
+{
+    static const int mpol_default = 0;
+
+    return SetMemoryPolicy(p, size, mpol_default, nullptr, 0, 0);
+}
+
+// The processors of each node are read from sysfs once. An empty set means the node has none.
+static const std::vector<cpu_set_t>& GetNumaNodeProcessors()
+{
+    static const std::vector<cpu_set_t> processors = []
+        {
+            std::vector<cpu_set_t> result(GetNumaNodeCount());
+
+            for (size_t numaNode = 0; numaNode < result.size(); ++numaNode)
+            {
+                cpu_set_t& cpus = result[numaNode];
+                CPU_ZERO(&cpus);
+
+                bool isValid = ParseNumaList("/sys/devices/system/node/node" + std::to_string(numaNode) + "/cpulist", [&] (int first, int last)
+                    {
+                        for (int cpu = first; cpu <= last && cpu < CPU_SETSIZE; ++cpu)
+                            CPU_SET(cpu, &cpus);
+                    });
+
+                if (!isValid)
+                    CPU_ZERO(&cpus);
+            }
+
+            return result;
+        }();
+
+    return processors;
+}
+
+// Node that the current thread is bound to by an active scope, or -1.
+static int& GetThreadNumaNode()
+{
+    static thread_local int numaNode = -1;
+    return numaNode;
+}
+
+NumaThreadScope::NumaThreadScope(int numaNode)
+{
+    // Nested scopes for the same node, like a worker that processes the queue of another group of its node,
+    // don't have to touch the affinity again.
+    if (numaNode < 0 || numaNode == GetThreadNumaNode())
+        return;
+
+    const std::vector<cpu_set_t>& processors = GetNumaNodeProcessors();
+
+    if (static_cast<size_t>(numaNode) >= processors.size() || CPU_COUNT(&processors[numaNode]) == 0)
+        return;
+
+    cpu_set_t* previous = reinterpret_cast<cpu_set_t*>(previousAffinity_);
+
+    if (pthread_getaffinity_np(pthread_self(), sizeof(cpu_set_t), previous) != 0)
+        return;
+
+    isBound_ = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &processors[numaNode]) == 0;
+
+    if (isBound_)
+    {
+        previousNumaNode_ = GetThreadNumaNode();
+        GetThreadNumaNode() = numaNode;
+    }
+}
+
+NumaThreadScope::~NumaThreadScope()
+{
+    if (isBound_)
+    {
+        pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), reinterpret_cast<const cpu_set_t*>(previousAffinity_));
+        GetThreadNumaNode() = previousNumaNode_;
+    }
+}
+
+#else
+
+bool BindMemoryToNumaNode(const void* p, size_t size, int numaNode)
+{
+    return false;
+}
+
+bool UnbindMemoryFromNumaNode(const void* p, size_t size)
+{
+    return false;
+}
+
+NumaThreadScope::NumaThreadScope(int numaNode)
+{ }
+
+NumaThreadScope::~NumaThreadScope()
+{ }
+
+#endif
+
+static int ReadNumaNodeCount()
+{
+#if defined(_WIN32)
+    ULONG highestNode = 0;
+
+    if (GetNumaHighestNodeNumber(&highestNode))
+        return static_cast<int>(highestNode) + 1;
+#elif defined(__linux__)
+    int highestNode = -1;
+
+    ParseNumaList("/sys/devices/system/node/possible", [&] (int first, int last)
+        {
+            if (highestNode < last)
+                highestNode = last;
+        });
+
+    if (highestNode >= 0)
+        return highestNode + 1;
+#endif
+
+    return 1;
+}
+
+/****************************************/ REACT_IMPL_END /***************************************/
+
+/*****************************************/ REACT_BEGIN /*****************************************/
+
+int GetNumaNodeCount()
+{
+    // The possible nodes don't change while the process is running.
+    static const int nodeCount = REACT_IMPL::ReadNumaNodeCount();
+    return nodeCount;
+}
+
+/******************************************/ REACT_END /******************************************/
@@ -7,29 +7,105 @@
 
 #include <algorithm>
 #include <atomic>
+#include <cassert>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
 #include <type_traits>
+#include <typeindex>
+#include <typeinfo>
 #include <utility>
 #include <vector>
 #include <map>
 #include <mutex>
+#include <ostream>
+#include <thread>
 
-#include <tbb/concurrent_queue.h>
 #include <tbb/task.h>
 
+#include "react/common/tracing.h"
 #include "react/detail/graph_interface.h"
 #include "react/detail/graph_impl.h"
+#include "react/group.h"
 
 
 /***************************************/ REACT_IMPL_BEGIN /**************************************/
 
+// Checkpoint image layout:
+//  header:     magic, version, slot extent, node count
+//  records:    node id, type tag, payload size, payload (one record per node that saved its state)
+static const uint32_t checkpoint_magic = 0x50435243; // "CRCP"
+static const uint32_t checkpoint_version = 2;
+
+ReactGraph::ReactGraph() = default;
+
+ReactGraph::~ReactGraph()
+{
+    // The heap must not reuse the storage with its placement.
+    if (GetNumaNode() >= 0)
+        PlaceNodeData(-1);
+}
+
 NodeId ReactGraph::RegisterNode(IReactNode* nodePtr, NodeCategory category)
 {
-    return nodeData_.Insert(NodeData{ nodePtr, category });
+    if (nodeData_.GetSize() == 0)
+        selfGroup_.reset(new Group( shared_from_this() ));
+
+    if (isTearingDown_)
+        ++teardownNodeCount_;
+
+    int numaNode = GetNumaNode();
+
+    // If the storage is reallocated, the old one is freed with its placement, unless it's unbound first.
+    bool isPlacedGrowth = numaNode >= 0 && nodeData_.GetSize() == nodeData_.GetCapacity();
+
+    if (isPlacedGrowth)
+        PlaceNodeData(-1);
+
+    NodeId nodeId = nodeData_.Insert(NodeData{ nodePtr, category });
+
+    if (isPlacedGrowth)
+        PlaceNodeData(numaNode);
+
+#if defined(REACT_ENABLE_NODE_STATS)
+    // Ids are reused, so the counters of a previous node have to be reset.
+    if (nodeId < nodeStats_.size())
+        nodeStats_[nodeId] = NodeUpdateStats{ };
+    else
+        nodeStats_.resize(nodeId + 1);
+#endif
+
+    return nodeId;
 }
 
 void ReactGraph::UnregisterNode(NodeId nodeId)
 {
+    // Destroyed nodes are only marked. EndTeardown frees them at once.
+    // The teardown scope holds a group, so the graph stays alive until then.
+    if (isTearingDown_)
+    {
+        nodeData_[nodeId].nodePtr = nullptr;
+        --teardownNodeCount_;
+        return;
+    }
+
+    // The id might be reused, so pending output must not be flushed.
+    if (!deferredOutputs_.empty())
+        deferredOutputs_.erase(std::remove(deferredOutputs_.begin(), deferredOutputs_.end(), nodeId), deferredOutputs_.end());
+
+    {// debugNamesMutex_
+        std::lock_guard<std::mutex> scopedLock(debugNamesMutex_);
+        debugNames_.erase(nodeId);
+    }// ~debugNamesMutex_
+
     nodeData_.Erase(nodeId);
+
+    // Releasing the last reference destroys the graph, so this must come last.
+    if (nodeData_.GetSize() == 0)
+    {
+        std::unique_ptr<Group> selfGroup = std::move(selfGroup_);
+    }
 }
 
 void ReactGraph::AttachNode(NodeId nodeId, NodeId parentId)
@@ -45,12 +121,111 @@ void ReactGraph::AttachNode(NodeId nodeId, NodeId parentId)
 
 void ReactGraph::DetachNode(NodeId nodeId, NodeId parentId)
 {
+    // Both nodes are going away anyway.
+    if (isTearingDown_)
+        return;
+
     auto& parent = nodeData_[parentId];
     auto& successors = parent.successors;
 
     successors.erase(std::find(successors.begin(), successors.end(), nodeId));
 }
 
+void ReactGraph::BeginTeardown()
+{
+    if (teardownLevel_++ > 0)
+        return;
+
+    isTearingDown_ = true;
+    teardownNodeCount_ = nodeData_.GetSize();
+
+    // Output of nodes that are about to be destroyed is discarded.
+    deferredOutputs_.clear();
+}
+
+void ReactGraph::EndTeardown()
+{
+    if (--teardownLevel_ > 0)
+        return;
+
+    isTearingDown_ = false;
+
+    if (teardownNodeCount_ == 0)
+    {
+        if (GetNumaNode() >= 0)
+            PlaceNodeData(-1);
+
+        nodeData_.Reset();
+        std::vector<NodeUpdateStats>().swap(nodeStats_);
+
+        {// debugNamesMutex_
+            std::lock_guard<std::mutex> scopedLock(debugNamesMutex_);
+            debugNames_.clear();
+        }// ~debugNamesMutex_
+    }
+    else
+    {
+        // Some nodes are still alive, for example because a handle to them is held elsewhere.
+        // Destroyed nodes were not detached, so they have to be removed from the successors of the survivors.
+        std::vector<bool> isDestroyed(nodeData_.GetExtent(), false);
+        std::vector<NodeId> survivorIds;
+
+        nodeData_.ForEach([&] (size_t nodeId, const NodeData& node)
+            {
+                if (node.nodePtr == nullptr)
+                    isDestroyed[nodeId] = true;
+                else
+                    survivorIds.push_back(nodeId);
+            });
+
+        for (NodeId nodeId : survivorIds)
+        {
+            auto& successors = nodeData_[nodeId].successors;
+            successors.erase(std::remove_if(successors.begin(), successors.end(), [&] (NodeId succId) { return isDestroyed[succId]; }), successors.end());
+        }
+
+        for (NodeId nodeId = 0; nodeId < isDestroyed.size(); ++nodeId)
+            if (isDestroyed[nodeId])
+                nodeData_.Erase(nodeId);
+
+        {// debugNamesMutex_
+            std::lock_guard<std::mutex> scopedLock(debugNamesMutex_);
+
+            for (auto it = debugNames_.begin(); it != debugNames_.end(); )
+            {
+                if (isDestroyed[it->first])
+                    it = debugNames_.erase(it);
+                else
+                    ++it;
+            }
+        }// ~debugNamesMutex_
+    }
+
+    // Releasing the last reference destroys the graph, but the caller still holds a group.
+    if (nodeData_.GetSize() == 0)
+    {
+        std::unique_ptr<Group> selfGroup = std::move(selfGroup_);
+    }
+}
+
+void ReactGraph::SetNumaNode(int numaNode)
+{
+    numaNode_.store(numaNode, std::memory_order_relaxed);
+
+    PlaceNodeData(numaNode);
+}
+
+void ReactGraph::PlaceNodeData(int numaNode)
+{
+    if (nodeData_.GetCapacity() == 0)
+        return;
+
+    if (numaNode >= 0)
+        BindMemoryToNumaNode(nodeData_.GetStorage(), nodeData_.GetCapacity() * sizeof(NodeData), numaNode);
+    else
+        UnbindMemoryFromNumaNode(nodeData_.GetStorage(), nodeData_.GetCapacity() * sizeof(NodeData));
+}
+
 void ReactGraph::AddSyncPointDependency(SyncPoint::Dependency dep, bool syncLinked)
 {
     if (syncLinked)
@@ -61,18 +236,394 @@ void ReactGraph::AddSyncPointDependency(SyncPoint::Dependency dep, bool syncLink
 
 void ReactGraph::AllowLinkedTransactionMerging(bool allowMerging)
 {
-    allowLinkedTransactionMerging_ = true;
+    allowLinkedTransactionMerging_ = allowMerging;
+}
+
+void ReactGraph::SetLinkedTransactionPriority(TransactionFlags priority)
+{
+    linkedTransactionPriority_ = priority;
+}
+
+void ReactGraph::EndBatch()
+{
+    if (--batchLevel_ > 0)
+        return;
+
+    if (!deferredOutputs_.empty())
+        FlushDeferredOutputs();
+
+    ReleaseDependencies();
+}
+
+NodeStats ReactGraph::MakeNodeStats(NodeId nodeId, const NodeData& node) const
+{
+    NodeStats stats;
+
+    stats.nodeId = nodeId;
+    stats.typeName = GetTypeName(typeid(*node.nodePtr));
+
+    if (nodeId >= nodeStats_.size())
+        return stats;
+
+    const NodeUpdateStats& counters = nodeStats_[nodeId];
+
+    stats.updateCount = counters.updateCount;
+    stats.changedCount = counters.changedCount;
+    stats.eventCount = counters.eventCount;
+    stats.totalUpdateTime = std::chrono::nanoseconds(counters.totalTime);
+    stats.maxUpdateTime = std::chrono::nanoseconds(counters.maxTime);
+
+    return stats;
+}
+
+static const char* GetCategoryName(NodeCategory category)
+{
+    switch (category)
+    {
+    case NodeCategory::normal:      return "normal";
+    case NodeCategory::input:       return "input";
+    case NodeCategory::dyninput:    return "dyninput";
+    case NodeCategory::output:      return "output";
+    case NodeCategory::linkoutput:  return "linkoutput";
+    default:                        return "unknown";
+    }
+}
+
+std::vector<NodeStats> ReactGraph::GetNodeStats() const
+{
+    std::vector<NodeStats> result;
+
+#if defined(REACT_ENABLE_NODE_STATS)
+    nodeData_.ForEach([&] (size_t nodeId, const NodeData& node) { result.push_back(MakeNodeStats(nodeId, node)); });
+#endif
+
+    return result;
+}
+
+std::vector<NodeStats> ReactGraph::GetHotNodes(size_t count) const
+{
+    std::vector<NodeStats> result = GetNodeStats();
+
+    count = (std::min)(count, result.size());
+
+    std::partial_sort(result.begin(), result.begin() + count, result.end(),
+        [] (const NodeStats& a, const NodeStats& b) { return a.totalUpdateTime > b.totalUpdateTime; });
+
+    result.resize(count);
+    return result;
+}
+
+std::vector<NodeStats> ReactGraph::GetWastedNodes(size_t count, double minUnchangedRatio) const
+{
+    std::vector<NodeStats> result = GetNodeStats();
+
+    // Outputs never report a change, so they are not considered.
+    result.erase(std::remove_if(result.begin(), result.end(), [=] (const NodeStats& s)
+        {
+            NodeCategory category = nodeData_[s.nodeId].category;
+
+            if (s.updateCount == 0 || category == NodeCategory::output || category == NodeCategory::linkoutput)
+                return true;
+
+            double unchangedRatio = static_cast<double>(s.updateCount - s.changedCount) / static_cast<double>(s.updateCount);
+            return unchangedRatio < minUnchangedRatio;
+        }), result.end());
+
+    count = (std::min)(count, result.size());
+
+    // Most time spent on updates that didn't change anything first.
+    auto wastedTime = [] (const NodeStats& s)
+        { return s.totalUpdateTime.count() / static_cast<double>(s.updateCount) * static_cast<double>(s.updateCount - s.changedCount); };
+
+    std::partial_sort(result.begin(), result.begin() + count, result.end(),
+        [&] (const NodeStats& a, const NodeStats& b) { return wastedTime(a) > wastedTime(b); });
+
+    result.resize(count);
+    return result;
+}
+
+void ReactGraph::ResetNodeStats()
+{
+    nodeStats_.assign(nodeStats_.size(), NodeUpdateStats{ });
+}
+
+void ReactGraph::SetDebugName(NodeId nodeId, std::string name)
+{
+    std::lock_guard<std::mutex> scopedLock(debugNamesMutex_);
+
+    if (name.empty())
+        debugNames_.erase(nodeId);
+    else
+        debugNames_[nodeId] = std::move(name);
+}
+
+GraphMemoryUsage ReactGraph::GetMemoryUsage() const
+{
+    GraphMemoryUsage result;
+
+    std::map<NodeCategory, NodeMemoryUsage> categories;
+    std::map<std::pair<std::type_index, NodeCategory>, NodeMemoryUsage> types;
+
+    nodeData_.ForEach([&] (size_t nodeId, const NodeData& node)
+        {
+            const std::type_info& type = typeid(*node.nodePtr);
+            size_t successorBytes = node.successors.capacity() * sizeof(NodeId);
+            size_t bufferBytes = node.nodePtr->GetBufferSize();
+
+            auto res = types.emplace(std::make_pair(std::type_index(type), node.category), NodeMemoryUsage{ });
+            NodeMemoryUsage& typeUsage = res.first->second;
+
+            if (res.second)
+                typeUsage.typeName = GetTypeName(type);
+
+            for (NodeMemoryUsage* usage : { &categories[node.category], &typeUsage })
+            {
+                usage->category = GetCategoryName(node.category);
+                usage->nodeCount += 1;
+                usage->objectBytes += node.objectSize;
+                usage->successorBytes += successorBytes;
+                usage->bufferBytes += bufferBytes;
+            }
+        });
+
+    result.nodeCount = nodeData_.GetSize();
+    result.nodeDataBytes = nodeData_.GetAllocatedSize() + nodeStats_.capacity() * sizeof(NodeUpdateStats);
+    result.nodeDataSlackBytes = (nodeData_.GetCapacity() - nodeData_.GetSize()) * sizeof(NodeData);
+
+    for (const auto& e : categories)
+        result.categories.push_back(e.second);
+
+    for (const auto& e : types)
+        result.types.push_back(e.second);
+
+    std::stable_sort(result.types.begin(), result.types.end(),
+        [] (const NodeMemoryUsage& a, const NodeMemoryUsage& b) { return a.GetTotalBytes() > b.GetTotalBytes(); });
+
+    return result;
+}
+
+std::vector<GraphNodeInfo> ReactGraph::GetNodeInfos() const
+{
+    std::vector<GraphNodeInfo> result;
+
+    result.reserve(nodeData_.GetExtent());
+
+    std::lock_guard<std::mutex> scopedLock(debugNamesMutex_);
+
+    nodeData_.ForEach([&] (size_t nodeId, const NodeData& node)
+        {
+            GraphNodeInfo info;
+
+            info.nodeId = nodeId;
+            info.typeName = GetTypeName(typeid(*node.nodePtr));
+            info.category = GetCategoryName(node.category);
+            info.level = node.level;
+            info.successors = node.successors;
+            info.stats = MakeNodeStats(nodeId, node);
+
+            auto it = debugNames_.find(nodeId);
+            if (it != debugNames_.end())
+                info.debugName = it->second;
+
+            result.push_back(std::move(info));
+        });
+
+    return result;
+}
+
+void ReactGraph::WriteDot(std::ostream& out) const
+{
+    out << "digraph group {\n";
+    out << "    node [shape=box];\n";
+
+    for (const GraphNodeInfo& info : GetNodeInfos())
+    {
+        out << "    n" << info.nodeId << " [label=\"";
+
+        // Quotes in names have to be escaped. Label lines are separated by \n.
+        if (info.debugName.empty())
+            out << '#' << info.nodeId;
+
+        for (char c : info.debugName)
+        {
+            if (c == '"' || c == '\\')
+                out << '\\';
+            out << c;
+        }
+
+        out << "\\n" << info.typeName
+            << "\\nlevel " << info.level << ", fan-out " << info.successors.size();
+
+        if (is_node_stats_enabled)
+        {
+            out << "\\n" << info.stats.updateCount << " updates, " << info.stats.changedCount << " changed, "
+                << info.stats.totalUpdateTime.count() / 1000 << " us";
+        }
+
+        out << '"';
+
+        if (std::strcmp(info.category, "input") == 0)
+            out << ", style=filled, fillcolor=lightblue";
+        else if (std::strcmp(info.category, "output") == 0 || std::strcmp(info.category, "linkoutput") == 0)
+            out << ", style=filled, fillcolor=lightgrey";
+
+        out << "];\n";
+
+        for (size_t succId : info.successors)
+            out << "    n" << info.nodeId << " -> n" << succId << ";\n";
+    }
+
+    out << "}\n";
+}
+
+void ReactGraph::WriteJson(std::ostream& out) const
+{
+    bool isFirst = true;
+
+    out << "{\"nodes\":[";
+
+    for (const GraphNodeInfo& info : GetNodeInfos())
+    {
+        if (!isFirst)
+            out << ',';
+        isFirst = false;
+
+        out << "\n{\"id\":" << info.nodeId << ",\"name\":";
+        WriteJsonString(out, info.debugName.c_str());
+        out << ",\"type\":";
+        WriteJsonString(out, info.typeName);
+        out << ",\"category\":\"" << info.category << '"'
+            << ",\"level\":" << info.level
+            << ",\"fanOut\":" << info.successors.size()
+            << ",\"successors\":[";
+
+        for (size_t i = 0; i < info.successors.size(); ++i)
+            out << (i > 0 ? "," : "") << info.successors[i];
+
+        out << ']';
+
+        if (is_node_stats_enabled)
+        {
+            out << ",\"stats\":{\"updates\":" << info.stats.updateCount
+                << ",\"changed\":" << info.stats.changedCount
+                << ",\"events\":" << info.stats.eventCount
+                << ",\"totalTimeNs\":" << info.stats.totalUpdateTime.count()
+                << ",\"maxTimeNs\":" << info.stats.maxUpdateTime.count() << '}';
+        }
+
+        out << '}';
+    }
+
+    out << "\n]}\n";
+}
+
+void ReactGraph::SaveCheckpoint(CheckpointWriter& out) const
+{
+    uint64_t nodeCount = 0;
+    nodeData_.ForEach([&] (size_t, const NodeData&) { ++nodeCount; });
+
+    out.WriteValue(checkpoint_magic);
+    out.WriteValue(checkpoint_version);
+    out.WriteValue(static_cast<uint64_t>(nodeData_.GetExtent()));
+    out.WriteValue(nodeCount);
+
+    nodeData_.ForEach([&] (size_t nodeId, const NodeData& node)
+        {
+            size_t recordPos = out.Tell();
+
+            out.WriteValue(static_cast<uint64_t>(nodeId));
+            out.WriteValue(node.nodePtr->GetStateTypeTag());
+            out.WriteValue(static_cast<uint64_t>(0));
+
+            size_t payloadPos = out.Tell();
+
+            // Nodes without serializable state don't leave a record.
+            if (!node.nodePtr->SaveState(out))
+            {
+                out.Truncate(recordPos);
+                return;
+            }
+
+            uint64_t payloadSize = out.Tell() - payloadPos;
+            out.Patch(payloadPos - sizeof(uint64_t), &payloadSize, sizeof(uint64_t));
+        });
+}
+
+bool ReactGraph::LoadCheckpoint(CheckpointReader& in)
+{
+    uint32_t magic;
+    uint32_t version;
+    uint64_t extent;
+    uint64_t nodeCount;
+
+    if (!in.ReadValue(magic) || magic != checkpoint_magic)
+        return false;
+
+    if (!in.ReadValue(version) || version != checkpoint_version)
+        return false;
+
+    // The graph must be structurally identical, i.e. it must have been constructed in the same order.
+    std::vector<IReactNode*> nodes(nodeData_.GetExtent(), nullptr);
+    nodeData_.ForEach([&] (size_t nodeId, const NodeData& node) { nodes[nodeId] = node.nodePtr; });
+
+    uint64_t curNodeCount = std::count_if(nodes.begin(), nodes.end(), [] (IReactNode* p) { return p != nullptr; });
+
+    if (!in.ReadValue(extent) || extent != nodes.size())
+        return false;
+
+    if (!in.ReadValue(nodeCount) || nodeCount != curNodeCount)
+        return false;
+
+    // All records are checked before any of them is restored, so an image that doesn't match changes nothing.
+    std::vector<std::pair<IReactNode*, CheckpointReader>> records;
+
+    while (!in.IsAtEnd())
+    {
+        uint64_t nodeId;
+        uint64_t typeTag;
+        uint64_t payloadSize;
+        CheckpointReader payload{ nullptr, 0 };
+
+        if (!in.ReadValue(nodeId) || !in.ReadValue(typeTag) || !in.ReadValue(payloadSize) || !in.ReadRange(static_cast<size_t>(payloadSize), payload))
+            return false;
+
+        if (nodeId >= nodes.size() || nodes[static_cast<size_t>(nodeId)] == nullptr)
+            return false;
+
+        IReactNode* nodePtr = nodes[static_cast<size_t>(nodeId)];
+
+        if (typeTag == 0 || typeTag != nodePtr->GetStateTypeTag())
+            return false;
+
+        CheckpointReader check = payload;
+
+        if (!nodePtr->CheckState(check) || !check.IsAtEnd())
+            return false;
+
+        records.emplace_back(nodePtr, payload);
+    }
+
+    // Values are written directly. Update functions are not run and nothing is propagated.
+    for (auto& record : records)
+        record.first->RestoreState(record.second);
+
+    return true;
 }
 
 void ReactGraph::Propagate()
 {
+    REACT_TRACE_SCOPE(turn, "Turn", changedInputs_.size());
+
+    // Successor lists may still contain destroyed nodes.
+    assert(!isTearingDown_ && "Turns are not allowed during teardown");
+
     // Fill update queue with successors of changed inputs.
     for (NodeId nodeId : changedInputs_)
     {
         auto& node = nodeData_[nodeId];
         auto* nodePtr = node.nodePtr;
 
-        UpdateResult res = nodePtr->Update(0u);
+        UpdateResult res = UpdateNode(nodeId, node);
 
         if (res == UpdateResult::changed)
         {
@@ -84,6 +635,8 @@ void ReactGraph::Propagate()
     // Propagate changes.
     while (scheduledNodes_.FetchNext())
     {
+        REACT_TRACE_SCOPE(level, "Level", scheduledNodes_.GetLevel());
+
         for (NodeId nodeId : scheduledNodes_.Next())
         {
             auto& node = nodeData_[nodeId];
@@ -104,10 +657,11 @@ void ReactGraph::Propagate()
             if (node.category == NodeCategory::linkoutput)
             {
                 node.nodePtr->CollectOutput(scheduledLinkOutputs_);
+                node.queued = false;
                 continue;
             }
 
-            UpdateResult res = nodePtr->Update(0u);
+            UpdateResult res = UpdateNode(nodeId, node);
 
             // Topology changed?
             if (res == UpdateResult::shifted)
@@ -135,12 +689,88 @@ void ReactGraph::Propagate()
     for (IReactNode* nodePtr : changedNodes_)
         nodePtr->Clear();
     changedNodes_.clear();
+    changedInputs_.clear();
 
     // Clean link state.
     scheduledLinkOutputs_.clear();
+    allowLinkedTransactionMerging_ = false;
+    linkedTransactionPriority_ = TransactionFlags::none;
+
+    // Held until deferred outputs of the batch have been flushed.
+    for (auto& dep : localDependencies_)
+        heldDependencies_.push_back(std::move(dep));
+    for (auto& dep : linkDependencies_)
+        heldDependencies_.push_back(std::move(dep));
+
     localDependencies_.clear();
     linkDependencies_.clear();
-    allowLinkedTransactionMerging_ = false;
+
+    if (batchLevel_ > 0)
+        return;
+
+    if (!deferredOutputs_.empty())
+        FlushDeferredOutputs();
+
+    ReleaseDependencies();
+}
+
+void ReactGraph::ReleaseDependencies()
+{
+    // Releasing the last dependency of a sync point runs its continuations on this thread.
+    // They may start new turns on this graph, so this comes last.
+    if (!heldDependencies_.empty())
+        std::vector<SyncPoint::Dependency> dependencies = std::move(heldDependencies_);
+}
+
+void ReactGraph::FlushDeferredOutputs()
+{
+    OutputClock::time_point now = OutputClock::now();
+    OutputClock::time_point retryTime = (OutputClock::time_point::max)();
+
+    flushedOutputs_.swap(deferredOutputs_);
+
+    // Nodes that are not ready yet are deferred again.
+    for (NodeId nodeId : flushedOutputs_)
+        if (!nodeData_[nodeId].nodePtr->FlushOutput(now, retryTime))
+            deferredOutputs_.push_back(nodeId);
+
+    flushedOutputs_.clear();
+
+    // Once the retry time is reached, an empty transaction starts a new batch, which flushes the deferred outputs.
+    if (!deferredOutputs_.empty() && retryTime != (OutputClock::time_point::max)())
+        transactionQueue_.ScheduleWakeup(retryTime);
+}
+
+UpdateResult ReactGraph::UpdateNode(NodeId nodeId, NodeData& node)
+{
+    REACT_TRACE_NODE_SCOPE(typeid(*node.nodePtr), nodeId, node.level);
+
+#if defined(REACT_ENABLE_NODE_STATS)
+    auto startTime = std::chrono::steady_clock::now();
+
+    UpdateResult res = node.nodePtr->Update(0u);
+
+    uint64_t time = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - startTime).count());
+
+    auto& stats = nodeStats_[nodeId];
+
+    ++stats.updateCount;
+    stats.totalTime += time;
+
+    if (stats.maxTime < time)
+        stats.maxTime = time;
+
+    if (res == UpdateResult::changed)
+    {
+        ++stats.changedCount;
+        stats.eventCount += node.nodePtr->GetEventCount();
+    }
+
+    return res;
+#else
+    return node.nodePtr->Update(0u);
+#endif
 }
 
 void ReactGraph::UpdateLinkNodes()
@@ -153,11 +783,16 @@ void ReactGraph::UpdateLinkNodes()
     if (allowLinkedTransactionMerging_)
         flags |= TransactionFlags::allow_merging;
 
+    // Linked transactions inherit the lane of the transaction that caused them.
+    flags |= linkedTransactionPriority_;
+
     SyncPoint::Dependency dep{ begin(linkDependencies_), end(linkDependencies_) };
 
     for (auto& e : scheduledLinkOutputs_)
     {
-        e.first->EnqueueTransaction(
+        REACT_TRACE_SCOPE(link_enqueue, "EnqueueLinkedTransaction", e.second.size());
+
+        e.first->EnqueueLinkedTransaction(
             [inputs = std::move(e.second)]
             {
                 for (auto& callback : inputs)
@@ -191,7 +826,7 @@ void ReactGraph::RecalculateSuccessorLevels(NodeData& node)
     }
 }
 
-bool ReactGraph::TopoQueue::FetchNext()
+bool TopoQueue::FetchNext()
 {
     // Throw away previous values
     nextData_.clear();
@@ -217,77 +852,455 @@ bool ReactGraph::TopoQueue::FetchNext()
     return !nextData_.empty();
 }
 
+// Queue whose transactions are processed on this thread, if any.
+static const TransactionQueue*& GetProcessingQueue()
+{
+    thread_local const TransactionQueue* queue = nullptr;
+    return queue;
+}
+
+bool TransactionQueue::DoPush(StoredTransaction&& transaction, bool isBounded)
+{
+    size_t lane = GetLane(transaction.flags);
+
+    // Without a capacity, nothing has to be checked, so the lock is skipped.
+    if (!isLocked_.load(std::memory_order_acquire))
+    {
+        unboundedLanes_[lane].push(std::move(transaction));
+        StartWorker();
+        return true;
+    }
+
+    // Rejected or dropped transactions are destroyed outside of the lock, because releasing their
+    // dependencies may run continuations that enqueue new transactions.
+    StoredTransaction discarded;
+    bool isAccepted = true;
+    bool isReplacement = false;
+
+    {// mutex_
+        std::unique_lock<std::mutex> lock(mutex_);
+
+        if (isBounded && capacity_ > 0 && GetSize() >= capacity_)
+        {
+            switch (policy_)
+            {
+            case QueueOverflowPolicy::block:
+                // The worker would wait for itself, so its transactions are accepted beyond the capacity.
+                // This happens if they are enqueued by observers, transactions or continuations of sync points.
+                if (GetProcessingQueue() == this)
+                    break;
+
+                notFullCondition_.wait(lock, [this] { return capacity_ == 0 || GetSize() < capacity_; });
+                break;
+
+            case QueueOverflowPolicy::drop_oldest_mergeable:
+            {
+                // Drop from the lowest priority lane first.
+                for (size_t i = lane_count; i-- > 0 && !isReplacement; )
+                {
+                    auto& transactions = lanes_[i];
+
+                    auto it = std::find_if(transactions.begin(), transactions.end(),
+                        [] (const StoredTransaction& t) { return IsBitmaskSet(t.flags, TransactionFlags::allow_merging); });
+
+                    if (it != transactions.end())
+                    {
+                        discarded = std::move(*it);
+                        transactions.erase(it);
+                        ++droppedCount_;
+                        isReplacement = true;
+
+                        // Set before the dependency is released, so it's visible once the status is done.
+                        if (discarded.droppedFlag)
+                            discarded.droppedFlag->store(true, std::memory_order_release);
+                    }
+                }
+
+                // Nothing to drop, so this has to fail.
+                if (!isReplacement)
+                    isAccepted = false;
+
+                break;
+            }
+
+            case QueueOverflowPolicy::fail:
+                isAccepted = false;
+                break;
+            }
+        }
+
+        if (isAccepted)
+        {
+            // The capacity might have been removed and the locked lanes drained in the meantime.
+            if (isLocked_.load(std::memory_order_relaxed))
+                lanes_[lane].push_back(std::move(transaction));
+            else
+                unboundedLanes_[lane].push(std::move(transaction));
+        }
+    }// ~mutex_
+
+    if (!isAccepted)
+    {
+        ++rejectedCount_;
+        return false;
+    }
+
+    // The dropped transaction was counted already, so the worker's count stays the same.
+    if (isReplacement)
+        return true;
+
+    StartWorker();
+    return true;
+}
+
+void TransactionQueue::StartWorker()
+{
+    if (count_.fetch_add(1, std::memory_order_release) == 0)
+        tbb::task::enqueue(*new(tbb::task::allocate_root()) WorkerTask(*this, graph_.shared_from_this()));
+}
+
+bool TransactionQueue::HasTransactions(size_t lane, bool isLocked) const
+{
+    // There is a single consumer, so a lane that is not empty stays that way until it's popped.
+    return hasHeldTransaction_[lane] || !unboundedLanes_[lane].empty() || (isLocked && !lanes_[lane].empty());
+}
+
+bool TransactionQueue::TryPop(StoredTransaction& transaction, size_t& lane)
+{
+    bool isLocked = isLocked_.load(std::memory_order_acquire);
+    bool shouldNotify = false;
+
+    {// mutex_
+        std::unique_lock<std::mutex> lock(mutex_, std::defer_lock);
+
+        if (isLocked)
+            lock.lock();
+
+        lane = lane_count;
+
+        // Starvation protection. A lane that has been passed over too often goes first.
+        for (size_t i = lane_count; i-- > 0; )
+        {
+            if (skipCounts_[i] >= starvation_limit && HasTransactions(i, isLocked))
+            {
+                lane = i;
+                break;
+            }
+        }
+
+        // Otherwise, take the highest priority lane.
+        if (lane == lane_count)
+        {
+            for (size_t i = 0; i < lane_count; ++i)
+            {
+                if (HasTransactions(i, isLocked))
+                {
+                    lane = i;
+                    break;
+                }
+            }
+        }
+
+        if (lane == lane_count)
+            return false;
+
+        for (size_t i = lane + 1; i < lane_count; ++i)
+            if (HasTransactions(i, isLocked))
+                ++skipCounts_[i];
+
+        skipCounts_[lane] = 0;
+
+        // Within a lane, held transactions are the oldest, followed by those pushed before a capacity was set.
+        if (hasHeldTransaction_[lane])
+        {
+            transaction = std::move(heldTransactions_[lane]);
+            hasHeldTransaction_[lane] = false;
+            return true;
+        }
+
+        if (unboundedLanes_[lane].try_pop(transaction))
+            return true;
+
+        transaction = std::move(lanes_[lane].front());
+        lanes_[lane].pop_front();
+
+        if (capacity_ == 0 && GetSize() == 0)
+            isLocked_.store(false, std::memory_order_release);
+
+        shouldNotify = capacity_ > 0;
+    }// ~mutex_
+
+    if (shouldNotify)
+        notFullCondition_.notify_one();
+
+    return true;
+}
+
+bool TransactionQueue::TryPopMergeable(size_t lane, StoredTransaction& transaction)
+{
+    bool isLocked = isLocked_.load(std::memory_order_acquire);
+    bool shouldNotify = false;
+
+    {// mutex_
+        std::unique_lock<std::mutex> lock(mutex_, std::defer_lock);
+
+        if (isLocked)
+            lock.lock();
+
+        // Don't keep higher priority transactions waiting.
+        for (size_t i = 0; i < lane; ++i)
+            if (HasTransactions(i, isLocked))
+                return false;
+
+        if (hasHeldTransaction_[lane])
+        {
+            if (!IsBitmaskSet(heldTransactions_[lane].flags, TransactionFlags::allow_merging))
+                return false;
+
+            transaction = std::move(heldTransactions_[lane]);
+            hasHeldTransaction_[lane] = false;
+            return true;
+        }
+
+        // There is no way to peek, so a transaction that can't be merged is held for the next turn.
+        if (unboundedLanes_[lane].try_pop(transaction))
+        {
+            if (IsBitmaskSet(transaction.flags, TransactionFlags::allow_merging))
+                return true;
+
+            heldTransactions_[lane] = std::move(transaction);
+            hasHeldTransaction_[lane] = true;
+            return false;
+        }
+
+        if (!isLocked)
+            return false;
+
+        auto& transactions = lanes_[lane];
+
+        if (transactions.empty() || !IsBitmaskSet(transactions.front().flags, TransactionFlags::allow_merging))
+            return false;
+
+        transaction = std::move(transactions.front());
+        transactions.pop_front();
+
+        if (capacity_ == 0 && GetSize() == 0)
+            isLocked_.store(false, std::memory_order_release);
+
+        shouldNotify = capacity_ > 0;
+    }// ~mutex_
+
+    if (shouldNotify)
+        notFullCondition_.notify_one();
+
+    return true;
+}
+
+size_t TransactionQueue::GetSize() const
+{
+    size_t size = 0;
+
+    for (const auto& transactions : lanes_)
+        size += transactions.size();
+
+    return size;
+}
+
+// Process-wide timer thread that pushes empty transactions once the wakeup time of a queue is reached.
+class WakeupTimer
+{
+public:
+    void Schedule(OutputClock::time_point time, TransactionQueue& queue, std::weak_ptr<ReactGraph> graphPtr)
+    {
+        bool isEarliest;
+
+        {// mutex_
+            std::lock_guard<std::mutex> scopedLock(mutex_);
+
+            if (!isStarted_)
+            {
+                std::thread(&WakeupTimer::Run, this).detach();
+                isStarted_ = true;
+            }
+
+            auto it = wakeups_.emplace(time, Wakeup{ &queue, std::move(graphPtr) });
+            isEarliest = it == wakeups_.begin();
+        }// ~mutex_
+
+        if (isEarliest)
+            condition_.notify_one();
+    }
+
+private:
+    struct Wakeup
+    {
+        // The queue is only accessed while the graph that owns it is locked.
+        TransactionQueue*           queuePtr;
+        std::weak_ptr<ReactGraph>   graphPtr;
+    };
+
+    void Run()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+
+        for (;;)
+        {
+            if (wakeups_.empty())
+            {
+                condition_.wait(lock);
+                continue;
+            }
+
+            auto it = wakeups_.begin();
+
+            if (OutputClock::now() < it->first)
+            {
+                condition_.wait_until(lock, it->first);
+                continue;
+            }
+
+            Wakeup wakeup = std::move(it->second);
+            wakeups_.erase(it);
+
+            lock.unlock();
+
+            // This may release the last reference to the graph, so it's done outside of the lock.
+            if (auto graphPtr = wakeup.graphPtr.lock())
+                wakeup.queuePtr->PushUnbounded([] { }, SyncPoint::Dependency{ }, TransactionFlags::allow_merging);
+
+            lock.lock();
+        }
+    }
+
+    std::mutex                                          mutex_;
+    std::condition_variable                             condition_;
+    std::multimap<OutputClock::time_point, Wakeup>      wakeups_;
+    bool                                                isStarted_ = false;
+};
+
+static WakeupTimer& GetWakeupTimer()
+{
+    // Never destroyed, so workers can still schedule wakeups while static objects are destroyed at exit.
+    static WakeupTimer* timer = new WakeupTimer();
+    return *timer;
+}
+
+void TransactionQueue::ScheduleWakeup(OutputClock::time_point time)
+{
+    // A pending wakeup that comes first starts a batch, which schedules this one again if it's still needed.
+    if (wakeupTime_ <= time && OutputClock::now() < wakeupTime_)
+        return;
+
+    wakeupTime_ = time;
+    GetWakeupTimer().Schedule(time, *this, graph_.shared_from_this());
+}
+
+void TransactionQueue::SetCapacity(size_t capacity, QueueOverflowPolicy policy)
+{
+    {// mutex_
+        std::lock_guard<std::mutex> scopedLock(mutex_);
+        capacity_ = capacity;
+        policy_ = policy;
+
+        // Transactions that are waiting in the locked lanes have to be popped before new ones go to the unbounded lanes.
+        isLocked_.store(capacity_ > 0 || GetSize() > 0, std::memory_order_release);
+    }// ~mutex_
+
+    // Blocked producers have to re-check the new capacity.
+    notFullCondition_.notify_all();
+}
+
+TransactionQueueStats TransactionQueue::GetStats() const
+{
+    TransactionQueueStats stats;
+
+    {// mutex_
+        std::lock_guard<std::mutex> scopedLock(mutex_);
+        stats.depth = GetSize();
+    }// ~mutex_
+
+    for (const auto& transactions : unboundedLanes_)
+        stats.depth += transactions.unsafe_size();
+
+    stats.rejectedCount = rejectedCount_.load(std::memory_order_relaxed);
+    stats.droppedCount = droppedCount_.load(std::memory_order_relaxed);
+
+    return stats;
+}
+
 void TransactionQueue::ProcessQueue()
 {
+    // The worker runs on a shared TBB thread, so it's only bound while it processes this queue.
+    NumaThreadScope numaScope( graph_.GetNumaNode() );
+    WorkerThreadScope workerScope;
+
+    const TransactionQueue* previousQueue = GetProcessingQueue();
+    GetProcessingQueue() = this;
+
     for (;;)
     {
         size_t popCount = ProcessNextBatch();
         if (count_.fetch_sub(popCount) == popCount)
-            return;
+            break;
     }
+
+    GetProcessingQueue() = previousQueue;
 }
 
 size_t TransactionQueue::ProcessNextBatch()
 {
     StoredTransaction curTransaction;
     size_t popCount = 0;
+    size_t lane;
 
-    bool canMerge = false;
-    bool syncLinked = false;
+    // Producers push before they increment the count. Popping a transaction that hasn't been counted
+    // yet would let the count drop to zero while this worker is still running, and the next push would
+    // start a second one.
+    size_t popLimit = count_.load(std::memory_order_acquire);
+    if (popLimit > max_batch_size)
+        popLimit = max_batch_size;
 
-    bool skipPop = false;
-    bool isDone = false;
+    REACT_TRACE_SCOPE(batch, "Batch", 0);
 
-    // Outer loop. One transaction per iteration.
-    for (;;)
-    {
-        if (!skipPop)
-        {
-            if (!transactions_.try_pop(curTransaction))
-                return popCount;
+    // All turns of this batch are done before deferred outputs are flushed.
+    graph_.BeginBatch();
 
-            canMerge = IsBitmaskSet(curTransaction.flags, TransactionFlags::allow_merging);
-            syncLinked = IsBitmaskSet(curTransaction.flags, TransactionFlags::sync_linked);
-
-            ++popCount;
-        }
-        else
-        {
-            skipPop = false;
-        }
+    // One turn per iteration.
+    while (popCount < popLimit && TryPop(curTransaction, lane))
+    {
+        ++popCount;
 
         graph_.DoTransaction([&]
         {
+            bool canMerge = IsBitmaskSet(curTransaction.flags, TransactionFlags::allow_merging);
+            bool syncLinked = IsBitmaskSet(curTransaction.flags, TransactionFlags::sync_linked);
+
+            graph_.SetLinkedTransactionPriority(curTransaction.flags & (TransactionFlags::priority_high | TransactionFlags::priority_low));
+
             curTransaction.func();
             graph_.AddSyncPointDependency(std::move(curTransaction.dep), syncLinked);
 
-            if (canMerge)
-            {
-                graph_.AllowLinkedTransactionMerging(true);
-
-                // Pull in additional mergeable transactions.
-                for (;;)
-                {
-                    if (!transactions_.try_pop(curTransaction))
-                        return;
+            if (!canMerge)
+                return;
 
-                    canMerge = IsBitmaskSet(curTransaction.flags, TransactionFlags::allow_merging);
-                    syncLinked = IsBitmaskSet(curTransaction.flags, TransactionFlags::sync_linked);
+            graph_.AllowLinkedTransactionMerging(true);
 
-                    ++popCount;
+            // Pull in additional mergeable transactions from the same lane.
+            while (popCount < popLimit && TryPopMergeable(lane, curTransaction))
+            {
+                syncLinked = IsBitmaskSet(curTransaction.flags, TransactionFlags::sync_linked);
 
-                    if (!canMerge)
-                    {
-                        skipPop = true;
-                        return;
-                    }
+                ++popCount;
 
-                    curTransaction.func();
-                    graph_.AddSyncPointDependency(std::move(curTransaction.dep), syncLinked);
-                }
+                curTransaction.func();
+                graph_.AddSyncPointDependency(std::move(curTransaction.dep), syncLinked);
             }
         });
     }
+
+    graph_.EndBatch();
+
+    return popCount;
 }
 
 /****************************************/ REACT_IMPL_END /***************************************/
\ No newline at end of file
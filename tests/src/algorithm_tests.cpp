@@ -7,11 +7,14 @@
 #include "gtest/gtest.h"
 
 #include "react/algorithm.h"
+#include "react/analysis.h"
 #include "react/observer.h"
 
 #include <algorithm>
 #include <chrono>
+#include <functional>
 #include <queue>
+#include <sstream>
 #include <string>
 #include <thread>
 #include <tuple>
@@ -784,4 +787,368 @@ TEST(AlgorithmTest, FlattenObject1)
     EXPECT_EQ(turns, 6);
     EXPECT_EQ(output1, 500);
     EXPECT_EQ(output2, 600);
-}
\ No newline at end of file
+}
+
+TEST(AlgorithmTest, Checkpoint)
+{
+    auto makeGraph = [] (const Group& g)
+        {
+            auto src = StateVar<int>::Create(g, 1);
+            auto evt = EventSource<int>::Create(g);
+
+            State<int> sum = Iterate<int>(0, [] (const auto& events, int v)
+                {
+                    for (int e : events)
+                        v += e;
+                    return v;
+                }, evt);
+
+            State<std::string> last = Hold(std::string("none"), Transform<std::string>([] (int e)
+                {
+                    return std::to_string(e);
+                }, evt));
+
+            return std::make_tuple(src, evt, sum, last);
+        };
+
+    Group g1;
+    auto graph1 = makeGraph(g1);
+    auto& src1 = std::get<0>(graph1);
+    auto& evt1 = std::get<1>(graph1);
+
+    src1.Set(42);
+    evt1 << 10 << 20;
+
+    auto image = g1.SaveCheckpoint();
+
+    // Restore into a structurally identical graph.
+    Group g2;
+    auto graph2 = makeGraph(g2);
+    auto& src2 = std::get<0>(graph2);
+    auto& evt2 = std::get<1>(graph2);
+    auto& sum2 = std::get<2>(graph2);
+    auto& last2 = std::get<3>(graph2);
+
+    EXPECT_TRUE(g2.LoadCheckpoint(image.data(), image.size()));
+
+    int srcOutput = 0;
+    int sumOutput = 0;
+    std::string lastOutput;
+
+    auto obs1 = Observer::Create([&] (int v) { srcOutput = v; }, src2);
+    auto obs2 = Observer::Create([&] (int v) { sumOutput = v; }, sum2);
+    auto obs3 = Observer::Create([&] (const std::string& v) { lastOutput = v; }, last2);
+
+    EXPECT_EQ(42, srcOutput);
+    EXPECT_EQ(30, sumOutput);
+    EXPECT_EQ("20", lastOutput);
+
+    // Restored graph continues from the checkpointed state.
+    evt2 << 5;
+
+    EXPECT_EQ(35, sumOutput);
+    EXPECT_EQ("5", lastOutput);
+
+    // Mismatching graph and truncated image are rejected.
+    Group g3;
+    auto other = StateVar<int>::Create(g3, 1);
+
+    EXPECT_FALSE(g3.LoadCheckpoint(image.data(), image.size()));
+    EXPECT_FALSE(g2.LoadCheckpoint(image.data(), image.size() - 1));
+
+    // Same structure and value sizes, but a different value type.
+    Group g4;
+    auto intVar = StateVar<int>::Create(g4, 7);
+    auto image4 = g4.SaveCheckpoint();
+
+    Group g5;
+    auto floatVar = StateVar<float>::Create(g5, 1.5f);
+
+    float floatOutput = 0.0f;
+    auto obs4 = Observer::Create([&] (float v) { floatOutput = v; }, floatVar);
+
+    EXPECT_FALSE(g5.LoadCheckpoint(image4.data(), image4.size()));
+
+    floatVar.Set(2.5f);
+    EXPECT_EQ(2.5f, floatOutput);
+
+    // A failed load restores nothing, even if the mismatch is found after the first record.
+    src2.Set(1);
+    evt2 << 100;
+
+    image.push_back(0);
+
+    EXPECT_FALSE(g2.LoadCheckpoint(image.data(), image.size()));
+
+    EXPECT_EQ(1, srcOutput);
+    EXPECT_EQ(135, sumOutput);
+    EXPECT_EQ("100", lastOutput);
+}
+
+TEST(AlgorithmTest, TurnAnalysis)
+{
+    using std::chrono::nanoseconds;
+
+    // Diamond: 0 -> 1, 0 -> 2, 1 -> 3, 2 -> 3
+    std::vector<GraphNodeInfo> nodes(4);
+
+    for (size_t i = 0; i < nodes.size(); ++i)
+        nodes[i].nodeId = i;
+
+    nodes[0].successors = { 1, 2 };
+    nodes[1].successors = { 3 };
+    nodes[2].successors = { 3 };
+
+    nodes[1].level = 1;
+    nodes[2].level = 1;
+    nodes[3].level = 2;
+
+    TurnProfile turn;
+    turn.updates = { { 3, nanoseconds(5) }, { 0, nanoseconds(10) }, { 2, nanoseconds(30) }, { 1, nanoseconds(20) }, { 42, nanoseconds(100) } };
+
+    TurnAnalysis analysis = AnalyzeTurns(nodes, { turn, turn });
+
+    EXPECT_EQ(2u, analysis.turnCount);
+    EXPECT_EQ(8u, analysis.updateCount);
+    EXPECT_EQ(nanoseconds(130), analysis.totalWork);
+    EXPECT_EQ(nanoseconds(90), analysis.criticalPath);
+
+    ASSERT_EQ(3u, analysis.levels.size());
+    EXPECT_EQ(4u, analysis.levels[1].nodeCount);
+    EXPECT_DOUBLE_EQ(2.0, analysis.levels[1].GetAverageWidth());
+    EXPECT_EQ(nanoseconds(100), analysis.levels[1].work);
+    EXPECT_EQ(nanoseconds(60), analysis.levels[1].span);
+
+    EXPECT_DOUBLE_EQ(1.0, analysis.EstimateSpeedup(1));
+    EXPECT_DOUBLE_EQ(130.0 / 90.0, analysis.EstimateSpeedup(2));
+    EXPECT_DOUBLE_EQ(130.0 / 90.0, analysis.GetSpeedupBound(8));
+
+    std::ostringstream report;
+    WriteTurnAnalysisReport(report, analysis);
+
+    EXPECT_NE(std::string::npos, report.str().find("Critical path:"));
+
+    // Recorded levels take precedence over the current levels of the nodes.
+    TurnProfile leveledTurn;
+    leveledTurn.updates = { { 3, nanoseconds(5), 1 } };
+
+    TurnAnalysis leveledAnalysis = AnalyzeTurns(nodes, { leveledTurn });
+
+    ASSERT_EQ(1u, leveledAnalysis.levels.size());
+    EXPECT_EQ(1, leveledAnalysis.levels[0].level);
+}
+
+TEST(AlgorithmTest, TracedTurnAnalysis)
+{
+    Group g;
+
+    auto a = StateVar<int>::Create(g, 0);
+    auto b = State<int>::Create([] (int v) { return v + 1; }, a);
+    auto c = State<int>::Create([] (int v) { return v + 2; }, a);
+    auto d = State<int>::Create([] (int v1, int v2) { return v1 + v2; }, b, c);
+
+    ClearTrace();
+
+    for (int i = 1; i <= 10; ++i)
+        a.Set(i);
+
+    TurnAnalysis analysis = AnalyzeTurns(g.GetNodes(), GetTracedTurns());
+
+    // A saved trace contains the same turns.
+    std::stringstream trace;
+    WriteChromeTrace(trace);
+
+    std::vector<TurnProfile> loadedTurns;
+    ASSERT_TRUE(LoadTracedTurns(trace, loadedTurns));
+
+    TurnAnalysis loadedAnalysis = AnalyzeTurns(g.GetNodes(), loadedTurns);
+
+    if (is_tracing_enabled)
+    {
+        EXPECT_EQ(10u, analysis.turnCount);
+        EXPECT_EQ(40u, analysis.updateCount);
+        EXPECT_LE(analysis.criticalPath, analysis.totalWork);
+
+        ASSERT_EQ(3u, analysis.levels.size());
+        EXPECT_EQ(20u, analysis.levels[1].nodeCount);
+
+        EXPECT_EQ(analysis.turnCount, loadedAnalysis.turnCount);
+        EXPECT_EQ(analysis.updateCount, loadedAnalysis.updateCount);
+        EXPECT_EQ(analysis.totalWork, loadedAnalysis.totalWork);
+        EXPECT_EQ(analysis.criticalPath, loadedAnalysis.criticalPath);
+    }
+    else
+    {
+        EXPECT_EQ(0u, analysis.turnCount);
+        EXPECT_EQ(0u, loadedAnalysis.turnCount);
+    }
+}
+
+TEST(AlgorithmTest, LoadTracedTurns)
+{
+    using std::chrono::nanoseconds;
+
+    std::istringstream trace(
+        "{\"traceEvents\":["
+        "\n{\"name\":\"Turn\",\"cat\":\"turn\",\"ph\":\"X\",\"ts\":1.000,\"dur\":10.000,\"pid\":1,\"tid\":0,\"args\":{\"id\":1}},"
+        "\n{\"name\":\"Node \\\"a\\\"\",\"cat\":\"node\",\"ph\":\"X\",\"ts\":2.000,\"dur\":0.250,\"pid\":1,\"tid\":0,\"args\":{\"id\":3,\"level\":2}},"
+        "\n{\"name\":\"Other thread\",\"cat\":\"node\",\"ph\":\"X\",\"ts\":3.000,\"dur\":1.000,\"pid\":1,\"tid\":1,\"args\":{\"id\":4,\"level\":0}},"
+        "\n{\"name\":\"Batch\",\"cat\":\"batch\",\"ph\":\"X\",\"ts\":0.500,\"dur\":20.000,\"pid\":1,\"tid\":0,\"args\":{\"id\":0}},"
+        "\n{\"name\":\"Marker\",\"ph\":\"i\",\"ts\":5,\"s\":\"g\",\"args\":{\"list\":[1,true,null]}},"
+        "\n{\"name\":\"Turn\",\"cat\":\"turn\",\"ph\":\"X\",\"ts\":12.000,\"dur\":5.000,\"pid\":1,\"tid\":0,\"args\":{\"id\":1}},"
+        "\n{\"name\":\"Node\",\"cat\":\"node\",\"ph\":\"X\",\"ts\":13.500,\"dur\":0.001,\"pid\":1,\"tid\":0,\"args\":{\"id\":5,\"level\":1}}"
+        "\n],\"displayTimeUnit\":\"ns\"}\n");
+
+    std::vector<TurnProfile> turns;
+    ASSERT_TRUE(LoadTracedTurns(trace, turns));
+
+    ASSERT_EQ(2u, turns.size());
+
+    ASSERT_EQ(1u, turns[0].updates.size());
+    EXPECT_EQ(3u, turns[0].updates[0].nodeId);
+    EXPECT_EQ(nanoseconds(250), turns[0].updates[0].time);
+    EXPECT_EQ(2, turns[0].updates[0].level);
+
+    ASSERT_EQ(1u, turns[1].updates.size());
+    EXPECT_EQ(5u, turns[1].updates[0].nodeId);
+    EXPECT_EQ(nanoseconds(1), turns[1].updates[0].time);
+
+    std::istringstream invalid("{\"nodes\":[]}");
+    EXPECT_FALSE(LoadTracedTurns(invalid, turns));
+}
+
+TEST(AlgorithmTest, PartitionGraph)
+{
+    // Two independent chains: 0 -> 1 -> 2 and 3 -> 4 -> 5
+    std::vector<GraphNodeInfo> chains(6);
+
+    for (size_t i = 0; i < chains.size(); ++i)
+        chains[i].nodeId = i;
+
+    chains[0].successors = { 1 };
+    chains[1].successors = { 2 };
+    chains[3].successors = { 4 };
+    chains[4].successors = { 5 };
+
+    GraphPartition partition = PartitionGraph(chains, 2);
+
+    ASSERT_EQ(2u, partition.parts.size());
+    EXPECT_EQ(0u, partition.cutEdgeCount);
+    EXPECT_TRUE(partition.links.empty());
+    EXPECT_DOUBLE_EQ(1.0, partition.GetImbalance());
+    EXPECT_EQ(partition.GetPart(0), partition.GetPart(2));
+    EXPECT_NE(partition.GetPart(0), partition.GetPart(5));
+    EXPECT_EQ(-1, partition.GetPart(42));
+
+    // Fan-out: 0 -> 1..8, i -> i + 8
+    std::vector<GraphNodeInfo> fanout(17);
+
+    for (size_t i = 0; i < fanout.size(); ++i)
+        fanout[i].nodeId = i;
+
+    for (size_t i = 1; i <= 8; ++i)
+    {
+        fanout[0].successors.push_back(i);
+        fanout[i].successors.push_back(i + 8);
+    }
+
+    partition = PartitionGraph(fanout, 2);
+
+    ASSERT_EQ(2u, partition.parts.size());
+    EXPECT_LE(partition.GetImbalance(), 1.1);
+    EXPECT_EQ(4u, partition.cutEdgeCount);
+
+    // Chains stay together and all links go the same way.
+    for (size_t i = 1; i <= 8; ++i)
+        EXPECT_EQ(partition.GetPart(i), partition.GetPart(i + 8));
+
+    ASSERT_EQ(1u, partition.links.size());
+    EXPECT_EQ(0u, partition.links[0].sourceNodeId);
+    EXPECT_EQ(partition.GetPart(0), partition.links[0].sourcePart);
+
+    // Recorded costs are balanced instead of node counts.
+    for (size_t i = 1; i <= 8; ++i)
+        fanout[i + 8].stats.updateCount = i <= 2 ? 30 : 1;
+
+    partition = PartitionGraph(fanout, 2, PartitionOptions{ 1.5 });
+
+    ASSERT_EQ(2u, partition.parts.size());
+    EXPECT_LE(partition.GetImbalance(), 1.5);
+    EXPECT_NE(partition.GetPart(9), partition.GetPart(10));
+
+    std::ostringstream report;
+    WritePartitionReport(report, partition);
+
+    EXPECT_NE(std::string::npos, report.str().find("Cut edges:"));
+}
+
+TEST(AlgorithmTest, PartitionedRebuild)
+{
+    struct Handles
+    {
+        StateVar<int>               in;
+        std::vector<State<int>>     states;
+        std::vector<Observer>       observers;
+    };
+
+    int results[4] = { };
+
+    // Creates each named node in the group returned by groupOf.
+    auto build = [&] (Handles& h, const std::function<Group(const std::string&)>& groupOf)
+        {
+            h.in = StateVar<int>::Create(groupOf("in"), 0);
+            h.in.SetDebugName("in");
+
+            for (int i = 0; i < 4; ++i)
+            {
+                std::string a = "a" + std::to_string(i);
+                std::string b = "b" + std::to_string(i);
+
+                auto sa = State<int>::Create(groupOf(a), [i] (int v) { return v + i; }, h.in);
+                sa.SetDebugName(a);
+
+                auto sb = State<int>::Create(groupOf(b), [] (int v) { return v * 2; }, sa);
+                sb.SetDebugName(b);
+
+                h.observers.push_back(Observer::Create([&results, i] (int v) { results[i] = v; }, sb));
+                h.states.push_back(sa);
+                h.states.push_back(sb);
+            }
+        };
+
+    Group g;
+    Handles original;
+
+    build(original, [&] (const std::string&) { return g; });
+
+    for (int i = 1; i <= 10; ++i)
+        original.in.Set(i);
+
+    GraphPartition partition = PartitionGraph(g.GetNodes(), 2);
+
+    ASSERT_EQ(2u, partition.parts.size());
+    ASSERT_NE(-1, partition.FindPart("in"));
+
+    if (!is_node_stats_enabled)
+    {
+        EXPECT_EQ(2u, partition.cutEdgeCount);
+        EXPECT_LE(partition.GetImbalance(), 1.1);
+    }
+
+    std::vector<Group> groups(partition.parts.size());
+    Handles rebuilt;
+
+    build(rebuilt, [&] (const std::string& name) { return groups[partition.FindPart(name)]; });
+
+    for (int i = 0; i < 4; ++i)
+        EXPECT_EQ(2 * i, results[i]);
+
+    SyncPoint sp;
+
+    groups[partition.FindPart("in")].EnqueueTransaction([&] { rebuilt.in.Set(10); }, sp, TransactionFlags::sync_linked);
+
+    ASSERT_TRUE(sp.WaitFor(std::chrono::seconds(3)));
+
+    for (int i = 0; i < 4; ++i)
+        EXPECT_EQ(2 * (10 + i), results[i]);
+}
@@ -0,0 +1,193 @@
+//          Copyright Sebastian Jeckel 2017.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include "gtest/gtest.h"
+
+#include "react/common/allocation.h"
+#include "react/state.h"
+#include "react/event.h"
+#include "react/observer.h"
+
+#include "test_helpers.h"
+
+#include <thread>
+#include <vector>
+
+// Installs the counting operator new/delete for the whole test executable.
+REACT_DEFINE_ALLOCATION_HOOKS
+
+using namespace react;
+
+// Keeps the compiler from removing allocations that are freed right away.
+static std::vector<int>* volatile allocationSink = nullptr;
+
+TEST(AllocationTest, Tracker)
+{
+    AllocationTracker tracker;
+
+    auto p = std::make_unique<std::vector<int>>(100);
+    allocationSink = p.get();
+    p.reset();
+
+    AllocationStats stats = tracker.GetStats();
+
+    EXPECT_EQ(2u, stats.allocationCount);
+    EXPECT_EQ(2u, stats.deallocationCount);
+    EXPECT_GE(stats.allocatedBytes, 100 * sizeof(int) + sizeof(std::vector<int>));
+
+    tracker.Reset();
+
+    stats = tracker.GetStats();
+
+    EXPECT_EQ(0u, stats.allocationCount);
+    EXPECT_EQ(0u, stats.deallocationCount);
+    EXPECT_EQ(0u, stats.allocatedBytes);
+}
+
+TEST(AllocationTest, TrackerThread)
+{
+    Signal start;
+    Signal done;
+
+    std::thread other([&]
+        {
+            start.Wait();
+
+            std::vector<int> v(100);
+            allocationSink = &v;
+
+            done.Set();
+        });
+
+    AllocationTracker tracker;
+
+    start.Set();
+    done.Wait();
+
+    // Allocations of other threads are not counted.
+    AllocationStats stats = tracker.GetStats();
+
+    EXPECT_EQ(0u, stats.allocationCount);
+    EXPECT_EQ(0u, stats.deallocationCount);
+
+    other.join();
+}
+
+TEST(AllocationTest, SteadyStateChain)
+{
+    Group g;
+
+    auto a = StateVar<int>::Create(g, 0);
+    auto b = StateVar<int>::Create(g, 0);
+
+    auto sum = State<int>::Create([] (int x, int y) { return x + y; }, a, b);
+    auto twice = State<int>::Create([] (int x) { return x * 2; }, sum);
+
+    int result = 0;
+
+    auto obs = Observer::Create([&] (int x) { result = x; }, twice);
+
+    // Warm-up, so buffers of the graph reach their final size.
+    for (int i = 1; i <= 10; ++i)
+    {
+        a.Set(i);
+        g.DoTransaction([&] { a.Set(i + 1); b.Set(i); });
+    }
+
+    AllocationTracker tracker;
+
+    for (int i = 0; i < 1000; ++i)
+    {
+        a.Set(i);
+        g.DoTransaction([&] { a.Set(i + 1); b.Set(i); });
+    }
+
+    AllocationStats stats = tracker.GetStats();
+
+    EXPECT_EQ(2 * (1000 + 999), result);
+    EXPECT_EQ(0u, stats.allocationCount);
+    EXPECT_EQ(0u, stats.deallocationCount);
+}
+
+TEST(AllocationTest, SteadyStateEvents)
+{
+    Group g;
+
+    auto src = EventSource<int>::Create(g);
+
+    auto transformed = Transform<int>([] (int x) { return x * 2; }, src);
+
+    int sum = 0;
+
+    auto obs = Observer::Create([&] (const auto& events)
+        {
+            for (int e : events)
+                sum += e;
+        }, transformed);
+
+    for (int i = 0; i < 10; ++i)
+    {
+        src.Emit(i);
+        g.DoTransaction([&] { src.Emit(i); src.Emit(i); });
+    }
+
+    sum = 0;
+
+    AllocationTracker tracker;
+
+    for (int i = 0; i < 1000; ++i)
+    {
+        src.Emit(1);
+        g.DoTransaction([&] { src.Emit(1); src.Emit(1); });
+    }
+
+    AllocationStats stats = tracker.GetStats();
+
+    EXPECT_EQ(6000, sum);
+    EXPECT_EQ(0u, stats.allocationCount);
+    EXPECT_EQ(0u, stats.deallocationCount);
+}
+
+TEST(AllocationTest, GroupStats)
+{
+    Group g;
+
+    auto src = EventSource<int>::Create(g);
+
+    std::vector<int> results;
+
+    auto obs = Observer::Create([&] (const auto& events)
+        {
+            for (int e : events)
+                results.push_back(e);
+        }, src);
+
+    g.ResetAllocationStats();
+
+    for (int i = 0; i < 100; ++i)
+        src.Emit(i);
+
+    // Allocations outside of the group are not counted.
+    std::vector<int> unrelated(1000);
+
+    AllocationStats stats = g.GetAllocationStats();
+
+    if (!is_allocation_tracking_enabled)
+    {
+        EXPECT_EQ(0u, stats.allocationCount);
+        return;
+    }
+
+    // The observer grows its result vector.
+    EXPECT_GT(stats.allocationCount, 0u);
+    EXPECT_LT(stats.allocatedBytes, unrelated.size() * sizeof(int));
+
+    g.ResetAllocationStats();
+
+    stats = g.GetAllocationStats();
+
+    EXPECT_EQ(0u, stats.allocationCount);
+    EXPECT_EQ(0u, stats.allocatedBytes);
+}
@@ -6,17 +6,25 @@
 
 #include "gtest/gtest.h"
 
+#include "react/common/ptrcache.h"
 #include "react/common/syncpoint.h"
+#include "react/common/tracing.h"
 
+#include <atomic>
 #include <chrono>
 #include <cstdio>
 #include <thread>
+#include <type_traits>
+#include <vector>
 
 using namespace react;
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 TEST(SyncPointTest, DependencyCreation)
 {
+    static_assert(std::is_nothrow_move_constructible<SyncPoint::Dependency>::value, "Dependency move must be noexcept.");
+    static_assert(std::is_nothrow_move_assignable<SyncPoint::Dependency>::value, "Dependency move must be noexcept.");
+
     SyncPoint sp;
 
     {
@@ -45,6 +53,69 @@ TEST(SyncPointTest, DependencyCreation)
     EXPECT_EQ(true, done);
 }
 
+TEST(SyncPointTest, DependencyMerging)
+{
+    std::vector<SyncPoint> syncPoints(6);
+
+    std::vector<SyncPoint::Dependency> deps;
+
+    // Duplicates and more targets than fit into the inline storage.
+    for (const auto& sp : syncPoints)
+    {
+        deps.emplace_back(sp);
+        deps.emplace_back(sp);
+    }
+
+    // Empty dependencies are ignored.
+    deps.emplace_back();
+
+    SyncPoint::Dependency merged( begin(deps), end(deps) );
+    deps.clear();
+
+    // Nested merge.
+    std::vector<SyncPoint::Dependency> nested = { merged, SyncPoint::Dependency(syncPoints[0]) };
+    SyncPoint::Dependency merged2( begin(nested), end(nested) );
+    nested.clear();
+
+    for (auto& sp : syncPoints)
+        EXPECT_FALSE(sp.WaitFor(std::chrono::milliseconds(1)));
+
+    merged.Release();
+
+    EXPECT_TRUE(merged.IsReleased());
+
+    for (auto& sp : syncPoints)
+        EXPECT_FALSE(sp.WaitFor(std::chrono::milliseconds(1)));
+
+    SyncPoint::Dependency moved = std::move(merged2);
+
+    EXPECT_TRUE(merged2.IsReleased());
+    EXPECT_FALSE(moved.IsReleased());
+
+    moved.Release();
+
+    for (auto& sp : syncPoints)
+        EXPECT_TRUE(sp.WaitFor(std::chrono::milliseconds(1)));
+}
+
+TEST(SyncPointTest, TryThen)
+{
+    SyncPoint sp;
+    SyncPoint::Dependency dep(sp);
+
+    int count = 0;
+
+    EXPECT_TRUE(sp.TryThen([&] { ++count; }));
+    EXPECT_EQ(0, count);
+
+    dep.Release();
+    EXPECT_EQ(1, count);
+
+    // Not called if the sync point is done already.
+    EXPECT_FALSE(sp.TryThen([&] { ++count; }));
+    EXPECT_EQ(1, count);
+}
+
 TEST(SyncPointTest, SingleWait)
 {
     SyncPoint sp;
@@ -158,4 +229,187 @@ TEST(SyncPointTest, MultiWaitFor)
     t1.join();
     t2.join();
     t3.join();
-}
\ No newline at end of file
+}
+
+TEST(SyncPointTest, ConcurrentRelease)
+{
+    // Many threads split and release dependencies while the main thread waits.
+    for (int round = 0; round < 100; ++round)
+    {
+        SyncPoint sp;
+
+        std::atomic<int> doneCount{ 0 };
+        std::vector<std::thread> threads;
+
+        {
+            SyncPoint::Dependency dep(sp);
+
+            for (int t = 0; t < 4; ++t)
+            {
+                threads.emplace_back([storedDep = dep, &doneCount] () mutable
+                    {
+                        for (int i = 0; i < 100; ++i)
+                            SyncPoint::Dependency copy(storedDep);
+
+                        ++doneCount;
+                        storedDep.Release();
+                    });
+            }
+        }
+
+        sp.Wait();
+
+        EXPECT_EQ(4, doneCount);
+
+        for (auto& t : threads)
+            t.join();
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+TEST(WeakPtrCacheTest, LookupOrCreate)
+{
+    WeakPtrCache<int, int> cache;
+
+    int createCount = 0;
+
+    auto create = [&] (int v)
+        {
+            return [&createCount, v]
+                {
+                    ++createCount;
+                    return std::make_shared<int>(v);
+                };
+        };
+
+    auto p1 = cache.LookupOrCreate(1, create(10));
+    auto p2 = cache.LookupOrCreate(1, create(20));
+    auto p3 = cache.LookupOrCreate(2, create(30));
+
+    EXPECT_EQ(2, createCount);
+    EXPECT_EQ(p1, p2);
+    EXPECT_EQ(10, *p2);
+    EXPECT_EQ(30, *p3);
+
+    // Released objects are re-created.
+    p1.reset();
+    p2.reset();
+
+    auto p4 = cache.LookupOrCreate(1, create(40));
+
+    EXPECT_EQ(3, createCount);
+    EXPECT_EQ(40, *p4);
+
+    // Erase keeps entries that are still alive.
+    cache.Erase(1);
+
+    auto p5 = cache.LookupOrCreate(1, create(50));
+
+    EXPECT_EQ(3, createCount);
+    EXPECT_EQ(p4, p5);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+TEST(WeakPtrCacheTest, Concurrent)
+{
+    WeakPtrCache<int, int> cache;
+
+    const int threadCount = 8;
+    const int keyCount = 64;
+
+    std::atomic<int> createCount{ 0 };
+
+    std::vector<std::vector<std::shared_ptr<int>>> results(threadCount);
+    std::vector<std::thread> threads;
+
+    for (int t = 0; t < threadCount; ++t)
+    {
+        threads.emplace_back([&, t]
+            {
+                for (int i = 0; i < 1000; ++i)
+                {
+                    int key = (i + t) % keyCount;
+
+                    auto p = cache.LookupOrCreate(key, [&]
+                        {
+                            ++createCount;
+                            return std::make_shared<int>(key);
+                        });
+
+                    EXPECT_EQ(key, *p);
+
+                    if (results[t].size() < keyCount)
+                        results[t].push_back(std::move(p));
+                }
+            });
+    }
+
+    for (auto& t : threads)
+        t.join();
+
+    // Every thread holds on to all keys, so each object was only created once.
+    EXPECT_EQ(keyCount, createCount);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+TEST(TraceBufferTest, ConcurrentRead)
+{
+    using REACT_IMPL::TraceBuffer;
+    using REACT_IMPL::TraceEvent;
+    using REACT_IMPL::TraceEventKind;
+
+    TraceBuffer buffer{ 0 };
+
+    const size_t capacity = TraceBuffer::capacity;
+    const uint64_t eventCount = 4 * capacity;
+
+    std::atomic<bool> isDone{ false };
+
+    // All fields of an event are derived from its id, so torn events would be detected.
+    std::thread writer([&]
+        {
+            for (uint64_t i = 0; i < eventCount; ++i)
+                buffer.Record(TraceEvent{ "", nullptr, i, i + 1, i, static_cast<int>(i % 100), TraceEventKind::node_update });
+
+            isDone = true;
+        });
+
+    size_t readCount = 0;
+    bool isConsistent = true;
+
+    while (!isDone)
+    {
+        uint64_t lastId = 0;
+        bool isFirst = true;
+
+        buffer.ForEach([&] (const TraceEvent& e)
+            {
+                if (e.beginTime != e.id || e.endTime != e.id + 1 || e.level != static_cast<int>(e.id % 100))
+                    isConsistent = false;
+
+                if (!isFirst && e.id <= lastId)
+                    isConsistent = false;
+
+                lastId = e.id;
+                isFirst = false;
+                ++readCount;
+            });
+    }
+
+    writer.join();
+
+    EXPECT_TRUE(isConsistent);
+
+    // Once the writer is done, the last capacity events can be read.
+    size_t finalCount = 0;
+    buffer.ForEach([&] (const TraceEvent& e) { ++finalCount; });
+
+    EXPECT_EQ(capacity, finalCount);
+
+    buffer.Clear();
+
+    finalCount = 0;
+    buffer.ForEach([&] (const TraceEvent& e) { ++finalCount; });
+
+    EXPECT_EQ(0u, finalCount);
+}
@@ -220,6 +220,52 @@ TEST(EventTest, Links)
     EXPECT_EQ(3, turns);
 }
 
+TEST(EventTest, SharedLinks)
+{
+    // One source feeding multiple groups. All targets should see the same batch.
+    Group g1;
+    Group g2;
+    Group g3;
+
+    auto src = EventSource<int>::Create(g1);
+
+    auto lnk2 = EventLink<int>::Create(g2, src);
+    auto lnk3 = EventLink<int>::Create(g3, src);
+
+    int output2 = 0;
+    int output3 = 0;
+
+    const void* batch2 = nullptr;
+    const void* batch3 = nullptr;
+
+    auto obs2 = Observer::Create([&] (const auto& events)
+        {
+            batch2 = &events;
+            for (int e : events)
+                output2 += e;
+        }, lnk2);
+
+    auto obs3 = Observer::Create([&] (const auto& events)
+        {
+            batch3 = &events;
+            for (int e : events)
+                output3 += e;
+        }, lnk3);
+
+    g1.DoTransaction([&]
+        {
+            src << 1 << 2 << 3;
+        });
+
+    std::this_thread::sleep_for(std::chrono::seconds(1));
+
+    EXPECT_EQ(6, output2);
+    EXPECT_EQ(6, output3);
+
+    EXPECT_NE(nullptr, batch2);
+    EXPECT_EQ(batch2, batch3);
+}
+
 TEST(EventTest, EventSources)
 {
     Group g;
@@ -4,9 +4,304 @@
 //    (See accompanying file LICENSE_1_0.txt or copy at
 //          http://www.boost.org/LICENSE_1_0.txt)
 
+#include "gtest/gtest.h"
+
+#include "react/event.h"
+#include "react/observer.h"
+#include "react/state.h"
+
+#include "test_helpers.h"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace react;
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+TEST(ObserverTest, AsyncState)
+{
+    Group g;
+
+    auto a = StateVar<int>::Create(g, 0);
+    auto b = StateVar<int>::Create(g, 0);
+
+    std::mutex mtx;
+    std::vector<int> results;
+    std::thread::id callerId;
+
+    Signal done;
+
+    // Destroyed before the variables it uses, which waits for a call in progress.
+    auto obs = Observer::Create(async_observer, [&] (int x, int y)
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            results.push_back(x + y);
+            callerId = std::this_thread::get_id();
+
+            if (results.size() == 1001)
+                done.Set();
+        }, a, b);
+
+    // Small queue to exercise the blocking policy.
+    auto obs2 = Observer::Create(g, AsyncObserverOptions{ 2, ObserverOverflowPolicy::block }, [] (int) { }, a);
+
+    for (int i = 1; i <= 1000; ++i)
+        a.Set(i);
+
+    done.Wait();
+
+    std::lock_guard<std::mutex> lock(mtx);
+
+    // Initial value, then every turn in order.
+    for (int i = 0; i <= 1000; ++i)
+        EXPECT_EQ(i, results[i]);
+
+    EXPECT_NE(std::this_thread::get_id(), callerId);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+TEST(ObserverTest, AsyncEvents)
+{
+    Group g;
+
+    auto src = EventSource<int>::Create(g);
+    auto sync = StateVar<int>::Create(g, 10);
+
+    Signal start;
+    Signal dropDone;
+    Signal syncedDone;
+
+    std::mutex mtx;
+    std::vector<int> dropResults;
+    std::vector<int> syncedResults;
+
+    // A slow observer with a tiny queue drops what doesn't fit.
+    // The first batch occupies the queue until the call returns, so all others are dropped.
+    auto obs1 = Observer::Create(AsyncObserverOptions{ 1, ObserverOverflowPolicy::drop_newest }, [&] (const auto& events)
+        {
+            start.Wait();
+
+            std::lock_guard<std::mutex> lock(mtx);
+            for (int e : events)
+                dropResults.push_back(e);
+
+            dropDone.Set();
+        }, src);
+
+    auto obs2 = Observer::Create(async_observer, [&] (const auto& events, int s)
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            for (int e : events)
+                syncedResults.push_back(e + s);
+
+            if (syncedResults.size() == 10)
+                syncedDone.Set();
+        }, src, sync);
+
+    for (int i = 0; i < 10; ++i)
+        src.Emit(i);
+
+    start.Set();
+
+    syncedDone.Wait();
+    dropDone.Wait();
+
+    std::lock_guard<std::mutex> lock(mtx);
+
+    for (int i = 0; i < 10; ++i)
+        EXPECT_EQ(i + 10, syncedResults[i]);
+
+    ASSERT_EQ(1u, dropResults.size());
+    EXPECT_EQ(0, dropResults[0]);
+}
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
-namespace {
+TEST(ObserverTest, AsyncBlockOnWorker)
+{
+    Group g;
+
+    auto a = StateVar<int>::Create(g, 0);
+
+    Signal start;
+    Signal done;
+
+    std::mutex mtx;
+    std::vector<int> results;
+
+    auto obs = Observer::Create(g, AsyncObserverOptions{ 1, ObserverOverflowPolicy::block }, [&] (int v)
+        {
+            start.Wait();
+
+            std::lock_guard<std::mutex> lock(mtx);
+            results.push_back(v);
+
+            if (v == 100)
+                done.Set();
+        }, a);
+
+    // The observer is stuck, but the worker doesn't wait for it.
+    for (int i = 1; i <= 100; ++i)
+        g.EnqueueTransaction([&, i] { a.Set(i); });
+
+    g.EnqueueTransaction(with_status, [] { }).Wait();
+
+    start.Set();
+    done.Wait();
+
+    std::lock_guard<std::mutex> lock(mtx);
+
+    ASSERT_EQ(101u, results.size());
+
+    for (int i = 0; i <= 100; ++i)
+        EXPECT_EQ(i, results[i]);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+TEST(ObserverTest, AsyncDestruction)
+{
+    Group g;
+
+    auto a = StateVar<int>::Create(g, 0);
+
+    Signal entered;
+    Signal release;
+
+    std::atomic<int> callCount{ 0 };
+    std::atomic<bool> isDestroyed{ false };
+
+    auto obs = std::make_unique<Observer>(Observer::Create(async_observer, [&] (int v)
+        {
+            if (v == 1)
+            {
+                entered.Set();
+                release.Wait();
+            }
+
+            ++callCount;
+        }, a));
+
+    a.Set(1);
+    a.Set(2);
+
+    entered.Wait();
+
+    std::thread destroyer([&]
+        {
+            obs.reset();
+            isDestroyed = true;
+        });
+
+    // Destruction waits for the call in progress.
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_FALSE(isDestroyed);
+
+    release.Set();
+    destroyer.join();
+
+    // The value that was still queued is discarded.
+    EXPECT_EQ(2, callCount);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+TEST(ObserverTest, CoalescedBatch)
+{
+    Group g;
+
+    auto a = StateVar<int>::Create(g, 0);
+
+    std::atomic<int> callCount{ 0 };
+    std::atomic<int> lastValue{ -1 };
+
+    auto obs = Observer::Create(coalesced_observer, [&] (int v)
+        {
+            ++callCount;
+            lastValue = v;
+        }, a);
+
+    EXPECT_EQ(1, callCount);
+    EXPECT_EQ(0, lastValue);
+
+    // Outside of a batch, each turn is flushed immediately.
+    a.Set(1);
+
+    EXPECT_EQ(2, callCount);
+    EXPECT_EQ(1, lastValue);
+
+    // Hold the worker, so the following transactions are processed in a single batch.
+    QueueBlocker blocker(g);
+
+    SyncPoint sp;
+
+    for (int i = 2; i <= 100; ++i)
+        g.EnqueueTransaction([&, i] { a.Set(i); }, sp);
+
+    blocker.Release();
+
+    // Dependencies are released after the deferred outputs of their batch have been flushed.
+    sp.Wait();
+
+    EXPECT_EQ(3, callCount);
+    EXPECT_EQ(100, lastValue);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+TEST(ObserverTest, CoalescedInterval)
+{
+    Group g;
+
+    auto a = StateVar<int>::Create(g, 0);
+
+    std::atomic<int> callCount{ 0 };
+    Signal done;
+
+    auto obs = Observer::Create(CoalescedObserverOptions{ std::chrono::milliseconds(50) }, [&] (int v)
+        {
+            ++callCount;
+
+            if (v == 100)
+                done.Set();
+        }, a);
+
+    for (int i = 1; i <= 100; ++i)
+        g.EnqueueTransaction([&, i] { a.Set(i); });
+
+    // The last value is delivered once the interval has passed, even without further changes.
+    done.Wait();
+
+    EXPECT_LT(callCount, 10);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+TEST(ObserverTest, CoalescedIntervalGroups)
+{
+    const int group_count = 4;
+
+    std::vector<Group> groups(group_count);
+    std::vector<StateVar<int>> inputs;
+    std::vector<Observer> observers;
+
+    Signal done[group_count];
+
+    // Longer intervals are scheduled first, so the shared timer has to wake up earlier for later ones.
+    for (int i = 0; i < group_count; ++i)
+    {
+        inputs.push_back(StateVar<int>::Create(groups[i], 0));
+
+        observers.push_back(Observer::Create(CoalescedObserverOptions{ std::chrono::milliseconds(80 - 20 * i) }, [&, i] (int v)
+            {
+                if (v == 100)
+                    done[i].Set();
+            }, inputs[i]));
+    }
 
+    for (int v = 1; v <= 100; ++v)
+        for (int i = 0; i < group_count; ++i)
+            groups[i].EnqueueTransaction([&, i, v] { inputs[i].Set(v); });
 
-} // ~namespace
\ No newline at end of file
+    for (auto& signal : done)
+        signal.Wait();
+}
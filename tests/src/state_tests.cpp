@@ -7,10 +7,18 @@
 #include "gtest/gtest.h"
 
 #include "react/state.h"
+#include "react/event.h"
 #include "react/observer.h"
 
+#include "test_helpers.h"
+
+#include <algorithm>
+#include <atomic>
 #include <thread>
 #include <chrono>
+#include <sstream>
+#include <string>
+#include <vector>
 
 using namespace react;
 
@@ -202,6 +210,41 @@ TEST(StateTest, Links)
     std::this_thread::sleep_for(std::chrono::seconds(1));
 }
 
+TEST(StateTest, LinkCoalescing)
+{
+    Group g1;
+    Group g2;
+
+    auto src = StateVar<int>::Create(g1, 0);
+    auto lnk = StateLink<int>::Create(g2, src);
+
+    int output = 0;
+    int turns = 0;
+
+    auto obs = Observer::Create([&] (const auto& v)
+        {
+            ++turns;
+            output = v;
+        }, lnk);
+
+    EXPECT_EQ(1, turns);
+
+    // Keep the target group busy, while the source produces many values.
+    QueueBlocker blocker(g2);
+
+    for (int i = 1; i <= 100; ++i)
+        src.Set(i);
+
+    blocker.Release();
+
+    // The transfer was enqueued before this, so it's done once this is.
+    g2.EnqueueTransaction(with_status, [] { }).Wait();
+
+    // Only the latest value is applied.
+    EXPECT_EQ(100, output);
+    EXPECT_EQ(2, turns);
+}
+
 namespace
 {
 
@@ -424,3 +467,314 @@ TEST(StateTest, Modify3)
 
     ASSERT_EQ(turns, 2);
 }
+
+TEST(StateTest, NodeStats)
+{
+    Group g;
+
+    auto a = StateVar<int>::Create(g, 0);
+
+    // Only changes when a passes 100, so most updates are wasted.
+    auto b = State<int>::Create([] (int v) { return v / 100; }, a);
+    auto c = State<int>::Create([] (int v) { return v * 2; }, a);
+
+    auto src = EventSource<int>::Create(g);
+
+    int sum = 0;
+    auto obs = Observer::Create([&] (int v) { sum += v; }, b);
+
+    g.ResetNodeStats();
+
+    for (int i = 1; i <= 50; ++i)
+        a.Set(i);
+
+    src.Emit(1);
+    src.Emit(2);
+
+    if (!is_node_stats_enabled)
+    {
+        EXPECT_TRUE(g.GetNodeStats().empty());
+        return;
+    }
+
+    auto findStats = [] (const std::vector<NodeStats>& stats, size_t nodeId)
+        {
+            return std::find_if(stats.begin(), stats.end(), [=] (const NodeStats& s) { return s.nodeId == nodeId; });
+        };
+
+    auto stats = g.GetNodeStats();
+    EXPECT_EQ(5u, stats.size());
+
+    auto bStats = findStats(stats, GetInternals(b).GetNodeId());
+    ASSERT_NE(stats.end(), bStats);
+    EXPECT_EQ(50u, bStats->updateCount);
+    EXPECT_EQ(0u, bStats->changedCount);
+
+    auto cStats = findStats(stats, GetInternals(c).GetNodeId());
+    ASSERT_NE(stats.end(), cStats);
+    EXPECT_EQ(50u, cStats->changedCount);
+    EXPECT_LE(cStats->maxUpdateTime, cStats->totalUpdateTime);
+
+    auto srcStats = findStats(stats, GetInternals(src).GetNodeId());
+    ASSERT_NE(stats.end(), srcStats);
+    EXPECT_EQ(2u, srcStats->eventCount);
+
+    auto hot = g.GetHotNodes(2);
+    EXPECT_EQ(2u, hot.size());
+    EXPECT_GE(hot[0].totalUpdateTime, hot[1].totalUpdateTime);
+
+    auto wasted = g.GetWastedNodes(10);
+    ASSERT_EQ(1u, wasted.size());
+    EXPECT_EQ(GetInternals(b).GetNodeId(), wasted[0].nodeId);
+
+    g.ResetNodeStats();
+
+    for (const auto& s : g.GetNodeStats())
+        EXPECT_EQ(0u, s.updateCount);
+}
+
+TEST(StateTest, GraphExport)
+{
+    Group g;
+
+    auto a = StateVar<int>::Create(g, 1);
+    auto b = State<int>::Create([] (int v) { return v + 1; }, a);
+    auto c = State<int>::Create([] (int v1, int v2) { return v1 + v2; }, a, b);
+    auto obs = Observer::Create([] (int) { }, c);
+
+    a.SetDebugName("a");
+    b.SetDebugName("b \"quoted\"");
+    obs.SetDebugName("obs");
+
+    auto nodes = g.GetNodes();
+    ASSERT_EQ(4u, nodes.size());
+
+    auto findNode = [&] (size_t nodeId)
+        {
+            return *std::find_if(nodes.begin(), nodes.end(), [=] (const GraphNodeInfo& n) { return n.nodeId == nodeId; });
+        };
+
+    GraphNodeInfo aInfo = findNode(GetInternals(a).GetNodeId());
+    GraphNodeInfo cInfo = findNode(GetInternals(c).GetNodeId());
+
+    EXPECT_EQ("a", aInfo.debugName);
+    EXPECT_STREQ("input", aInfo.category);
+    EXPECT_EQ(0, aInfo.level);
+    EXPECT_EQ(2u, aInfo.successors.size());
+
+    EXPECT_TRUE(cInfo.debugName.empty());
+    EXPECT_EQ(2, cInfo.level);
+    EXPECT_EQ(1u, cInfo.successors.size());
+    EXPECT_EQ(cInfo.nodeId, cInfo.stats.nodeId);
+
+    // Type names are demangled.
+    EXPECT_NE(std::string::npos, std::string(aInfo.typeName).find("react::impl::StateVarNode<int>"));
+
+    std::ostringstream dot;
+    g.WriteDot(dot);
+
+    std::string edge = "n" + std::to_string(GetInternals(a).GetNodeId()) + " -> n" + std::to_string(GetInternals(c).GetNodeId()) + ";";
+
+    EXPECT_EQ(0u, dot.str().find("digraph group {"));
+    EXPECT_NE(std::string::npos, dot.str().find(edge));
+    EXPECT_NE(std::string::npos, dot.str().find("b \\\"quoted\\\""));
+
+    std::ostringstream json;
+    g.WriteJson(json);
+
+    EXPECT_EQ(0u, json.str().find("{\"nodes\":["));
+    EXPECT_NE(std::string::npos, json.str().find("\"name\":\"obs\""));
+    EXPECT_NE(std::string::npos, json.str().find("\"category\":\"output\""));
+    EXPECT_NE(std::string::npos, json.str().find("react::impl::StateVarNode<int>\","));
+}
+
+TEST(StateTest, MemoryUsage)
+{
+    Group g;
+
+    auto a = StateVar<int>::Create(g, 1);
+    auto b = State<int>::Create([] (int v) { return v + 1; }, a);
+    auto c = State<int>::Create([] (int v1, int v2) { return v1 + v2; }, a, b);
+    auto obs = Observer::Create([] (int) { }, c);
+
+    auto src = EventSource<int>::Create(g);
+
+    g.DoTransaction([&]
+        {
+            for (int i = 0; i < 100; ++i)
+                src.Emit(i);
+        });
+
+    GraphMemoryUsage usage = g.GetMemoryUsage();
+
+    EXPECT_EQ(5u, usage.nodeCount);
+    EXPECT_GE(usage.nodeDataBytes, usage.nodeDataSlackBytes);
+    EXPECT_GT(usage.nodeDataSlackBytes, 0u);
+
+    auto findCategory = [&] (const char* category)
+        {
+            return std::find_if(usage.categories.begin(), usage.categories.end(), [=] (const NodeMemoryUsage& u) { return std::string(u.category) == category; });
+        };
+
+    auto input = findCategory("input");
+    ASSERT_NE(usage.categories.end(), input);
+    EXPECT_EQ(2u, input->nodeCount);
+    EXPECT_STREQ("", input->typeName);
+
+    // The event source keeps the capacity of its buffer after the turn.
+    EXPECT_GE(input->bufferBytes, 100 * sizeof(int));
+    EXPECT_GE(input->successorBytes, 2 * sizeof(size_t));
+
+    auto normal = findCategory("normal");
+    ASSERT_NE(usage.categories.end(), normal);
+    EXPECT_EQ(2u, normal->nodeCount);
+    EXPECT_GT(normal->objectBytes, 2 * sizeof(int));
+
+    ASSERT_EQ(5u, usage.types.size());
+
+    size_t total = usage.nodeDataBytes;
+
+    for (size_t i = 0; i < usage.types.size(); ++i)
+    {
+        EXPECT_EQ(1u, usage.types[i].nodeCount);
+        EXPECT_GT(usage.types[i].objectBytes, 0u);
+
+        if (i > 0)
+        {
+            EXPECT_GE(usage.types[i - 1].GetTotalBytes(), usage.types[i].GetTotalBytes());
+        }
+
+        total += usage.types[i].GetTotalBytes();
+    }
+
+    EXPECT_EQ(total, usage.GetTotalBytes());
+
+    // Object sizes include the control block of the shared_ptr.
+    auto stateVar = std::find_if(usage.types.begin(), usage.types.end(), [] (const NodeMemoryUsage& u)
+        { return std::string(u.typeName).find("StateVarNode<int>") != std::string::npos; });
+
+    ASSERT_NE(usage.types.end(), stateVar);
+    EXPECT_GT(stateVar->objectBytes, sizeof(REACT_IMPL::StateVarNode<int>));
+}
+
+TEST(StateTest, GroupLifetime)
+{
+    StateVar<int> a;
+    State<int> b;
+
+    {
+        Group g;
+
+        a = StateVar<int>::Create(g, 1);
+        b = State<int>::Create([] (int v) { return v * 2; }, a);
+    }
+
+    // The graph is kept alive by its nodes.
+    Group g = b.GetGroup();
+
+    EXPECT_TRUE(g == a.GetGroup());
+
+    // Handles return the same cached group.
+    auto& groupRef = b.GetGroup();
+    EXPECT_EQ(&groupRef, &a.GetGroup());
+
+    int result = 0;
+
+    auto obs = Observer::Create([&] (int v) { result = v; }, b);
+
+    g.DoTransaction([&] { a.Set(10); });
+
+    EXPECT_EQ(20, result);
+    EXPECT_EQ(3u, g.GetMemoryUsage().nodeCount);
+}
+
+TEST(StateTest, Teardown)
+{
+    Group g;
+
+    {
+        auto in = StateVar<int>::Create(g, 1);
+
+        std::vector<State<int>> nodes;
+        for (int i = 0; i < 1000; ++i)
+            nodes.push_back(State<int>::Create([i] (int v) { return v + i; }, in));
+
+        auto slot = StateSlot<int>::Create(g, nodes[0]);
+        std::vector<Observer> observers;
+        observers.push_back(Observer::Create([] (int) { }, slot));
+
+        in.SetDebugName("in");
+
+        EXPECT_EQ(1004u, g.GetMemoryUsage().nodeCount);
+
+        TeardownScope teardown{ g };
+
+        observers.clear();
+        slot = StateSlot<int>();
+        nodes.clear();
+        in = StateVar<int>();
+    }
+
+    GraphMemoryUsage usage = g.GetMemoryUsage();
+
+    EXPECT_EQ(0u, usage.nodeCount);
+    EXPECT_EQ(0u, usage.nodeDataBytes);
+
+    // The group can be used again.
+    auto a = StateVar<int>::Create(g, 1);
+    auto b = State<int>::Create([] (int v) { return v * 2; }, a);
+
+    int result = 0;
+    auto obs = Observer::Create([&] (int v) { result = v; }, b);
+
+    a.Set(21);
+
+    EXPECT_EQ(42, result);
+    EXPECT_EQ(3u, g.GetMemoryUsage().nodeCount);
+
+    std::ostringstream dot;
+    g.WriteDot(dot);
+
+    // Labels start with the debug name, or with the node id if there is none.
+    EXPECT_EQ(std::string::npos, dot.str().find("label=\"in\\n"));
+    EXPECT_NE(std::string::npos, dot.str().find("label=\"#"));
+}
+
+TEST(StateTest, TeardownSurvivors)
+{
+    Group g;
+
+    auto in = StateVar<int>::Create(g, 1);
+    in.SetDebugName("in");
+
+    auto kept = State<int>::Create([] (int v) { return v + 1; }, in);
+
+    int result = 0;
+    auto obs = Observer::Create([&] (int v) { result = v; }, kept);
+
+    {
+        std::vector<State<int>> nodes;
+        for (int i = 0; i < 100; ++i)
+            nodes.push_back(State<int>::Create([i] (int v) { return v + i; }, in));
+
+        EXPECT_EQ(103u, g.GetMemoryUsage().nodeCount);
+
+        TeardownScope teardown{ g };
+        nodes.clear();
+    }
+
+    EXPECT_EQ(3u, g.GetMemoryUsage().nodeCount);
+
+    // The survivors were detached from the destroyed nodes.
+    for (const GraphNodeInfo& info : g.GetNodes())
+        EXPECT_LE(info.successors.size(), 1u);
+
+    in.Set(10);
+
+    EXPECT_EQ(11, result);
+
+    std::ostringstream dot;
+    g.WriteDot(dot);
+
+    EXPECT_NE(std::string::npos, dot.str().find("label=\"in\\n"));
+}
@@ -0,0 +1,87 @@
+//          Copyright Sebastian Jeckel 2017.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef REACT_TESTS_TEST_HELPERS_H_INCLUDED
+#define REACT_TESTS_TEST_HELPERS_H_INCLUDED
+
+#pragma once
+
+#include <condition_variable>
+#include <mutex>
+
+#include "react/group.h"
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/// Signal
+/// A one-shot event. Wait blocks until Set has been called.
+///////////////////////////////////////////////////////////////////////////////////////////////////
+class Signal
+{
+public:
+    void Set()
+    {
+        std::lock_guard<std::mutex> scopedLock(mutex_);
+        isSet_ = true;
+        condition_.notify_all();
+    }
+
+    void Wait()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        condition_.wait(lock, [this] { return isSet_; });
+    }
+
+    bool IsSet()
+    {
+        std::lock_guard<std::mutex> scopedLock(mutex_);
+        return isSet_;
+    }
+
+private:
+    std::mutex              mutex_;
+    std::condition_variable condition_;
+    bool                    isSet_ = false;
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+/// QueueBlocker
+/// Holds the worker of a group inside an enqueued transaction, so transactions that are enqueued
+/// meanwhile wait in the queue. The constructor returns once the worker has entered the transaction.
+/// Release lets the worker continue and returns once it has left the transaction.
+///////////////////////////////////////////////////////////////////////////////////////////////////
+class QueueBlocker
+{
+public:
+    explicit QueueBlocker(react::Group group, react::TransactionFlags flags = react::TransactionFlags::none)
+    {
+        group.EnqueueTransaction([this]
+            {
+                entered_.Set();
+                released_.Wait();
+                exited_.Set();
+            }, flags);
+
+        entered_.Wait();
+    }
+
+    QueueBlocker(const QueueBlocker&) = delete;
+    QueueBlocker& operator=(const QueueBlocker&) = delete;
+
+    ~QueueBlocker()
+        { Release(); }
+
+    void Release()
+    {
+        released_.Set();
+        exited_.Wait();
+    }
+
+private:
+    Signal entered_;
+    Signal released_;
+    Signal exited_;
+};
+
+#endif // REACT_TESTS_TEST_HELPERS_H_INCLUDED
@@ -9,9 +9,17 @@
 #include "react/state.h"
 #include "react/event.h"
 #include "react/observer.h"
+#include "react/common/tracing.h"
 
+#include "test_helpers.h"
+
+#include <algorithm>
+#include <atomic>
+#include <sstream>
+#include <string>
 #include <thread>
 #include <chrono>
+#include <vector>
 
 using namespace react;
 
@@ -218,4 +226,414 @@ TEST(TransactionTest, LinkedSyncMerging)
 
     EXPECT_EQ(10, output1);
     EXPECT_EQ(10, output2);
-}
\ No newline at end of file
+}
+
+TEST(TransactionTest, LinkedSyncCoalescing)
+{
+    Group g1;
+    Group g2;
+
+    auto src = StateVar<int>::Create(g1, 0);
+    auto lnk = StateLink<int>::Create(g2, src);
+
+    std::atomic<int> output{ -1 };
+
+    auto obs = Observer::Create([&] (int v) { output = v; }, lnk);
+
+    // Hold g2, so the transfer of the first change stays pending.
+    QueueBlocker blocker(g2);
+
+    g1.EnqueueTransaction(with_status, [&] { src.Set(1); }).Wait();
+
+    // This change is coalesced into the pending transfer, which is queued in the normal lane of g2.
+    // Linked transactions of this one go to the high lane.
+    TransactionStatus status = g1.EnqueueTransaction(with_status, [&] { src.Set(2); },
+        TransactionFlags::sync_linked | TransactionFlags::priority_high);
+
+    // Once this is done, g1 has forwarded everything of the previous transaction.
+    g1.EnqueueTransaction(with_status, [] { }).Wait();
+
+    // Holds g2 before the pending transfer, but after anything g1 queued in the high lane.
+    Signal gateEntered;
+    Signal gateReleased;
+
+    g2.EnqueueTransaction([&]
+        {
+            gateEntered.Set();
+            gateReleased.Wait();
+        }, TransactionFlags::priority_high);
+
+    blocker.Release();
+    gateEntered.Wait();
+
+    EXPECT_FALSE(status.IsDone());
+
+    gateReleased.Set();
+    status.Wait();
+
+    // Done only after the pending transfer has been applied.
+    EXPECT_EQ(2, output);
+}
+
+TEST(TransactionTest, Status)
+{
+    Group g;
+
+    auto evt = EventSource<int>::Create(g);
+
+    int output = 0;
+
+    auto obs = Observer::Create([&] (const auto& events)
+        {
+            for (int e : events)
+                output += e;
+        }, evt);
+
+    Signal start;
+
+    TransactionStatus status = g.EnqueueTransaction(with_status, [&]
+        {
+            start.Wait();
+
+            evt.Emit(1);
+            evt.Emit(2);
+        });
+
+    std::atomic<int> continuationCount{ 0 };
+    Signal continued;
+
+    status.Then([&]
+        {
+            ++continuationCount;
+            continued.Set();
+        });
+
+    EXPECT_FALSE(status.IsDone());
+    EXPECT_EQ(0, continuationCount);
+
+    start.Set();
+
+    status.Wait();
+
+    EXPECT_TRUE(status.IsDone());
+    EXPECT_EQ(3, output);
+
+    // The continuation is called by the worker, possibly after Wait returned.
+    continued.Wait();
+
+    EXPECT_EQ(1, continuationCount);
+
+    // Continuations of completed transactions are called immediately.
+    status.Then([&] { ++continuationCount; });
+    EXPECT_EQ(2, continuationCount);
+}
+
+TEST(TransactionTest, ContinuationInput)
+{
+    Group g;
+
+    auto a = StateVar<int>::Create(g, 0);
+    auto b = State<int>::Create([] (int v) { return v * 2; }, a);
+
+    std::atomic<int> output{ 0 };
+
+    auto obs = Observer::Create([&] (int v) { output = v; }, b);
+
+    TransactionStatus status;
+    Signal continued;
+
+    {
+        QueueBlocker blocker(g);
+
+        status = g.EnqueueTransaction(with_status, [&] { a.Set(1); });
+
+        // Called by the worker once the turn is complete, so it can start a new one on the same group.
+        status.Then([&]
+            {
+                a.Set(2);
+                continued.Set();
+            });
+    }
+
+    continued.Wait();
+
+    EXPECT_TRUE(status.IsDone());
+    EXPECT_EQ(4, output);
+}
+
+TEST(TransactionTest, QueueCapacity)
+{
+    Group g;
+
+    auto evt = EventSource<int>::Create(g);
+
+    int output = 0;
+
+    auto obs = Observer::Create([&] (const auto& events)
+        {
+            for (int e : events)
+                output += e;
+        }, evt);
+
+    // Fail.
+    g.SetTransactionQueueCapacity(2, QueueOverflowPolicy::fail);
+
+    QueueBlocker blocker1(g);
+
+    SyncPoint sp1;
+
+    EXPECT_TRUE(g.EnqueueTransaction([&] { evt << 1; }, sp1));
+    EXPECT_TRUE(g.EnqueueTransaction([&] { evt << 2; }, sp1));
+    EXPECT_FALSE(g.EnqueueTransaction([&] { evt << 4; }, sp1));
+
+    TransactionStatus status = g.EnqueueTransaction(with_status, [&] { evt << 8; });
+    EXPECT_TRUE(status.IsRejected());
+    EXPECT_TRUE(status.IsDone());
+
+    TransactionQueueStats stats = g.GetTransactionQueueStats();
+    EXPECT_EQ(2, stats.depth);
+    EXPECT_EQ(2, stats.rejectedCount);
+    EXPECT_EQ(0, stats.droppedCount);
+
+    blocker1.Release();
+    EXPECT_TRUE(sp1.WaitFor(std::chrono::seconds(3)));
+
+    EXPECT_EQ(3, output);
+
+    // Drop oldest mergeable.
+    output = 0;
+    g.SetTransactionQueueCapacity(2, QueueOverflowPolicy::drop_oldest_mergeable);
+
+    QueueBlocker blocker2(g);
+
+    SyncPoint sp2;
+
+    TransactionStatus droppedStatus = g.EnqueueTransaction(with_status, [&] { evt << 1; }, TransactionFlags::allow_merging);
+    EXPECT_TRUE(g.EnqueueTransaction([&] { evt << 2; }, sp2));
+    EXPECT_FALSE(droppedStatus.IsDone());
+    EXPECT_FALSE(droppedStatus.IsDropped());
+
+    TransactionStatus keptStatus = g.EnqueueTransaction(with_status, [&] { evt << 4; });
+    EXPECT_FALSE(g.EnqueueTransaction([&] { evt << 8; }, sp2));
+
+    // The dropped transaction is done without having run.
+    EXPECT_TRUE(droppedStatus.IsDone());
+    EXPECT_TRUE(droppedStatus.IsDropped());
+    EXPECT_FALSE(droppedStatus.IsRejected());
+    EXPECT_FALSE(keptStatus.IsDropped());
+
+    stats = g.GetTransactionQueueStats();
+    EXPECT_EQ(2, stats.depth);
+    EXPECT_EQ(3, stats.rejectedCount);
+    EXPECT_EQ(1, stats.droppedCount);
+
+    blocker2.Release();
+    EXPECT_TRUE(sp2.WaitFor(std::chrono::seconds(3)));
+    keptStatus.Wait();
+
+    EXPECT_FALSE(keptStatus.IsDropped());
+    EXPECT_EQ(6, output);
+
+    // Block.
+    output = 0;
+    g.SetTransactionQueueCapacity(1, QueueOverflowPolicy::block);
+
+    QueueBlocker blocker3(g);
+
+    SyncPoint sp3;
+
+    EXPECT_TRUE(g.EnqueueTransaction([&] { evt << 1; }, sp3));
+
+    std::atomic<bool> isProducerDone{ false };
+
+    std::thread producer([&]
+        {
+            g.EnqueueTransaction([&] { evt << 2; }, sp3);
+            isProducerDone = true;
+        });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    EXPECT_FALSE(isProducerDone);
+
+    blocker3.Release();
+    producer.join();
+
+    EXPECT_TRUE(isProducerDone);
+    EXPECT_TRUE(sp3.WaitFor(std::chrono::seconds(3)));
+
+    EXPECT_EQ(3, output);
+
+    // Block from the worker. It can't wait for itself, so its transactions exceed the capacity.
+    output = 0;
+
+    SyncPoint sp4;
+
+    g.EnqueueTransaction([&]
+        {
+            evt << 1;
+
+            g.EnqueueTransaction([&] { evt << 2; }, sp4);
+            g.EnqueueTransaction([&] { evt << 4; }, sp4);
+        }, sp4);
+
+    EXPECT_TRUE(sp4.WaitFor(std::chrono::seconds(3)));
+
+    EXPECT_EQ(7, output);
+}
+
+TEST(TransactionTest, PriorityLanes)
+{
+    Group g;
+
+    auto evt = EventSource<int>::Create(g);
+
+    std::vector<int> turnSums;
+
+    auto obs = Observer::Create([&] (const auto& events)
+        {
+            int sum = 0;
+            for (int e : events)
+                sum += e;
+            turnSums.push_back(sum);
+        }, evt);
+
+    // Higher lanes go first.
+    QueueBlocker blocker1(g);
+
+    SyncPoint sp1;
+
+    g.EnqueueTransaction([&] { evt << 1; }, sp1, TransactionFlags::priority_low);
+    g.EnqueueTransaction([&] { evt << 2; }, sp1);
+    g.EnqueueTransaction([&] { evt << 3; }, sp1, TransactionFlags::priority_high);
+
+    blocker1.Release();
+    EXPECT_TRUE(sp1.WaitFor(std::chrono::seconds(3)));
+
+    EXPECT_EQ(std::vector<int>({ 3, 2, 1 }), turnSums);
+
+    // Merging only within the same lane.
+    turnSums.clear();
+    QueueBlocker blocker2(g);
+
+    SyncPoint sp2;
+
+    g.EnqueueTransaction([&] { evt << 1; }, sp2, TransactionFlags::allow_merging);
+    g.EnqueueTransaction([&] { evt << 2; }, sp2, TransactionFlags::allow_merging | TransactionFlags::priority_high);
+    g.EnqueueTransaction([&] { evt << 4; }, sp2, TransactionFlags::allow_merging);
+    g.EnqueueTransaction([&] { evt << 8; }, sp2, TransactionFlags::allow_merging | TransactionFlags::priority_high);
+
+    blocker2.Release();
+    EXPECT_TRUE(sp2.WaitFor(std::chrono::seconds(3)));
+
+    EXPECT_EQ(std::vector<int>({ 10, 5 }), turnSums);
+
+    // Low priority transactions are not starved.
+    turnSums.clear();
+    QueueBlocker blocker3(g);
+
+    SyncPoint sp3;
+
+    g.EnqueueTransaction([&] { evt << 1000; }, sp3, TransactionFlags::priority_low);
+
+    for (int i = 0; i < 100; ++i)
+        g.EnqueueTransaction([&] { evt << 1; }, sp3, TransactionFlags::priority_high);
+
+    blocker3.Release();
+    EXPECT_TRUE(sp3.WaitFor(std::chrono::seconds(3)));
+
+    auto it = std::find(turnSums.begin(), turnSums.end(), 1000);
+
+    EXPECT_EQ(101, turnSums.size());
+    EXPECT_LT(std::distance(turnSums.begin(), it), 50);
+}
+
+TEST(TransactionTest, Tracing)
+{
+    Group g;
+
+    auto a = StateVar<int>::Create(g, 1);
+    auto b = State<int>::Create([] (int v) { return v * 2; }, a);
+
+    ClearTrace();
+
+    a.Set(2);
+
+    SyncPoint sp;
+    g.EnqueueTransaction([&] { a.Set(3); }, sp);
+    sp.Wait();
+
+    // The batch span is recorded after the transaction is complete.
+    std::string trace;
+
+    for (int i = 0; i < 100; ++i)
+    {
+        std::ostringstream out;
+        WriteChromeTrace(out);
+        trace = out.str();
+
+        if (!is_tracing_enabled || trace.find("\"cat\":\"batch\"") != std::string::npos)
+            break;
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    EXPECT_EQ(0u, trace.find("{\"traceEvents\":["));
+
+    if (is_tracing_enabled)
+    {
+        EXPECT_NE(std::string::npos, trace.find("\"cat\":\"batch\""));
+        EXPECT_NE(std::string::npos, trace.find("\"cat\":\"turn\""));
+        EXPECT_NE(std::string::npos, trace.find("\"cat\":\"level\""));
+        EXPECT_NE(std::string::npos, trace.find("\"cat\":\"node\""));
+
+        // Node updates are named after the demangled node type.
+        EXPECT_NE(std::string::npos, trace.find("\"name\":\"react::impl::StateFuncNode<int"));
+    }
+    else
+    {
+        EXPECT_EQ(std::string::npos, trace.find("\"ph\""));
+    }
+}
+
+TEST(TransactionTest, NumaPlacement)
+{
+    EXPECT_GE(GetNumaNodeCount(), 1);
+
+    Group g;
+
+    EXPECT_EQ(-1, g.GetNumaNode());
+
+    auto in = StateVar<int>::Create(g, 0);
+
+    g.SetNumaNode(0);
+    EXPECT_EQ(0, g.GetNumaNode());
+
+    // Grows the node data after the placement.
+    std::vector<State<int>> nodes;
+    for (int i = 0; i < 1000; ++i)
+        nodes.push_back(State<int>::Create([i] (int v) { return v + i; }, in));
+
+    std::atomic<int> output{ 0 };
+
+    auto obs = Observer::Create([&] (int v) { output = v; }, nodes.back());
+
+    g.EnqueueTransaction(with_status, [&] { in.Set(1); }).Wait();
+    EXPECT_EQ(1000, output);
+
+    // Nodes that don't exist are ignored.
+    g.SetNumaNode(GetNumaNodeCount());
+
+    g.EnqueueTransaction(with_status, [&] { in.Set(2); }).Wait();
+    EXPECT_EQ(1001, output);
+
+    g.SetNumaNode(-1);
+    EXPECT_EQ(-1, g.GetNumaNode());
+
+    // A thread that is already bound to a node is left alone by nested scopes for the same node.
+    {
+        REACT_IMPL::NumaThreadScope outer( 0 );
+        REACT_IMPL::NumaThreadScope inner( 0 );
+
+        EXPECT_FALSE(inner.IsBound());
+    }
+}